@@ -1,9 +1,11 @@
 #include "../src/core/order_book.hpp"
+#include "../src/engine/imbalance_strategy.hpp"
 #include <x86intrin.h>
 #include <vector>
 #include <algorithm>
 #include <cstdio>
 #include <chrono>
+#include <random>
 
 // ---------------------------------------------------------------------------
 // TSC calibration
@@ -135,12 +137,323 @@ void bench_cancel(double ns) {
     print_stats("cancel", samples, ns);
 }
 
+// ---------------------------------------------------------------------------
+void bench_random_access(double ns) {
+    // N resting orders touched in shuffled order: the working set is the
+    // whole node pool, so this is where node size (not instruction count)
+    // decides the latency. modify-qty first, then cancel every order.
+    OrderBook ob(90, 110, N + 10);
+    for (size_t i = 0; i < N; ++i)
+        ob.applyUpdate({0, UpdateType::Add, (uint64_t)i, 100 + (int64_t)(i % 10), 10, OrderSide::Bid});
+
+    std::vector<uint64_t> order(N);
+    for (size_t i = 0; i < N; ++i) order[i] = i;
+    std::shuffle(order.begin(), order.end(), std::mt19937_64(1));
+
+    std::vector<uint64_t> samples(N);
+    for (size_t i = 0; i < N; ++i) {
+        const uint64_t id = order[i];
+        MarketUpdate u{0, UpdateType::Modify, id, 100 + (int64_t)(id % 10), 7, OrderSide::Bid};
+        uint64_t t0 = __rdtsc();
+        ob.applyUpdate(u);
+        uint64_t t1 = __rdtsc();
+        samples[i] = t1 - t0;
+    }
+    print_stats("modify-qty-rand", samples, ns);
+
+    std::shuffle(order.begin(), order.end(), std::mt19937_64(2));
+    for (size_t i = 0; i < N; ++i) {
+        MarketUpdate u{0, UpdateType::Cancel, order[i], 0, 0, OrderSide::Bid};
+        uint64_t t0 = __rdtsc();
+        ob.applyUpdate(u);
+        uint64_t t1 = __rdtsc();
+        samples[i] = t1 - t0;
+    }
+    print_stats("cancel-rand", samples, ns);
+}
+
+// ---------------------------------------------------------------------------
+void bench_cancel_at_touch_wide(double ns) {
+    // 64K-tick ladder with one bid every GAP ticks. Cancelling the touch
+    // forces the book to locate the next level GAP ticks lower; the order is
+    // re-added (not timed) so every sample sees the same book shape.
+    constexpr int64_t LADDER = 65'536;
+    constexpr int64_t GAP    = 512;
+    constexpr int64_t TOP    = LADDER - GAP;
+
+    OrderBook ob(0, LADDER - 1, LADDER / GAP + WARMUP + N + 10);
+    uint64_t next_id = 0;
+    for (int64_t p = 0; p <= TOP; p += GAP)
+        ob.applyUpdate({0, UpdateType::Add, next_id++, p, 10, OrderSide::Bid});
+
+    uint64_t top_id = next_id - 1;
+    auto cycle = [&](uint64_t& t0, uint64_t& t1) {
+        MarketUpdate u{0, UpdateType::Cancel, top_id, 0, 0, OrderSide::Bid};
+        t0 = __rdtsc();
+        ob.applyUpdate(u);
+        t1 = __rdtsc();
+        top_id = next_id++;
+        ob.applyUpdate({0, UpdateType::Add, top_id, TOP, 10, OrderSide::Bid});
+    };
+
+    uint64_t t0, t1;
+    for (size_t i = 0; i < WARMUP; ++i) cycle(t0, t1);
+
+    std::vector<uint64_t> samples(N);
+    for (size_t i = 0; i < N; ++i) {
+        cycle(t0, t1);
+        samples[i] = t1 - t0;
+    }
+    print_stats("cancel-touch-wide", samples, ns);
+}
+
+// ---------------------------------------------------------------------------
+// Trending instrument: the mid random-walks upward over the whole run while
+// orders are placed within +-64 ticks of it and cancelled FIFO. The dense
+// ladder must span every price the session touches; the sliding window only
+// covers WINDOW ticks around the mid. Same message stream for both.
+// ---------------------------------------------------------------------------
+static std::vector<MarketUpdate> make_drifting_stream(int64_t& lo, int64_t& hi) {
+    constexpr size_t  LIVE  = 2'000;
+    constexpr int64_t START = 1'000'000;
+
+    std::mt19937_64 rng(42);
+    std::vector<MarketUpdate> msgs;
+    msgs.reserve(WARMUP + N);
+
+    int64_t  mid = START;
+    uint64_t next_id = 0, oldest_id = 0;
+    lo = hi = START;
+    while (msgs.size() < WARMUP + N) {
+        if (rng() % 4 == 0) mid += (rng() % 10 < 6) ? 1 : -1;   // ~+0.05 tick/msg
+
+        if (next_id - oldest_id >= LIVE) {
+            msgs.push_back({0, UpdateType::Cancel, oldest_id++, 0, 0, OrderSide::Bid});
+            continue;
+        }
+        const bool    bid = rng() & 1;
+        const int64_t off = 1 + (int64_t)(rng() % 64);
+        const int64_t px  = bid ? mid - off : mid + off;
+        lo = std::min(lo, px);
+        hi = std::max(hi, px);
+        msgs.push_back({0, UpdateType::Add, next_id++, px, 10,
+                        bid ? OrderSide::Bid : OrderSide::Ask});
+    }
+    return msgs;
+}
+
+static void run_stream(const char* name, OrderBook& ob,
+                       const std::vector<MarketUpdate>& msgs, double ns)
+{
+    for (size_t i = 0; i < WARMUP; ++i) ob.applyUpdate(msgs[i]);
+
+    std::vector<uint64_t> samples(N);
+    for (size_t i = 0; i < N; ++i) {
+        const MarketUpdate& u = msgs[WARMUP + i];
+        uint64_t t0 = __rdtsc();
+        ob.applyUpdate(u);
+        uint64_t t1 = __rdtsc();
+        samples[i] = t1 - t0;
+    }
+    print_stats(name, samples, ns);
+}
+
+void bench_drifting_ladder(double ns) {
+    constexpr size_t WINDOW = 4'096;
+
+    int64_t lo, hi;
+    std::vector<MarketUpdate> msgs = make_drifting_stream(lo, hi);
+    const size_t max_orders = msgs.size() + 10;   // dense id space
+
+    const size_t dense_levels = (size_t)(hi - lo + 1);
+    {
+        OrderBook ob(lo, hi, max_orders);
+        run_stream("drift-dense", ob, msgs, ns);
+    }
+    {
+        OrderBook ob(SlidingWindow{msgs[0].price, WINDOW}, max_orders);
+        run_stream("drift-window", ob, msgs, ns);
+        printf("  window evicted %llu orders\n", (unsigned long long)ob.evictedOrders());
+    }
+    printf("  ladder memory: dense %zu ticks = %.1f MB, window %zu ticks = %.1f MB\n",
+           dense_levels, 2.0 * dense_levels * sizeof(PriceLevel) / 1e6,
+           WINDOW,       2.0 * WINDOW       * sizeof(PriceLevel) / 1e6);
+}
+
+// ---------------------------------------------------------------------------
+// Order-ID index: steady book of LIVE resting orders, add-new / cancel-oldest
+// churn. Sequential IDs run through both the dense vector and the hash map;
+// the sparse stream mimics exchange IDs (8 gateways interleaved, each with
+// its own 16-bit prefix, a session tag and a gapped per-gateway sequence) and can only run
+// hashed.
+// ---------------------------------------------------------------------------
+static std::vector<MarketUpdate> make_id_stream(bool sparse) {
+    constexpr size_t LIVE = 100'000;
+
+    std::mt19937_64 rng(7);
+    std::vector<uint64_t> ids;
+    ids.reserve(LIVE + WARMUP + N);
+    uint64_t seq[8] = {};
+    for (size_t i = 0; i < LIVE + WARMUP + N; ++i) {
+        if (!sparse) { ids.push_back(i); continue; }
+        const uint64_t gw = rng() % 8;
+        seq[gw] += 1 + rng() % 16;
+        ids.push_back(((0xA000ull + gw) << 48) | (0x0117ull << 32) | seq[gw]);
+    }
+
+    std::vector<MarketUpdate> msgs;
+    msgs.reserve(LIVE + WARMUP + N);
+    size_t next = 0, oldest = 0;
+    for (; next < LIVE; ++next)
+        msgs.push_back({0, UpdateType::Add, ids[next], 100 + (int64_t)(next % 10), 10, OrderSide::Bid});
+    while (msgs.size() < LIVE + WARMUP + N) {
+        if (msgs.size() & 1)
+            msgs.push_back({0, UpdateType::Cancel, ids[oldest++], 0, 0, OrderSide::Bid});
+        else {
+            msgs.push_back({0, UpdateType::Add, ids[next], 100 + (int64_t)(next % 10), 10, OrderSide::Bid});
+            ++next;
+        }
+    }
+    return msgs;
+}
+
+static void run_id_stream(const char* name, OrderBook& ob,
+                          const std::vector<MarketUpdate>& msgs, double ns)
+{
+    const size_t skip = msgs.size() - WARMUP - N;   // initial book build
+    for (size_t i = 0; i < skip; ++i) ob.applyUpdate(msgs[i]);
+    std::vector<MarketUpdate> tail(msgs.begin() + skip, msgs.end());
+    run_stream(name, ob, tail, ns);
+}
+
+void bench_order_ids(double ns) {
+    const std::vector<MarketUpdate> seq    = make_id_stream(false);
+    const std::vector<MarketUpdate> sparse = make_id_stream(true);
+    const size_t max_orders = seq.size() + 10;     // dense needs the whole ID range
+
+    {
+        OrderBook ob(90, 110, max_orders, OrderIdIndex::Dense);
+        run_id_stream("ids-dense-vector", ob, seq, ns);
+    }
+    {
+        OrderBook ob(90, 110, 200'000, OrderIdIndex::Hashed);
+        run_id_stream("ids-hashed-seq", ob, seq, ns);
+    }
+    {
+        OrderBook ob(90, 110, 200'000, OrderIdIndex::Hashed);
+        run_id_stream("ids-hashed-sparse", ob, sparse, ns);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// getDepth: top-N bids into SoA buffers. Dense book has an order on every
+// tick; sparse book has one level every 37 ticks over a 16K-tick ladder.
+// ---------------------------------------------------------------------------
+static void run_depth(const char* name, const OrderBook& ob, size_t depth, double ns) {
+    int64_t px[32], qty[32];
+    for (size_t i = 0; i < WARMUP; ++i) (void)ob.getDepth(OrderSide::Bid, depth, px, qty);
+
+    std::vector<uint64_t> samples(N);
+    size_t sink = 0;
+    for (size_t i = 0; i < N; ++i) {
+        uint64_t t0 = __rdtsc();
+        sink += ob.getDepth(OrderSide::Bid, depth, px, qty);
+        uint64_t t1 = __rdtsc();
+        samples[i] = t1 - t0;
+    }
+    if (sink != N * depth) printf("  (%s: book shallower than %zu levels)\n", name, depth);
+    print_stats(name, samples, ns);
+}
+
+void bench_depth(double ns) {
+    OrderBook dense(90, 110, 1'000);
+    for (int64_t p = 90; p <= 110; ++p)
+        dense.applyUpdate({0, UpdateType::Add, (uint64_t)(p - 90), p, 10, OrderSide::Bid});
+
+    OrderBook sparse(0, 16'383, 1'000);
+    for (int64_t p = 16'383, id = 0; p >= 0; p -= 37)
+        sparse.applyUpdate({0, UpdateType::Add, (uint64_t)id++, p, 10, OrderSide::Bid});
+
+    run_depth("depth-dense-5",   dense,   5, ns);
+    run_depth("depth-dense-10",  dense,  10, ns);
+    run_depth("depth-dense-20",  dense,  20, ns);
+    run_depth("depth-sparse-5",  sparse,  5, ns);
+    run_depth("depth-sparse-10", sparse, 10, ns);
+    run_depth("depth-sparse-20", sparse, 20, ns);
+}
+
+// ---------------------------------------------------------------------------
+// Book update + ImbalanceStrategy tick, with and without the incremental
+// BookFeatures block. Stationary mid, orders placed within +-64 ticks, so
+// most updates land below the top of book.
+// ---------------------------------------------------------------------------
+static std::vector<MarketUpdate> make_stationary_stream() {
+    constexpr size_t  LIVE = 2'000;
+    constexpr int64_t MID  = 10'000;
+
+    std::mt19937_64 rng(7);
+    std::vector<MarketUpdate> msgs;
+    msgs.reserve(WARMUP + N);
+
+    uint64_t next_id = 0, oldest_id = 0;
+    while (msgs.size() < WARMUP + N) {
+        if (next_id - oldest_id >= LIVE) {
+            msgs.push_back({0, UpdateType::Cancel, oldest_id++, 0, 0, OrderSide::Bid});
+            continue;
+        }
+        const bool    bid = rng() & 1;
+        const int64_t off = 1 + (int64_t)(rng() % 64);
+        msgs.push_back({0, UpdateType::Add, next_id++, bid ? MID - off : MID + off,
+                        1 + (int32_t)(rng() % 20), bid ? OrderSide::Bid : OrderSide::Ask});
+    }
+    return msgs;
+}
+
+static void run_strategy(const char* name, OrderBook& ob,
+                         const std::vector<MarketUpdate>& msgs, double ns)
+{
+    ImbalanceStrategy strategy(ob);
+    for (size_t i = 0; i < WARMUP; ++i) {
+        ob.applyUpdate(msgs[i]);
+        strategy.on_market_update(msgs[i]);
+    }
+
+    std::vector<uint64_t> book_samples(N), strat_samples(N);
+    for (size_t i = 0; i < N; ++i) {
+        const MarketUpdate& u = msgs[WARMUP + i];
+        uint64_t t0 = __rdtsc();
+        ob.applyUpdate(u);
+        uint64_t t1 = __rdtsc();
+        strategy.on_market_update(u);
+        uint64_t t2 = __rdtsc();
+        book_samples[i]  = t1 - t0;
+        strat_samples[i] = t2 - t1;
+    }
+    char label[32];
+    snprintf(label, sizeof(label), "%s-book", name);
+    print_stats(label, book_samples, ns);
+    snprintf(label, sizeof(label), "%s-strat", name);
+    print_stats(label, strat_samples, ns);
+}
+
+void bench_features(double ns) {
+    const std::vector<MarketUpdate> msgs = make_stationary_stream();
+
+    OrderBook plain(9'900, 10'100, WARMUP + N);
+    run_strategy("feat-off", plain, msgs, ns);
+
+    OrderBook featured(9'900, 10'100, WARMUP + N);
+    featured.enableFeatures(5);
+    run_strategy("feat-on-5", featured, msgs, ns);
+}
+
 // ---------------------------------------------------------------------------
 int main() {
     printf("Calibrating TSC... ");
     fflush(stdout);
     double ns = calibrate_ns_per_cycle();
-    printf("%.3f ns/cycle  (%.2f GHz)\n\n", ns, 1.0 / ns);
+    printf("%.3f ns/cycle  (%.2f GHz)\n", ns, 1.0 / ns);
+    printf("Node layout: %s, %zu bytes/node\n\n", NodeStore::NAME, NodeStore::BYTES_PER_NODE);
 
     printf("%-18s  %-20s  %-21s  %-21s  %s\n",
            "benchmark", "p50", "p99", "p99.9", "max");
@@ -151,6 +464,12 @@ int main() {
     bench_insert(ns);
     bench_modify_qty(ns);
     bench_cancel(ns);
+    bench_random_access(ns);
+    bench_cancel_at_touch_wide(ns);
+    bench_drifting_ladder(ns);
+    bench_order_ids(ns);
+    bench_depth(ns);
+    bench_features(ns);
 
     return 0;
 }
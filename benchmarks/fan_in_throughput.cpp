@@ -0,0 +1,227 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/core/mpsc_ring.hpp"
+#include "../src/core/ring_buffer.hpp"
+#include "../src/feed/feed_handler.hpp"
+#include "../src/util/cpu_affinity.hpp"
+#include "../src/util/timer.hpp"
+
+// ---------------------------------------------------------------------------
+// fan_in_throughput — P decoder threads feeding one consumer thread.
+//
+//   fan_in_throughput [--msgs n] [--batch n] [--capacity n] [--max-producers n]
+//                     [--mode mpsc|spsc|both] [--cores c0 c1 ...]
+//
+// Each producer publishes synthetic updates through its own FeedHandler in
+// batches of `--batch`, stamping ts just before each onBatch. The consumer
+// drains in batches of 256 and records now - ts, so latency covers time
+// spent waiting for room in a full queue as well as in the queue.
+//
+//   mpsc: all producers share one MdFanInQueue (MpscRing).
+//   spsc: one SpscRing per producer, the consumer polls them round-robin.
+//
+// Sweeps P = 1 .. --max-producers; --cores pins the consumer to c0 and
+// producer i to c(i+1).
+// ---------------------------------------------------------------------------
+
+namespace {
+
+constexpr std::size_t CONSUME_BATCH = 256;
+constexpr std::size_t SAMPLE_EVERY  = 8;   // keep every 8th latency
+
+struct Options {
+    std::uint64_t              msgs          = 10'000'000;   // total, split across producers
+    std::size_t                batch         = 64;
+    std::size_t                capacity      = 1u << 20;   // as the feed path's MD queue
+    std::size_t                max_producers = 8;
+    bool                       mpsc          = true;
+    bool                       spsc          = true;
+    std::vector<std::uint32_t> cores;
+};
+
+struct RunResult {
+    double        seconds = 0.0;
+    std::uint64_t p50_ns  = 0;
+    std::uint64_t p99_ns  = 0;
+};
+
+void pin(const Options& opts, std::size_t slot) {
+    if (slot < opts.cores.size()) pin_thread_to_core(opts.cores[slot]);
+}
+
+void produce(FeedHandler& fh, std::uint64_t count, std::size_t batch_size) {
+    std::vector<MarketUpdate> batch(batch_size);
+    for (std::size_t i = 0; i < batch_size; ++i) {
+        batch[i]       = MarketUpdate{};
+        batch[i].type  = UpdateType::Add;
+        batch[i].price = 10000;
+        batch[i].qty   = 1;
+    }
+    std::uint64_t id = 1;
+    while (count != 0) {
+        const std::size_t n = static_cast<std::size_t>(std::min<std::uint64_t>(batch_size, count));
+        const std::uint64_t now = get_monotonic_ns();
+        for (std::size_t i = 0; i < n; ++i) {
+            batch[i].ts       = now;
+            batch[i].order_id = id++;
+        }
+        fh.onBatch(std::span<const MarketUpdate>(batch.data(), n));
+        count -= n;
+    }
+}
+
+// Calls `drain(sink)` until `total` items were passed to the sink; each call
+// hands it at most one batch.
+template <typename Drain>
+RunResult consume(std::uint64_t total, Drain&& drain) {
+    std::vector<std::uint64_t> lat;
+    lat.reserve(total / SAMPLE_EVERY + 1);
+    std::uint64_t seen = 0;
+    while (seen < total) {
+        drain([&](std::span<const MarketUpdate> run) {
+            const std::uint64_t now = get_monotonic_ns();
+            for (std::size_t i = 0; i < run.size(); ++i) {
+                if ((seen + i) % SAMPLE_EVERY == 0) lat.push_back(now - run[i].ts);
+            }
+            seen += run.size();
+        });
+    }
+    RunResult r;
+    if (!lat.empty()) {
+        auto at = [&](double q) {
+            auto it = lat.begin() + static_cast<std::ptrdiff_t>(q * (lat.size() - 1));
+            std::nth_element(lat.begin(), it, lat.end());
+            return *it;
+        };
+        r.p50_ns = at(0.50);
+        r.p99_ns = at(0.99);
+    }
+    return r;
+}
+
+RunResult run_mpsc(const Options& opts, std::size_t producers) {
+    MdFanInQueue queue(opts.capacity);
+    const std::uint64_t per = opts.msgs / producers;
+    const std::uint64_t total = per * producers;
+
+    const std::uint64_t t0 = get_monotonic_ns();
+    std::vector<std::thread> threads;
+    for (std::size_t p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p] {
+            pin(opts, p + 1);
+            FeedHandler fh(queue);
+            produce(fh, per, opts.batch);
+        });
+    }
+    pin(opts, 0);
+    RunResult r = consume(total, [&](auto&& sink) {
+        const std::span<const MarketUpdate> run = queue.peek(CONSUME_BATCH);
+        if (!run.empty()) {
+            sink(run);
+            queue.release(run.size());
+        }
+    });
+    const std::uint64_t t1 = get_monotonic_ns();
+    for (auto& t : threads) t.join();
+    r.seconds = (t1 - t0) / 1e9;
+    return r;
+}
+
+RunResult run_spsc(const Options& opts, std::size_t producers) {
+    std::vector<std::unique_ptr<MdQueue>> queues;
+    for (std::size_t p = 0; p < producers; ++p) {
+        queues.push_back(std::make_unique<MdQueue>(opts.capacity));
+    }
+    const std::uint64_t per = opts.msgs / producers;
+    const std::uint64_t total = per * producers;
+
+    const std::uint64_t t0 = get_monotonic_ns();
+    std::vector<std::thread> threads;
+    for (std::size_t p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p] {
+            pin(opts, p + 1);
+            FeedHandler fh(*queues[p]);
+            produce(fh, per, opts.batch);
+        });
+    }
+    pin(opts, 0);
+    std::size_t next = 0;
+    RunResult r = consume(total, [&](auto&& sink) {
+        MdQueue& q = *queues[next];
+        next = (next + 1 == producers) ? 0 : next + 1;
+        const std::span<const MarketUpdate> run = q.peek(CONSUME_BATCH);
+        if (!run.empty()) {
+            sink(run);
+            q.release(run.size());
+        }
+    });
+    const std::uint64_t t1 = get_monotonic_ns();
+    for (auto& t : threads) t.join();
+    r.seconds = (t1 - t0) / 1e9;
+    return r;
+}
+
+void print_row(const char* mode, std::size_t producers, std::uint64_t msgs, const RunResult& r) {
+    std::cout << std::left << std::setw(6) << mode << std::right
+              << std::setw(10) << producers
+              << std::setw(14) << std::fixed << std::setprecision(1) << msgs / r.seconds / 1e6
+              << std::setw(12) << r.p50_ns
+              << std::setw(12) << r.p99_ns << "\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opts;
+    for (int i = 1; i < argc; ++i) {
+        const bool more = i + 1 < argc;
+        if      (std::strcmp(argv[i], "--msgs") == 0 && more)          opts.msgs = std::strtoull(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--batch") == 0 && more)         opts.batch = std::strtoul(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--capacity") == 0 && more)      opts.capacity = std::strtoul(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--max-producers") == 0 && more) opts.max_producers = std::strtoul(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--mode") == 0 && more) {
+            const std::string m = argv[++i];
+            opts.mpsc = (m == "mpsc" || m == "both");
+            opts.spsc = (m == "spsc" || m == "both");
+        }
+        else if (std::strcmp(argv[i], "--cores") == 0) {
+            while (i + 1 < argc && argv[i + 1][0] != '-') {
+                opts.cores.push_back((std::uint32_t)std::strtoul(argv[++i], nullptr, 10));
+            }
+        }
+        else {
+            std::cerr << "Usage: fan_in_throughput [--msgs n] [--batch n] [--capacity n] "
+                         "[--max-producers n] [--mode mpsc|spsc|both] [--cores c0 c1 ...]\n";
+            return 1;
+        }
+    }
+    if (opts.batch == 0 || opts.max_producers == 0 || opts.msgs < opts.max_producers ||
+        opts.capacity == 0 || (opts.capacity & (opts.capacity - 1)) != 0) {
+        std::cerr << "need --batch >= 1, --max-producers >= 1, --msgs >= producers, "
+                     "--capacity a power of two\n";
+        return 1;
+    }
+
+    std::cout << "Messages      : " << opts.msgs << " (split across producers)\n"
+              << "Batch         : " << opts.batch << "\n"
+              << "Capacity      : " << opts.capacity << "\n"
+              << "HW threads    : " << std::thread::hardware_concurrency() << "\n\n"
+              << "mode   producers   M msgs/sec     p50 ns      p99 ns\n";
+    for (std::size_t p = 1; p <= opts.max_producers; ++p) {
+        const std::uint64_t total = opts.msgs / p * p;
+        if (opts.mpsc) print_row("mpsc", p, total, run_mpsc(opts, p));
+        if (opts.spsc) print_row("spsc", p, total, run_spsc(opts, p));
+    }
+    return 0;
+}
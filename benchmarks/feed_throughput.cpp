@@ -3,50 +3,401 @@
 #include <thread>
 #include <atomic>
 #include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <algorithm>
 #include <limits>
+#include <memory>
+#include <string>
+#include <vector>
 
 #include "../src/core/order_book.hpp"
 #include "../src/core/ring_buffer.hpp"
 #include "../src/feed/feed_handler.hpp"
+#include "../src/engine/broadcast_dispatcher.hpp"
+#include "../src/engine/imbalance_strategy.hpp"
+#include "../src/engine/shard_dispatcher.hpp"
+#include "../src/replay/feed_index.hpp"
+#include "../src/replay/merge_replay.hpp"
+#include "../src/replay/mmap_replay.hpp"
+#include "../src/replay/uring_replay.hpp"
 #include "../src/util/cpu_affinity.hpp"
+#include "../src/util/timer.hpp"
 
-// Forward-declare run_mmap_replay from mmap_replay.cpp
-std::uint64_t run_mmap_replay(FeedHandler& fh, const char* filename);
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 // Sentinel: no affinity requested for this thread.
 static constexpr std::uint32_t NO_AFFINITY = std::numeric_limits<std::uint32_t>::max();
 
-int main(int argc, char** argv) {
-    if (argc < 2) {
-        std::cerr << "Usage: feed_throughput <replay_file> [producer_core consumer_core]\n";
-        std::cerr << "  Omit core args to run without thread affinity (OS decides).\n";
+static void print_throughput(std::uint64_t num_produced, double seconds) {
+    if (seconds > 0.0 && num_produced > 0) {
+        double mps = (double)num_produced / seconds;
+        std::cout << "Elapsed       : " << seconds        << " s\n";
+        std::cout << "Throughput    : " << mps / 1e6      << " M msgs/sec\n";
+    } else {
+        std::cout << "No messages processed or zero elapsed time.\n";
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Multi-instrument mode: one producer, `num_shards` consumer threads, one
+// OrderBook per symbol in [0, num_symbols). Compare --shards 1 against
+// --shards N on the same file to see how throughput scales with cores.
+// argv: <file> --shards <n> <num_symbols> [producer_core consumer_core...]
+// ---------------------------------------------------------------------------
+static int run_sharded(int argc, char** argv) {
+    if (argc < 5) {
+        std::cerr << "Usage: feed_throughput <replay_file> --shards <n> <num_symbols> "
+                     "[producer_core consumer_core_0 ... consumer_core_n-1]\n";
+        return 1;
+    }
+    const char*        filename    = argv[1];
+    const std::size_t  num_shards  = std::strtoul(argv[3], nullptr, 10);
+    const std::size_t  num_symbols = std::strtoul(argv[4], nullptr, 10);
+    if (num_shards == 0 || num_symbols == 0 || num_symbols > 65536) {
+        std::cerr << "need n >= 1 and 1 <= num_symbols <= 65536\n";
+        return 1;
+    }
+
+    std::uint32_t              producer_core = NO_AFFINITY;
+    std::vector<std::uint32_t> consumer_cores;
+    if (argc >= 6) producer_core = (std::uint32_t)std::atoi(argv[5]);
+    for (int i = 6; i < argc; ++i) consumer_cores.push_back((std::uint32_t)std::atoi(argv[i]));
+
+    // Size each book for its share of the feed; IDs are global, so books
+    // use the hashed ID index.
+    std::error_code ec;
+    const std::uint64_t file_msgs = std::filesystem::file_size(filename, ec) / sizeof(MarketUpdate);
+    const std::size_t   per_book  = (std::size_t)(file_msgs / num_symbols / 2) + 1024;
+
+    constexpr std::size_t QUEUE_CAP = 1u << 20;
+    ShardDispatcher dispatcher(num_shards, QUEUE_CAP);
+    for (std::size_t sym = 0; sym < num_symbols; ++sym) {
+        // Price range must match generate_feed: price = 10000 ± 50
+        dispatcher.addBook((std::uint16_t)sym, 9900, 10100, per_book, OrderIdIndex::Hashed);
+    }
+
+    std::uint64_t num_produced = 0;
+    auto t0 = std::chrono::high_resolution_clock::now();
+
+    dispatcher.start(consumer_cores);
+    std::thread producer_thread([&] {
+        if (producer_core != NO_AFFINITY) pin_thread_to_core(producer_core);
+        num_produced = run_mmap_replay(dispatcher.feedHandler(), filename);
+    });
+    producer_thread.join();
+    dispatcher.finish();
+
+    auto t1 = std::chrono::high_resolution_clock::now();
+    double seconds = std::chrono::duration<double>(t1 - t0).count();
+
+    std::cout << "Shards        : " << num_shards  << "\n";
+    std::cout << "Symbols       : " << num_symbols << "\n";
+    std::cout << "Produced      : " << num_produced << " msgs\n";
+    for (std::size_t i = 0; i < num_shards; ++i) {
+        std::cout << "  shard " << i << "     : " << dispatcher.books(i).size() << " books, "
+                  << dispatcher.consumed(i) << " msgs\n";
+    }
+    std::cout << "Consumed      : " << dispatcher.consumed() << " msgs\n";
+    print_throughput(num_produced, seconds);
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Broadcast mode: one producer, `num_readers` reader threads that each run
+// their own OrderBook + ImbalanceStrategy over every update, off a single
+// decode of the feed. Compare against N separate single-reader runs.
+// argv: <file> --broadcast <n> [producer_core reader_core_0 ... reader_core_n-1]
+// ---------------------------------------------------------------------------
+static int run_broadcast(int argc, char** argv) {
+    if (argc < 4) {
+        std::cerr << "Usage: feed_throughput <replay_file> --broadcast <n> "
+                     "[producer_core reader_core_0 ... reader_core_n-1]\n";
+        return 1;
+    }
+    const char*       filename    = argv[1];
+    const std::size_t num_readers = std::strtoul(argv[3], nullptr, 10);
+    if (num_readers == 0) {
+        std::cerr << "need n >= 1\n";
+        return 1;
+    }
+
+    std::uint32_t              producer_core = NO_AFFINITY;
+    std::vector<std::uint32_t> reader_cores;
+    if (argc >= 5) producer_core = (std::uint32_t)std::atoi(argv[4]);
+    for (int i = 5; i < argc; ++i) reader_cores.push_back((std::uint32_t)std::atoi(argv[i]));
+
+    std::error_code ec;
+    const std::uint64_t file_msgs = std::filesystem::file_size(filename, ec) / sizeof(MarketUpdate);
+    const std::size_t   max_orders = (std::size_t)(file_msgs / 2) + 1024;
+
+    constexpr std::size_t QUEUE_CAP = 1u << 20;
+    BroadcastDispatcher dispatcher(num_readers, QUEUE_CAP);
+    std::vector<std::unique_ptr<OrderBook>>         books;
+    std::vector<std::unique_ptr<ImbalanceStrategy>> strategies;
+    for (std::size_t i = 0; i < num_readers; ++i) {
+        // Price range must match generate_feed: price = 10000 ± 50
+        books.push_back(std::make_unique<OrderBook>(9900, 10100, max_orders));
+        books.back()->enableFeatures(5);
+        // Same signal, different thresholds: one parameter set per reader.
+        strategies.push_back(std::make_unique<ImbalanceStrategy>(*books.back(), 0.1, 0.1 + 0.05 * i));
+        dispatcher.addReader(*books.back(), *strategies.back());
+    }
+
+    std::uint64_t num_produced = 0;
+    auto t0 = std::chrono::high_resolution_clock::now();
+
+    dispatcher.start(reader_cores);
+    std::thread producer_thread([&] {
+        if (producer_core != NO_AFFINITY) pin_thread_to_core(producer_core);
+        num_produced = run_mmap_replay(dispatcher.feedHandler(), filename);
+    });
+    producer_thread.join();
+    dispatcher.finish();
+
+    auto t1 = std::chrono::high_resolution_clock::now();
+    double seconds = std::chrono::duration<double>(t1 - t0).count();
+
+    std::cout << "Readers       : " << num_readers  << "\n";
+    std::cout << "Produced      : " << num_produced << " msgs\n";
+    for (std::size_t i = 0; i < num_readers; ++i) {
+        std::cout << "  reader " << i << "    : " << dispatcher.consumed(i) << " msgs, "
+                  << dispatcher.signals(i) << " signals\n";
+    }
+    print_throughput(num_produced, seconds);
+    if (seconds > 0.0) {
+        std::cout << "Deliveries    : " << (double)num_produced * num_readers / seconds / 1e6
+                  << " M msgs/sec (all readers)\n";
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// IPC mode: the replay and the book run in two processes joined by a
+// ShmRing, against the same two stages as two threads joined by an
+// SpscRing. The producer stamps each record's ts with the monotonic clock
+// (shared by all processes) just before publishing it; the consumer
+// applies it to an OrderBook and records now - ts for every 8th record.
+// argv: <file> --ipc [--huge-pages] [--hugetlbfs <dir>] [--populate]
+//       [producer_core consumer_core]
+// ---------------------------------------------------------------------------
+struct IpcResult {
+    std::uint64_t produced = 0;
+    std::uint64_t consumed = 0;
+    double        seconds  = 0.0;
+    std::uint64_t p50_ns   = 0;
+    std::uint64_t p99_ns   = 0;
+};
+
+// Replays `file` through `fh` with ts restamped at publish time.
+static std::uint64_t produce_stamped(FeedHandler& fh, const char* file) {
+    std::vector<MarketUpdate> batch;
+    return replay_feed_records(file, {}, std::numeric_limits<std::uint64_t>::max(),
+                               [&](std::span<const MarketUpdate> run) {
+                                   batch.assign(run.begin(), run.end());
+                                   const std::uint64_t now = get_monotonic_ns();
+                                   for (MarketUpdate& u : batch) u.ts = now;
+                                   fh.onBatch(batch);
+                                   return true;
+                               });
+}
+
+// Consumer loop shared by both variants: `peek`/`release` read the ring,
+// `done()` is checked once it looks empty.
+template <typename Ring, typename Done>
+static IpcResult consume_stamped(Ring& ring, OrderBook& ob, Done&& done) {
+    IpcResult r;
+    std::vector<std::uint64_t> lat;
+    lat.reserve(1u << 20);
+    auto drain = [&] {
+        const auto batch = ring.peek(256);
+        if (batch.empty()) return false;
+        const std::uint64_t now = get_monotonic_ns();
+        for (std::size_t i = 0; i < batch.size(); ++i) {
+            ob.applyUpdate(batch[i]);
+            if ((r.consumed + i) % 8 == 0) lat.push_back(now - batch[i].ts);
+        }
+        r.consumed += batch.size();
+        ring.release(batch.size());
+        return true;
+    };
+    while (true) {
+        if (drain()) continue;
+        if (done()) {
+            while (drain()) {}
+            break;
+        }
+    }
+    if (!lat.empty()) {
+        auto at = [&](double q) {
+            auto it = lat.begin() + static_cast<std::ptrdiff_t>(q * (lat.size() - 1));
+            std::nth_element(lat.begin(), it, lat.end());
+            return *it;
+        };
+        r.p50_ns = at(0.50);
+        r.p99_ns = at(0.99);
+    }
+    return r;
+}
+
+static void print_ipc(const char* title, const IpcResult& r) {
+    std::cout << "\n-- " << title << "\n";
+    std::cout << "Produced      : " << r.produced << " msgs\n";
+    std::cout << "Consumed      : " << r.consumed << " msgs\n";
+    print_throughput(r.produced, r.seconds);
+    std::cout << "Latency p50   : " << r.p50_ns << " ns\n";
+    std::cout << "Latency p99   : " << r.p99_ns << " ns\n";
+}
+
+static int run_ipc(int argc, char** argv) {
+#ifdef _WIN32
+    (void)argc; (void)argv;
+    std::cerr << "--ipc needs POSIX shared memory and fork\n";
+    return 1;
+#else
+    const char*                filename = argv[1];
+    ShmRingOptions             shm_opts;
+    std::vector<std::uint32_t> cores;
+    for (int i = 3; i < argc; ++i) {
+        if      (std::strcmp(argv[i], "--huge-pages") == 0) shm_opts.huge_pages = true;
+        else if (std::strcmp(argv[i], "--hugetlbfs") == 0 && i + 1 < argc) shm_opts.hugetlbfs_dir = argv[++i];
+        else if (std::strcmp(argv[i], "--populate") == 0)   shm_opts.populate = true;
+        else cores.push_back((std::uint32_t)std::atoi(argv[i]));
+    }
+    const std::uint32_t producer_core = cores.size() >= 2 ? cores[0] : NO_AFFINITY;
+    const std::uint32_t consumer_core = cores.size() >= 2 ? cores[1] : NO_AFFINITY;
+
+    constexpr std::size_t QUEUE_CAP = 1u << 20;
+    std::error_code ec;
+    const std::uint64_t file_msgs  = std::filesystem::file_size(filename, ec) / sizeof(MarketUpdate);
+    const std::size_t   max_orders = (std::size_t)(file_msgs / 2) + 1024;
+
+    // Threads over an SpscRing.
+    IpcResult threads;
+    {
+        MdQueue           queue(QUEUE_CAP);
+        FeedHandler       fh(queue);
+        std::atomic<bool> producer_done{false};
+        OrderBook         ob(9900, 10100, max_orders);
+        const std::uint64_t t0 = get_monotonic_ns();
+        std::thread producer_thread([&] {
+            if (producer_core != NO_AFFINITY) pin_thread_to_core(producer_core);
+            threads.produced = produce_stamped(fh, filename);
+            producer_done.store(true, std::memory_order_release);
+        });
+        if (consumer_core != NO_AFFINITY) pin_thread_to_core(consumer_core);
+        const IpcResult c = consume_stamped(queue, ob, [&] {
+            return producer_done.load(std::memory_order_acquire);
+        });
+        producer_thread.join();
+        threads.consumed = c.consumed;
+        threads.p50_ns   = c.p50_ns;
+        threads.p99_ns   = c.p99_ns;
+        threads.seconds  = (get_monotonic_ns() - t0) / 1e9;
+    }
+
+    // Processes over a ShmRing. The child is the consumer and reports
+    // back through a pipe.
+    const std::string name = "/feed_throughput_" + std::to_string(::getpid());
+    ShmRing ring = ShmRing::create(name.c_str(), QUEUE_CAP, shm_opts);
+    int fds[2];
+    if (!ring.ok() || ::pipe(fds) != 0) return 1;
+
+    const pid_t child = ::fork();
+    if (child == 0) {
+        ::close(fds[0]);
+        if (consumer_core != NO_AFFINITY) pin_thread_to_core(consumer_core);
+        OrderBook ob(9900, 10100, max_orders);
+        ShmRing in = ShmRing::attach(name.c_str(), ShmRing::Resume::Tail, shm_opts);
+        const bool attached = in.ok();
+        IpcResult c;
+        if (attached) {
+            c = consume_stamped(in, ob, [&] { return in.closed(); });
+            in.detach();
+        }
+        const bool sent = ::write(fds[1], &c, sizeof(c)) == (ssize_t)sizeof(c);
+        ::_exit(attached && sent ? 0 : 1);
+    }
+    ::close(fds[1]);
+    if (producer_core != NO_AFFINITY) pin_thread_to_core(producer_core);
+    // Wait for the consumer so the first records are not timed sitting in
+    // a ring nobody reads yet.
+    while (!ring.consumerAttached()) std::this_thread::yield();
+    const std::uint64_t t0 = get_monotonic_ns();
+    FeedHandler fh(ring);
+    IpcResult procs;
+    procs.produced = produce_stamped(fh, filename);
+    ring.close();
+    IpcResult c;
+    const bool got = ::read(fds[0], &c, sizeof(c)) == (ssize_t)sizeof(c);
+    int status = 0;
+    ::waitpid(child, &status, 0);
+    procs.seconds  = (get_monotonic_ns() - t0) / 1e9;
+    procs.consumed = c.consumed;
+    procs.p50_ns   = c.p50_ns;
+    procs.p99_ns   = c.p99_ns;
+    ::close(fds[0]);
+    if (!got || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        std::cerr << "consumer process failed\n";
         return 1;
     }
-    const char*    filename       = argv[1];
-    const bool     pin_threads    = (argc >= 4);
-    std::uint32_t  producer_core  = pin_threads ? (std::uint32_t)std::atoi(argv[2]) : NO_AFFINITY;
-    std::uint32_t  consumer_core  = pin_threads ? (std::uint32_t)std::atoi(argv[3]) : NO_AFFINITY;
 
+    std::cout << "Affinity      : " << (cores.size() >= 2 ? "pinned" : "none (OS schedules)") << "\n";
+    std::cout << "Shared memory : " << name
+              << (shm_opts.hugetlbfs_dir ? " on hugetlbfs" : "")
+              << " huge_pages=" << shm_opts.huge_pages
+              << " populate=" << shm_opts.populate << ", "
+              << ring.header().segment_bytes / (1024 * 1024) << " MiB\n";
+    print_ipc("threads, SpscRing", threads);
+    print_ipc("processes, ShmRing", procs);
+    return 0;
+#endif
+}
+
+// ---------------------------------------------------------------------------
+// Single-instrument pipeline: replay -> FeedHandler -> SPSC queue ->
+// OrderBook::applyUpdate on a second thread.
+// ---------------------------------------------------------------------------
+struct PipelineResult {
+    std::uint64_t produced = 0;
+    std::uint64_t consumed = 0;
+    double        seconds  = 0.0;
+};
+
+// `replay(fh)` runs on the producer thread and returns the messages published.
+// How the consumer takes messages off the ring.
+enum class ConsumeMode { Peek, PopBulk, Pop };
+
+template <typename Replay>
+static PipelineResult run_pipeline(Replay&& replay,
+                                   std::uint32_t producer_core, std::uint32_t consumer_core,
+                                   ConsumeMode mode, const WaitStrategy::Options& wait_opts)
+{
     constexpr std::size_t QUEUE_CAP = 1u << 20;   // power-of-two for SPSC mask trick
 
     MdQueue   queue(QUEUE_CAP);
+    Doorbell  doorbell;
+    if (wait_opts.kind == WaitStrategy::Kind::Park) queue.set_doorbell(&doorbell);
     OrderBook ob(/*min_price*/90, /*max_price*/110, /*max_orders*/2'000'000);
     FeedHandler fh(queue);
 
     // Shared state between threads — written by one side, read after join.
-    std::uint64_t          num_produced = 0;
-    std::uint64_t          num_consumed = 0;
+    PipelineResult         r;
     std::atomic<bool>      producer_done{false};
 
     auto t0 = std::chrono::high_resolution_clock::now();
 
     // -----------------------------------------------------------------------
-    // Producer thread: mmap replay → FeedHandler → SPSC queue
+    // Producer thread: replay → FeedHandler → SPSC queue
     // -----------------------------------------------------------------------
     std::thread producer_thread([&] {
         if (producer_core != NO_AFFINITY) pin_thread_to_core(producer_core);
-        num_produced = run_mmap_replay(fh, filename);
+        r.produced = replay(fh);
         producer_done.store(true, std::memory_order_release);
+        doorbell.ring();
     });
 
     // -----------------------------------------------------------------------
@@ -55,44 +406,181 @@ int main(int argc, char** argv) {
     // -----------------------------------------------------------------------
     std::thread consumer_thread([&] {
         if (consumer_core != NO_AFFINITY) pin_thread_to_core(consumer_core);
-        MarketUpdate u;
+        WaitStrategy wait(wait_opts, &doorbell);
+        MarketUpdate batch[256];
+        auto drain = [&] {
+            std::size_t n = 0;
+            switch (mode) {
+            case ConsumeMode::Peek: {
+                const auto slots = queue.peek(256);   // apply in place
+                for (const MarketUpdate& u : slots) ob.applyUpdate(u);
+                queue.release(slots.size());
+                n = slots.size();
+                break;
+            }
+            case ConsumeMode::PopBulk:
+                n = queue.pop_bulk(batch);
+                for (std::size_t i = 0; i < n; ++i) ob.applyUpdate(batch[i]);
+                break;
+            case ConsumeMode::Pop:
+                n = queue.pop(batch[0]) ? 1 : 0;
+                if (n) ob.applyUpdate(batch[0]);
+                break;
+            }
+            r.consumed += n;
+            return n != 0;
+        };
         while (true) {
-            if (queue.pop(u)) {
-                ob.applyUpdate(u);
-                ++num_consumed;
+            if (drain()) {
+                wait.reset();
+                continue;
             } else if (producer_done.load(std::memory_order_acquire)) {
                 // Producer is finished — drain any items remaining in the queue.
-                while (queue.pop(u)) {
-                    ob.applyUpdate(u);
-                    ++num_consumed;
-                }
+                while (drain()) {}
                 break;
             }
-            // else: queue transiently empty, producer still running — spin
+            // Queue transiently empty, producer still running.
+            wait.idle([&] {
+                return !queue.empty() || producer_done.load(std::memory_order_acquire);
+            });
         }
     });
 
     producer_thread.join();
-    consumer_thread.join();   // happens-before: safe to read num_produced/consumed
+    consumer_thread.join();   // happens-before: safe to read produced/consumed
 
     auto t1 = std::chrono::high_resolution_clock::now();
-    double seconds = std::chrono::duration<double>(t1 - t0).count();
+    r.seconds = std::chrono::duration<double>(t1 - t0).count();
+    return r;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: feed_throughput <replay_file> [more_files...] [mmap options] "
+                     "[producer_core consumer_core]\n";
+        std::cerr << "       feed_throughput <replay_file> --shards <n> <num_symbols> "
+                     "[producer_core consumer_core...]\n";
+        std::cerr << "       feed_throughput <replay_file> --broadcast <n> "
+                     "[producer_core reader_core...]\n";
+        std::cerr << "       feed_throughput <replay_file> --ipc [--huge-pages] "
+                     "[--hugetlbfs <dir>] [--populate] [producer_core consumer_core]\n";
+        std::cerr << "  Omit core args to run without thread affinity (OS decides).\n";
+        std::cerr << "  mmap options (POSIX): --populate  --huge-pages  --no-sequential  "
+                     "--readahead <KiB>\n";
+        std::cerr << "  streaming source (Linux): --uring [--direct] [--uring-qd <n>] "
+                     "[--uring-block <KiB>]\n";
+        std::cerr << "  Several files are merged by timestamp (one per venue/channel).\n";
+        std::cerr << "  --consumer <peek|pop-bulk|pop>: read in place (default), copy out in "
+                     "batches of 256, or one at a time\n";
+        std::cerr << "  --wait <spin|yield|park>: what the consumer does while the ring is "
+                     "empty (default spin)\n";
+        std::cerr << "  --no-in-place: decode compact blocks into a buffer, not straight into "
+                     "the ring\n";
+        return 1;
+    }
+    if (argc >= 3 && std::strcmp(argv[2], "--shards") == 0) {
+        return run_sharded(argc, argv);
+    }
+    if (argc >= 3 && std::strcmp(argv[2], "--broadcast") == 0) {
+        return run_broadcast(argc, argv);
+    }
+    if (argc >= 3 && std::strcmp(argv[2], "--ipc") == 0) {
+        return run_ipc(argc, argv);
+    }
+    std::vector<const char*> files{argv[1]};
+
+    MmapReplayOptions        opts;
+    UringReplayOptions       uring_opts;
+    bool                     use_uring = false;
+    ConsumeMode              mode      = ConsumeMode::Peek;
+    WaitStrategy::Options    wait_opts;
+    std::vector<const char*> cores;
+    for (int i = 2; i < argc; ++i) {
+        if      (std::strcmp(argv[i], "--uring") == 0)         use_uring         = true;
+        else if (std::strcmp(argv[i], "--direct") == 0)        uring_opts.direct = true;
+        else if (std::strcmp(argv[i], "--uring-qd") == 0 && i + 1 < argc)
+            uring_opts.queue_depth = (unsigned)std::strtoul(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--uring-block") == 0 && i + 1 < argc)
+            uring_opts.block_bytes = std::strtoul(argv[++i], nullptr, 10) * 1024;
+        else if (std::strcmp(argv[i], "--consumer") == 0 && i + 1 < argc) {
+            ++i;
+            if      (std::strcmp(argv[i], "pop") == 0)      mode = ConsumeMode::Pop;
+            else if (std::strcmp(argv[i], "pop-bulk") == 0) mode = ConsumeMode::PopBulk;
+            else                                            mode = ConsumeMode::Peek;
+        }
+        else if (std::strcmp(argv[i], "--wait") == 0 && i + 1 < argc) {
+            ++i;
+            if      (std::strcmp(argv[i], "yield") == 0) wait_opts.kind = WaitStrategy::Kind::SpinYield;
+            else if (std::strcmp(argv[i], "park") == 0)  wait_opts.kind = WaitStrategy::Kind::Park;
+            else                                         wait_opts.kind = WaitStrategy::Kind::BusySpin;
+        }
+        else if (std::strcmp(argv[i], "--no-in-place") == 0)   opts.decode_in_place = false;
+        else if (std::strcmp(argv[i], "--populate") == 0)      opts.populate   = true;
+        else if (std::strcmp(argv[i], "--huge-pages") == 0)    opts.huge_pages = true;
+        else if (std::strcmp(argv[i], "--no-sequential") == 0) opts.sequential = false;
+        else if (std::strcmp(argv[i], "--readahead") == 0 && i + 1 < argc)
+            opts.readahead_bytes = std::strtoul(argv[++i], nullptr, 10) * 1024;
+        else if (std::strspn(argv[i], "0123456789") == std::strlen(argv[i])) cores.push_back(argv[i]);
+        else files.push_back(argv[i]);
+    }
+    if (use_uring && files.size() > 1) {
+        std::cerr << "--uring replays a single file; merging with mmap\n";
+        use_uring = false;
+    }
+
+    const bool     pin_threads    = (cores.size() >= 2);
+    std::uint32_t  producer_core  = pin_threads ? (std::uint32_t)std::atoi(cores[0]) : NO_AFFINITY;
+    std::uint32_t  consumer_core  = pin_threads ? (std::uint32_t)std::atoi(cores[1]) : NO_AFFINITY;
 
     std::cout << "Affinity      : " << (pin_threads ? "pinned" : "none (OS schedules)") << "\n";
     if (pin_threads) {
         std::cout << "Producer core : " << producer_core << "\n";
         std::cout << "Consumer core : " << consumer_core << "\n";
     }
-    std::cout << "Produced      : " << num_produced  << " msgs\n";
-    std::cout << "Consumed      : " << num_consumed  << " msgs\n";
-
-    if (seconds > 0.0 && num_produced > 0) {
-        double mps = (double)num_produced / seconds;
-        std::cout << "Elapsed       : " << seconds        << " s\n";
-        std::cout << "Throughput    : " << mps / 1e6      << " M msgs/sec\n";
+    std::cout << "Consumer      : " << (mode == ConsumeMode::Peek    ? "peek/release (256, in place)"
+                                      : mode == ConsumeMode::PopBulk ? "pop_bulk (256)" : "pop") << "\n";
+    std::cout << "Consumer wait : " << (wait_opts.kind == WaitStrategy::Kind::BusySpin  ? "busy-spin"
+                                      : wait_opts.kind == WaitStrategy::Kind::SpinYield ? "spin-then-yield"
+                                                                                        : "park") << "\n";
+    if (files.size() > 1) {
+        std::cout << "Merge         : " << files.size() << " files by timestamp\n";
+    }
+    if (use_uring) {
+        std::cout << "io_uring      : queue_depth=" << uring_opts.queue_depth
+                  << " block="   << uring_opts.block_bytes / 1024 << " KiB"
+                  << " direct="  << uring_opts.direct << "\n";
     } else {
-        std::cout << "No messages processed or zero elapsed time.\n";
+        std::cout << "mmap          : populate=" << opts.populate
+                  << " sequential="   << opts.sequential
+                  << " huge_pages="   << opts.huge_pages
+                  << " readahead="    << opts.readahead_bytes / 1024 << " KiB"
+                  << " decode_in_place=" << opts.decode_in_place << "\n";
     }
 
+    auto replay = [&](FeedHandler& fh) {
+        if (files.size() > 1) return run_merge_replay(fh, files, opts);
+        return use_uring ? run_uring_replay(fh, files[0], uring_opts)
+                         : run_mmap_replay(fh, files[0], opts);
+    };
+
+    // Cold pass: drop the file from the page cache first, so the replay
+    // includes the disk reads. Warm pass: same file, now fully cached
+    // (unless it is larger than the page cache, or read with O_DIRECT).
+    bool evicted = true;
+    for (const char* f : files) evicted = evict_page_cache(f) && evicted;
+    const PipelineResult cold = run_pipeline(replay, producer_core, consumer_core, mode, wait_opts);
+    const PipelineResult warm = run_pipeline(replay, producer_core, consumer_core, mode, wait_opts);
+
+    std::cout << "\n-- cold cache" << (evicted ? "" : " (page cache eviction unsupported: "
+                                                     "file may still be cached)") << "\n";
+    std::cout << "Produced      : " << cold.produced << " msgs\n";
+    std::cout << "Consumed      : " << cold.consumed << " msgs\n";
+    print_throughput(cold.produced, cold.seconds);
+
+    std::cout << "\n-- warm cache\n";
+    std::cout << "Produced      : " << warm.produced << " msgs\n";
+    std::cout << "Consumed      : " << warm.consumed << " msgs\n";
+    print_throughput(warm.produced, warm.seconds);
+
     return 0;
 }
@@ -0,0 +1,213 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <time.h>
+#endif
+
+#include "../src/core/ring_buffer.hpp"
+#include "../src/core/wait_strategy.hpp"
+#include "../src/util/cpu_affinity.hpp"
+#include "../src/util/timer.hpp"
+
+// ---------------------------------------------------------------------------
+// wait_strategies — latency and CPU cost of each consumer WaitStrategy.
+//
+//   wait_strategies [--seconds s] [--interval-us n] [--burst n] [--background n]
+//                   [--spin-limit n] [--cores producer consumer]
+//
+// A producer publishes a burst of `--burst` updates every `--interval-us`
+// (sleeping in between, as a feed thread blocked on the network would) to
+// an SpscRing; ts is stamped at publish. The consumer drains with each
+// wait strategy in turn and records now - ts. Reported per strategy:
+//
+//   p50/p99/p99.9 latency      publish to consume
+//   consumer CPU               thread CPU time / wall time
+//   wakeups                    futex wakes the producer issued (Park)
+//   background M iter/s        work done by `--background` busy threads
+//                              sharing the machine: what the consumer
+//                              leaves for co-located processes
+// ---------------------------------------------------------------------------
+
+namespace {
+
+struct Options {
+    double                     seconds     = 2.0;
+    std::uint64_t              interval_us = 50;
+    std::size_t                burst       = 1;
+    std::size_t                background  = 0;
+    std::uint32_t              spin_limit  = 1024;
+    std::vector<std::uint32_t> cores;   // producer, consumer
+};
+
+struct Result {
+    std::uint64_t msgs       = 0;
+    std::uint64_t p50_ns     = 0;
+    std::uint64_t p99_ns     = 0;
+    std::uint64_t p999_ns    = 0;
+    double        cpu        = 0.0;   // consumer CPU time / wall time
+    std::uint64_t wakeups    = 0;
+    double        background = 0.0;   // M iterations/s across background threads
+};
+
+double thread_cpu_seconds() {
+#ifndef _WIN32
+    timespec ts;
+    ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+#else
+    return 0.0;
+#endif
+}
+
+Result run(const Options& opts, WaitStrategy::Kind kind) {
+    SpscRing<MarketUpdate> ring(1u << 16);
+    Doorbell               doorbell;
+    if (kind == WaitStrategy::Kind::Park) ring.set_doorbell(&doorbell);
+
+    std::atomic<bool>          stop{false};
+    std::atomic<bool>          producer_done{false};
+    std::vector<std::uint64_t> bg_iters(opts.background);
+    std::vector<std::thread>   background;
+    for (std::size_t i = 0; i < opts.background; ++i) {
+        background.emplace_back([&, i] {
+            std::uint64_t n = 0;
+            volatile std::uint64_t sink = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                for (int k = 0; k < 1000; ++k) sink = sink + k;
+                ++n;
+            }
+            bg_iters[i] = n * 1000;
+        });
+    }
+
+    Result r;
+    std::thread producer([&] {
+        if (opts.cores.size() >= 2) pin_thread_to_core(opts.cores[0]);
+        std::vector<MarketUpdate> batch(opts.burst);
+        const auto interval = std::chrono::microseconds(opts.interval_us);
+        const auto end      = std::chrono::steady_clock::now()
+                            + std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                  std::chrono::duration<double>(opts.seconds));
+        auto next = std::chrono::steady_clock::now();
+        while (next < end) {
+            std::this_thread::sleep_until(next);
+            next += interval;
+            const std::uint64_t now = get_monotonic_ns();
+            for (MarketUpdate& u : batch) u.ts = now;
+            std::size_t done = 0;
+            while (done < batch.size()) {
+                done += ring.push_bulk(batch.data() + done, batch.size() - done);
+            }
+        }
+        producer_done.store(true, std::memory_order_release);
+        doorbell.ring();
+    });
+
+    if (opts.cores.size() >= 2) pin_thread_to_core(opts.cores[1]);
+    WaitStrategy::Options wopts;
+    wopts.kind       = kind;
+    wopts.spin_limit = opts.spin_limit;
+    WaitStrategy wait(wopts, &doorbell);
+    std::vector<std::uint64_t> lat;
+    lat.reserve(static_cast<std::size_t>(opts.seconds * 1e6 / opts.interval_us + 1) * opts.burst);
+
+    const std::uint64_t t0   = get_monotonic_ns();
+    const double        cpu0 = thread_cpu_seconds();
+    while (true) {
+        const auto batch = ring.peek(256);
+        if (!batch.empty()) {
+            const std::uint64_t now = get_monotonic_ns();
+            for (const MarketUpdate& u : batch) lat.push_back(now - u.ts);
+            ring.release(batch.size());
+            wait.reset();
+            continue;
+        }
+        if (producer_done.load(std::memory_order_acquire)) {
+            if (ring.empty()) break;
+            continue;
+        }
+        wait.idle([&] { return !ring.empty() || producer_done.load(std::memory_order_acquire); });
+    }
+    const double wall = (get_monotonic_ns() - t0) / 1e9;
+    r.cpu = (thread_cpu_seconds() - cpu0) / wall;
+
+    producer.join();
+    stop.store(true, std::memory_order_relaxed);
+    for (auto& t : background) t.join();
+    for (std::uint64_t n : bg_iters) r.background += n / wall / 1e6;
+
+    r.msgs    = lat.size();
+    r.wakeups = doorbell.wakeups();
+    if (!lat.empty()) {
+        auto at = [&](double q) {
+            auto it = lat.begin() + static_cast<std::ptrdiff_t>(q * (lat.size() - 1));
+            std::nth_element(lat.begin(), it, lat.end());
+            return *it;
+        };
+        r.p50_ns  = at(0.50);
+        r.p99_ns  = at(0.99);
+        r.p999_ns = at(0.999);
+    }
+    return r;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opts;
+    for (int i = 1; i < argc; ++i) {
+        const bool more = i + 1 < argc;
+        if      (std::strcmp(argv[i], "--seconds") == 0 && more)     opts.seconds = std::strtod(argv[++i], nullptr);
+        else if (std::strcmp(argv[i], "--interval-us") == 0 && more) opts.interval_us = std::strtoull(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--burst") == 0 && more)       opts.burst = std::strtoul(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--background") == 0 && more)  opts.background = std::strtoul(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--spin-limit") == 0 && more)  opts.spin_limit = (std::uint32_t)std::strtoul(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--cores") == 0 && i + 2 < argc) {
+            opts.cores.push_back((std::uint32_t)std::strtoul(argv[++i], nullptr, 10));
+            opts.cores.push_back((std::uint32_t)std::strtoul(argv[++i], nullptr, 10));
+        }
+        else {
+            std::cerr << "Usage: wait_strategies [--seconds s] [--interval-us n] [--burst n] "
+                         "[--background n] [--spin-limit n] [--cores producer consumer]\n";
+            return 1;
+        }
+    }
+    if (opts.seconds <= 0.0 || opts.interval_us == 0 || opts.burst == 0) {
+        std::cerr << "need --seconds > 0, --interval-us >= 1, --burst >= 1\n";
+        return 1;
+    }
+
+    std::cout << "Duration      : " << opts.seconds << " s per strategy\n"
+              << "Load          : " << opts.burst << " msgs every " << opts.interval_us << " us\n"
+              << "Background    : " << opts.background << " busy threads\n"
+              << "Spin limit    : " << opts.spin_limit << "\n"
+              << "HW threads    : " << std::thread::hardware_concurrency() << "\n\n"
+              << "strategy           msgs    p50 ns    p99 ns  p99.9 ns   cpu %   wakeups  bg M it/s\n";
+    const std::pair<const char*, WaitStrategy::Kind> kinds[] = {
+        {"busy-spin",  WaitStrategy::Kind::BusySpin},
+        {"spin-yield", WaitStrategy::Kind::SpinYield},
+        {"park",       WaitStrategy::Kind::Park},
+    };
+    for (const auto& [name, kind] : kinds) {
+        const Result r = run(opts, kind);
+        std::cout << std::left << std::setw(12) << name << std::right
+                  << std::setw(11) << r.msgs
+                  << std::setw(10) << r.p50_ns
+                  << std::setw(10) << r.p99_ns
+                  << std::setw(10) << r.p999_ns
+                  << std::setw(8)  << std::fixed << std::setprecision(1) << r.cpu * 100
+                  << std::setw(10) << r.wakeups
+                  << std::setw(11) << std::setprecision(1) << r.background << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "order_book.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// BookManager
+//
+// Owns one OrderBook per instrument, indexed directly by
+// MarketUpdate::symbol_id. Books are registered up front (each instrument
+// has its own price range / capacity), so routing an update is one bounds
+// check and one pointer load. Updates for unregistered symbols are dropped.
+// ---------------------------------------------------------------------------
+class BookManager {
+public:
+    BookManager() = default;
+
+    BookManager(const BookManager&)            = delete;
+    BookManager& operator=(const BookManager&) = delete;
+
+    // Forwards args to the OrderBook constructor. Replaces any existing
+    // book for the symbol.
+    template <typename... Args>
+    OrderBook& addBook(uint16_t symbol_id, Args&&... args) {
+        if (symbol_id >= books_.size()) books_.resize(size_t{symbol_id} + 1);
+        if (!books_[symbol_id]) ++num_books_;
+        books_[symbol_id] = std::make_unique<OrderBook>(std::forward<Args>(args)...);
+        return *books_[symbol_id];
+    }
+
+    OrderBook* find(uint16_t symbol_id) const noexcept {
+        return symbol_id < books_.size() ? books_[symbol_id].get() : nullptr;
+    }
+
+    // Returns false if the symbol has no book.
+    bool applyUpdate(const MarketUpdate& u) {
+        OrderBook* book = find(u.symbol_id);
+        if (!book) return false;
+        book->applyUpdate(u);
+        return true;
+    }
+
+    size_t size() const noexcept { return num_books_; }
+
+private:
+    std::vector<std::unique_ptr<OrderBook>> books_;
+    size_t num_books_ = 0;
+};
@@ -0,0 +1,155 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <new>
+#include <span>
+#include <type_traits>
+
+// ---------------------------------------------------------------------------
+// BroadcastRing — one writer, N readers that each see every item (the
+// Disruptor's multicast ring).
+//
+// Readers do not consume items from one another: each has its own cursor
+// and reads the same slots in place (peek/release). The writer only
+// overwrites a slot once every reader has released it, so it is gated by
+// the slowest reader. It keeps a cached minimum of the reader cursors and
+// rescans them only when that cache says the ring is too full, as SpscRing
+// does with its single tail.
+//
+// Reader i must only be used from one thread; different readers may run on
+// different threads.
+// ---------------------------------------------------------------------------
+
+template<typename T>
+class BroadcastRing {
+    static_assert(std::is_trivially_copyable<T>::value, "BroadcastRing copies items with memcpy");
+public:
+    BroadcastRing(size_t capacity_pow2, size_t num_readers)
+        : capacity_(capacity_pow2), mask_(capacity_pow2 - 1), num_readers_(num_readers)
+        , readers_(std::make_unique<Reader[]>(num_readers))
+    {
+        assert(capacity_pow2 != 0 && (capacity_pow2 & (capacity_pow2 - 1)) == 0 && "Capacity must be a power of 2");
+        assert(num_readers != 0);
+        buffer_ = static_cast<T*>(::operator new[](sizeof(T) * capacity_, std::align_val_t(64)));
+        head_.store(0, std::memory_order_relaxed);
+    }
+    ~BroadcastRing()
+    {
+        ::operator delete[](buffer_, std::align_val_t(64));
+    }
+    BroadcastRing(const BroadcastRing&) = delete;
+    BroadcastRing& operator=(const BroadcastRing&) = delete;
+
+    size_t numReaders() const { return num_readers_; }
+
+    // ---- writer --------------------------------------------------------
+
+    bool push(const T& item)
+    {
+        return push_bulk(&item, 1) == 1;
+    }
+
+    // Pushes up to `count` items with a single head update. Returns how
+    // many were pushed (0 while the slowest reader holds every slot).
+    size_t push_bulk(const T* items, size_t count)
+    {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        const size_t n    = std::min(count, free_slots(head, count));
+        if (n == 0) return 0;
+        const size_t idx   = head & mask_;
+        const size_t first = std::min(n, capacity_ - idx);   // up to the wrap point
+        std::memcpy(&buffer_[idx], items, first * sizeof(T));
+        std::memcpy(&buffer_[0], items + first, (n - first) * sizeof(T));
+        head_.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+    size_t push_bulk(std::span<const T> items)
+    {
+        return push_bulk(items.data(), items.size());
+    }
+
+    // In place, as SpscRing::claim/commit: up to `n` free slots at the write
+    // position, never across the end of the buffer.
+    std::span<T> claim(size_t n)
+    {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        const size_t idx  = head & mask_;
+        n = std::min({n, free_slots(head, n), capacity_ - idx});
+        return {&buffer_[idx], n};
+    }
+
+    void commit(size_t n)
+    {
+        head_.store(head_.load(std::memory_order_relaxed) + n, std::memory_order_release);
+    }
+
+    size_t claim_limit() const
+    {
+        return capacity_ - (head_.load(std::memory_order_relaxed) & mask_);
+    }
+
+    // ---- reader r ------------------------------------------------------
+
+    // Up to `n` items reader `r` has not released yet, contiguous in the
+    // buffer; valid until that reader releases them.
+    std::span<const T> peek(size_t r, size_t n)
+    {
+        Reader& rd = readers_[r];
+        const size_t tail = rd.tail.load(std::memory_order_relaxed);
+        if (rd.cached_head - tail < n) {
+            rd.cached_head = head_.load(std::memory_order_acquire);
+        }
+        const size_t idx = tail & mask_;
+        n = std::min({n, rd.cached_head - tail, capacity_ - idx});
+        return {&buffer_[idx], n};
+    }
+
+    void release(size_t r, size_t n)
+    {
+        Reader& rd = readers_[r];
+        rd.tail.store(rd.tail.load(std::memory_order_relaxed) + n, std::memory_order_release);
+    }
+
+    // Items published but not yet released by reader `r`.
+    size_t size(size_t r) const
+    {
+        return head_.load(std::memory_order_acquire) - readers_[r].tail.load(std::memory_order_acquire);
+    }
+
+    bool empty(size_t r) const { return size(r) == 0; }
+
+private:
+    struct alignas(64) Reader {
+        std::atomic<size_t> tail{0};
+        size_t              cached_head = 0;   // this reader only
+    };
+
+    // Free slots from `head`, rescanning the reader cursors only if the
+    // cached minimum leaves fewer than `want`.
+    size_t free_slots(size_t head, size_t want)
+    {
+        if (capacity_ - (head - cached_min_tail_) < want) {
+            size_t min_tail = std::numeric_limits<size_t>::max();
+            for (size_t r = 0; r < num_readers_; ++r) {
+                min_tail = std::min(min_tail, readers_[r].tail.load(std::memory_order_acquire));
+            }
+            cached_min_tail_ = min_tail;
+        }
+        return capacity_ - (head - cached_min_tail_);
+    }
+
+    const size_t capacity_;
+    const size_t mask_;
+    const size_t num_readers_;
+    T* buffer_ = nullptr;
+    std::unique_ptr<Reader[]> readers_;
+    alignas(64) std::atomic<size_t> head_;
+    size_t cached_min_tail_ = 0;   // writer only
+};
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// LevelBitmap
+//
+// Hierarchical occupancy bitset over slots [0, size). Level 0 holds one bit
+// per slot; every bit of level k+1 says "word k has at least one bit set".
+// Levels are added until the top fits in a single 64-bit word, so a ladder of
+// 262 144 ticks needs three levels and any nearest-set-bit query costs at most
+// one lzcnt/tzcnt per level on the way up and one per level on the way down.
+//
+// All words live in one contiguous vector (level 0 first) so the upper levels
+// of a typical book stay resident in L1.
+// ---------------------------------------------------------------------------
+class LevelBitmap {
+public:
+    static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+    explicit LevelBitmap(std::size_t size)
+        : size_(size)
+    {
+        std::size_t n = size;
+        std::size_t offset = 0;
+        do {
+            const std::size_t words = n > 64 ? (n + 63) / 64 : 1;
+            assert(num_levels_ < MAX_LEVELS && "ladder too wide for LevelBitmap");
+            offset_[num_levels_] = offset;
+            words_per_level_[num_levels_] = words;
+            ++num_levels_;
+            offset += words;
+            n = words;
+        } while (n > 1);
+        words_.assign(offset, 0);
+    }
+
+    std::size_t size() const noexcept { return size_; }
+
+    bool empty() const noexcept { return top() == 0; }
+
+    bool test(std::size_t i) const noexcept {
+        return (word(0, i >> 6) >> (i & 63)) & 1u;
+    }
+
+    void set(std::size_t i) noexcept {
+        for (std::size_t lvl = 0; lvl < num_levels_; ++lvl) {
+            uint64_t& w = word(lvl, i >> 6);
+            const bool was_empty = (w == 0);
+            w |= uint64_t{1} << (i & 63);
+            if (!was_empty) return;  // parent bit already set
+            i >>= 6;
+        }
+    }
+
+    void clear(std::size_t i) noexcept {
+        for (std::size_t lvl = 0; lvl < num_levels_; ++lvl) {
+            uint64_t& w = word(lvl, i >> 6);
+            w &= ~(uint64_t{1} << (i & 63));
+            if (w != 0) return;      // word still occupied, parent stays set
+            i >>= 6;
+        }
+    }
+
+    void clearAll() noexcept { words_.assign(words_.size(), 0); }
+
+    // Highest set slot <= i, or npos.
+    std::size_t findPrev(std::size_t i) const noexcept {
+        if (i >= size_) i = size_ - 1;
+        std::size_t lvl = 0;
+        for (;;) {
+            const std::size_t w = i >> 6;
+            const uint64_t m = word(lvl, w) & (~uint64_t{0} >> (63 - (i & 63)));
+            if (m != 0) {
+                i = (w << 6) | (63 - std::countl_zero(m));
+                break;
+            }
+            if (w == 0 || lvl + 1 == num_levels_) return npos;
+            i = w - 1;
+            ++lvl;
+        }
+        while (lvl > 0) {
+            --lvl;
+            i = (i << 6) | (63 - std::countl_zero(word(lvl, i)));
+        }
+        return i;
+    }
+
+    // Lowest set slot >= i, or npos.
+    std::size_t findNext(std::size_t i) const noexcept {
+        if (i >= size_) return npos;
+        std::size_t lvl = 0;
+        for (;;) {
+            const std::size_t w = i >> 6;
+            const uint64_t m = word(lvl, w) & (~uint64_t{0} << (i & 63));
+            if (m != 0) {
+                i = (w << 6) | std::countr_zero(m);
+                break;
+            }
+            if (lvl + 1 == num_levels_ || w + 1 >= words_per_level_[lvl]) return npos;
+            i = w + 1;
+            ++lvl;
+        }
+        while (lvl > 0) {
+            --lvl;
+            i = (i << 6) | std::countr_zero(word(lvl, i));
+        }
+        return i;
+    }
+
+private:
+    // 64^6 slots is far beyond any price ladder we would allocate densely.
+    static constexpr std::size_t MAX_LEVELS = 6;
+
+    uint64_t& word(std::size_t lvl, std::size_t w) noexcept {
+        return words_[offset_[lvl] + w];
+    }
+    uint64_t word(std::size_t lvl, std::size_t w) const noexcept {
+        return words_[offset_[lvl] + w];
+    }
+    uint64_t top() const noexcept { return word(num_levels_ - 1, 0); }
+
+    std::size_t           size_;
+    std::size_t           num_levels_ = 0;
+    std::size_t           offset_[MAX_LEVELS]          = {};
+    std::size_t           words_per_level_[MAX_LEVELS] = {};
+    std::vector<uint64_t> words_;
+};
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <type_traits>
 
@@ -22,8 +23,11 @@ struct MarketUpdate {
     int64_t  price;
     int64_t  qty;
     OrderSide side;
-    uint8_t  reserved[6]; // padding to make struct 32 bytes
+    uint8_t  _pad0;       // keeps symbol_id 2-byte aligned
+    uint16_t symbol_id;   // instrument; formerly reserved, so 0 in older feed files
+    uint8_t  reserved[3];
 };
 
 static_assert(std::is_trivially_copyable<MarketUpdate>::value, "MarketUpdate must be trivially copyable");
 static_assert(sizeof(MarketUpdate) == 40 || sizeof(MarketUpdate) == 48, "Expect compact fixed size (40 or 48 bytes)");
+static_assert(offsetof(MarketUpdate, symbol_id) == 42, "symbol_id must stay inside the old reserved bytes");
@@ -0,0 +1,148 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <span>
+#include <type_traits>
+
+// ---------------------------------------------------------------------------
+// MpscRing — bounded multi-producer / single-consumer queue (fan-in).
+//
+// Slots carry a sequence number, as in Vyukov's bounded queue and the
+// Disruptor: the item for position p is ready once seq[p & mask] == p + 1.
+// Producers reserve a run of positions with one CAS on head_ per batch,
+// not one per item, copy their items in, then publish each slot by storing
+// its sequence. The consumer reads the ready prefix in position order and
+// frees it with a single tail_ store, which producers check for room.
+//
+// Items from one producer come out in the order it pushed them; runs from
+// different producers interleave in reservation order. A producer that
+// stalls between its reservation and its sequence stores holds back the
+// consumer (not the other producers) until it publishes.
+// ---------------------------------------------------------------------------
+
+template<typename T>
+class MpscRing {
+    static_assert(std::is_trivially_copyable<T>::value, "MpscRing copies items with memcpy");
+public:
+    explicit MpscRing(size_t capacity_pow2): capacity_(capacity_pow2), mask_(capacity_pow2 - 1)
+    {
+        assert(capacity_pow2 != 0 && (capacity_pow2 & (capacity_pow2 - 1)) == 0 && "Capacity must be a power of 2");
+        buffer_ = static_cast<T*>(::operator new[](sizeof(T) * capacity_, std::align_val_t(64)));
+        seq_    = static_cast<std::atomic<size_t>*>(
+            ::operator new[](sizeof(std::atomic<size_t>) * capacity_, std::align_val_t(64)));
+        for (size_t i = 0; i < capacity_; ++i) new (&seq_[i]) std::atomic<size_t>(0);
+        head_.store(0, std::memory_order_relaxed);
+        tail_.store(0, std::memory_order_relaxed);
+    }
+    ~MpscRing()
+    {
+        ::operator delete[](seq_, std::align_val_t(64));
+        ::operator delete[](buffer_, std::align_val_t(64));
+    }
+    MpscRing(const MpscRing&) = delete;
+    MpscRing& operator=(const MpscRing&) = delete;
+
+    // Any thread. Returns false if the queue is full.
+    bool push(const T& item)
+    {
+        return push_bulk(&item, 1) == 1;
+    }
+
+    // Any thread. Pushes up to `count` items from `items` as one contiguous
+    // run (one CAS). Returns how many were pushed (0 if the queue is full).
+    size_t push_bulk(const T* items, size_t count)
+    {
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t n;
+        do {
+            const size_t tail = tail_.load(std::memory_order_acquire);
+            n = std::min(count, capacity_ - (head - tail));
+            if (n == 0) return 0;
+        } while (!head_.compare_exchange_weak(head, head + n, std::memory_order_relaxed));
+
+        const size_t idx   = head & mask_;
+        const size_t first = std::min(n, capacity_ - idx);   // up to the wrap point
+        std::memcpy(&buffer_[idx], items, first * sizeof(T));
+        std::memcpy(&buffer_[0], items + first, (n - first) * sizeof(T));
+        for (size_t i = 0; i < n; ++i) {
+            seq_[(head + i) & mask_].store(head + i + 1, std::memory_order_release);
+        }
+        return n;
+    }
+
+    size_t push_bulk(std::span<const T> items)
+    {
+        return push_bulk(items.data(), items.size());
+    }
+
+    // Consumer only.
+    bool pop(T& out)
+    {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (seq_[tail & mask_].load(std::memory_order_acquire) != tail + 1) return false;
+        std::memcpy(&out, &buffer_[tail & mask_], sizeof(T));
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only. Pops up to out.size() published items with a single
+    // tail update; stops early at a slot whose producer has not published
+    // yet. Returns how many were popped.
+    size_t pop_bulk(std::span<T> out)
+    {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        const size_t n    = ready(tail, out.size());
+        if (n == 0) return 0;
+        const size_t idx   = tail & mask_;
+        const size_t first = std::min(n, capacity_ - idx);
+        std::memcpy(out.data(), &buffer_[idx], first * sizeof(T));
+        std::memcpy(out.data() + first, &buffer_[0], (n - first) * sizeof(T));
+        tail_.store(tail + n, std::memory_order_release);
+        return n;
+    }
+
+    // Consumer only, in place as SpscRing::peek: up to `n` published items
+    // at the read position, contiguous in the buffer, valid until release.
+    std::span<const T> peek(size_t n)
+    {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        const size_t idx  = tail & mask_;
+        return {&buffer_[idx], ready(tail, std::min(n, capacity_ - idx))};
+    }
+
+    void release(size_t n)
+    {
+        tail_.store(tail_.load(std::memory_order_relaxed) + n, std::memory_order_release);
+    }
+
+    // Reserved, not necessarily published, items.
+    size_t size() const
+    {
+        const size_t head = head_.load(std::memory_order_acquire);
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        return head >= tail ? head - tail : 0;
+    }
+
+    bool empty() const { return size() == 0; }
+    size_t capacity() const { return capacity_; }
+private:
+    // Published items from `tail` on, at most `n`.
+    size_t ready(size_t tail, size_t n) const
+    {
+        size_t k = 0;
+        while (k < n && seq_[(tail + k) & mask_].load(std::memory_order_acquire) == tail + k + 1) ++k;
+        return k;
+    }
+
+    const size_t capacity_;
+    const size_t mask_;
+    T* buffer_ = nullptr;
+    std::atomic<size_t>* seq_ = nullptr;
+    alignas(64) std::atomic<size_t> head_;   // next position to reserve; producers CAS it
+    alignas(64) std::atomic<size_t> tail_;   // next position to read; consumer only writes
+};
@@ -1,34 +1,53 @@
 #include "order_book.hpp"
 
+#include <algorithm>
 #include <iostream>
+#include <iterator>
 
-OrderBook::OrderBook(int64_t min_price,
-                     int64_t max_price,
-                     size_t  max_orders)
+OrderBook::OrderBook(int64_t      min_price,
+                     int64_t      max_price,
+                     size_t       max_orders,
+                     OrderIdIndex id_index)
     : min_price_(min_price),
       max_price_(max_price),
+      num_levels_(static_cast<size_t>(max_price - min_price + 1)),
       max_orders_(max_orders),
-      best_bid_price_(min_price),
-      best_ask_price_(max_price)
+      nodes_(max_orders),
+      hashed_ids_(id_index == OrderIdIndex::Hashed),
+      id_map_(hashed_ids_ ? max_orders : 0),
+      bid_levels_(num_levels_),
+      ask_levels_(num_levels_),
+      best_bid_price_(min_price - 1),
+      best_ask_price_(max_price + 1)
 {
-    id_to_index_.resize(max_orders_, OrderNode::INVALID_INDEX);
-
-    num_levels_ = static_cast<size_t>(max_price_ - min_price_ + 1);
+    if (!hashed_ids_) {
+        id_to_index_.resize(max_orders_, OrderNode::INVALID_INDEX);
+    }
 
     bids_ = new PriceLevel[num_levels_];
     asks_ = new PriceLevel[num_levels_];
 
-    nodes_ = new OrderNode[max_orders_];
     free_head_ = 0;
     for (size_t i = 0; i < max_orders_; ++i) {
-        nodes_[i].next = (i + 1 < max_orders_) ? i + 1 : OrderNode::INVALID_INDEX;
+        nodes_.next(i) = (i + 1 < max_orders_) ? i + 1 : OrderNode::INVALID_INDEX;
     }
 }
 
+OrderBook::OrderBook(SlidingWindow window,
+                     size_t        max_orders,
+                     OrderIdIndex  id_index)
+    : OrderBook(window.center_price - static_cast<int64_t>(window.width_ticks / 2),
+                window.center_price - static_cast<int64_t>(window.width_ticks / 2)
+                    + static_cast<int64_t>(window.width_ticks) - 1,
+                max_orders,
+                id_index)
+{
+    sliding_ = true;
+}
+
 OrderBook::~OrderBook() {
     delete[] bids_;
     delete[] asks_;
-    delete[] nodes_;
 }
 
 uint32_t OrderBook::allocNode() {
@@ -37,186 +56,263 @@ uint32_t OrderBook::allocNode() {
     }
 
     uint32_t idx = free_head_;
-    free_head_ = nodes_[idx].next;
+    free_head_ = nodes_.next(idx);
     return idx;
 }
 
 void OrderBook::freeNode(uint32_t idx) {
-    nodes_[idx].next = free_head_;
+    nodes_.next(idx) = free_head_;
     free_head_ = idx;
 }
 
-void OrderBook::insertOrder(const MarketUpdate& u) {
-    uint32_t idx = allocNode();
-    if (idx == OrderNode::INVALID_INDEX) return;
-
-    OrderNode& node = nodes_[idx];
-    node.order_id = u.order_id;
-    node.price    = u.price;
-    node.qty      = u.qty;
-    node.side     = u.side;
-    node.next     = OrderNode::INVALID_INDEX;
-    node.prev     = OrderNode::INVALID_INDEX;
+uint32_t OrderBook::findId(uint64_t order_id) const noexcept {
+    if (hashed_ids_) {
+        return id_map_.find(order_id);   // NOT_FOUND == INVALID_INDEX
+    }
+    return id_to_index_[order_id];
+}
 
-    size_t level_idx = static_cast<size_t>(u.price - min_price_);
+bool OrderBook::bindId(uint64_t order_id, uint32_t idx) noexcept {
+    if (hashed_ids_) return id_map_.insert(order_id, idx);
+    id_to_index_[order_id] = idx;
+    return true;
+}
 
-    PriceLevel* levels = (u.side == OrderSide::Bid) ? bids_ : asks_;
-    PriceLevel& level  = levels[level_idx];
+void OrderBook::unbindId(uint64_t order_id) noexcept {
+    if (hashed_ids_) id_map_.erase(order_id);
+    else             id_to_index_[order_id] = OrderNode::INVALID_INDEX;
+}
 
-    if (level.head == OrderNode::INVALID_INDEX) {
-        level.head = idx;
-        level.tail = idx;
-        level.price = u.price;
-    } else {
-        node.prev = level.tail;
-        nodes_[level.tail].next = idx;
-        level.tail = idx;
-    }
+size_t OrderBook::slotOf(int64_t price) const noexcept {
+    size_t slot = origin_slot_ + static_cast<size_t>(price - min_price_);
+    if (slot >= num_levels_) slot -= num_levels_;
+    return slot;
+}
 
-    level.total_qty += u.qty;
+int64_t OrderBook::priceOf(size_t slot) const noexcept {
+    size_t offset = (slot >= origin_slot_) ? slot - origin_slot_
+                                           : slot + num_levels_ - origin_slot_;
+    return min_price_ + static_cast<int64_t>(offset);
+}
 
-    if (u.side == OrderSide::Bid) {
-        if (u.price > best_bid_price_) {
-            best_bid_price_ = u.price;
-        }
-    } else {
-        if (u.price < best_ask_price_) {
-            best_ask_price_ = u.price;
-        }
+int64_t OrderBook::prevOccupied(const LevelBitmap& levels, int64_t price) const noexcept {
+    // Window prices map to slots [origin_slot_, N) then [0, origin_slot_).
+    const size_t slot = slotOf(price);
+    size_t li = levels.findPrev(slot);
+    if (slot >= origin_slot_) {
+        if (li == LevelBitmap::npos || li < origin_slot_) return min_price_ - 1;
+    } else if (li == LevelBitmap::npos) {
+        li = levels.findPrev(num_levels_ - 1);
+        if (li == LevelBitmap::npos || li < origin_slot_) return min_price_ - 1;
     }
-
-    id_to_index_[u.order_id] = idx;
+    return priceOf(li);
 }
 
-void OrderBook::modifyOrder(const MarketUpdate& u) {
-    uint32_t idx = id_to_index_[u.order_id];
-    if (idx == OrderNode::INVALID_INDEX) return;
+int64_t OrderBook::nextOccupied(const LevelBitmap& levels, int64_t price) const noexcept {
+    const size_t slot = slotOf(price);
+    size_t li = levels.findNext(slot);
+    if (slot < origin_slot_) {
+        if (li == LevelBitmap::npos || li >= origin_slot_) return max_price_ + 1;
+    } else if (li == LevelBitmap::npos) {
+        if (origin_slot_ == 0) return max_price_ + 1;
+        li = levels.findNext(0);
+        if (li == LevelBitmap::npos || li >= origin_slot_) return max_price_ + 1;
+    }
+    return priceOf(li);
+}
 
-    OrderNode& node = nodes_[idx];
-    if (u.price == node.price) {
-        int32_t delta = u.qty - node.qty;
-        node.qty = u.qty;
+void OrderBook::linkNode(uint32_t idx) {
+    const int64_t price = nodes_.price(idx);
+    nodes_.next(idx) = OrderNode::INVALID_INDEX;
+    nodes_.prev(idx) = OrderNode::INVALID_INDEX;
+
+    size_t level_idx = slotOf(price);
+    const bool is_bid = (nodes_.side(idx) == OrderSide::Bid);
+    PriceLevel& level = is_bid ? bids_[level_idx] : asks_[level_idx];
+
+    const bool created = (level.head == OrderNode::INVALID_INDEX);
+    if (created) {
+        level.head  = idx;
+        level.tail  = idx;
+        level.price = price;
+        (is_bid ? bid_levels_ : ask_levels_).set(level_idx);
+    } else {
+        nodes_.prev(idx) = level.tail;
+        nodes_.next(level.tail) = idx;
+        level.tail = idx;
+    }
 
-        size_t level_idx = static_cast<size_t>(node.price - min_price_);
-        PriceLevel* levels = (node.side == OrderSide::Bid) ? bids_ : asks_;
-        PriceLevel& level = levels[level_idx];
+    level.total_qty += nodes_.qty(idx);
+    if (features_enabled_) touch(nodes_.side(idx), price, nodes_.qty(idx), created);
 
-        level.total_qty += delta;
-        return;
+    if (is_bid) {
+        if (price > best_bid_price_) best_bid_price_ = price;
+    } else {
+        if (price < best_ask_price_) best_ask_price_ = price;
     }
+}
 
-    // price change: remove from old level (O(1) via prev/next)
-    size_t old_idx = static_cast<size_t>(node.price - min_price_);
-    PriceLevel* old_levels = (node.side == OrderSide::Bid) ? bids_ : asks_;
-    PriceLevel& old_level = old_levels[old_idx];
+void OrderBook::unlinkNode(uint32_t idx) {
+    const int64_t price = nodes_.price(idx);
+    size_t level_idx = slotOf(price);
+    const bool is_bid = (nodes_.side(idx) == OrderSide::Bid);
+    PriceLevel& level = is_bid ? bids_[level_idx] : asks_[level_idx];
 
     {
-        uint32_t p = node.prev;
-        uint32_t n = node.next;
-        if (p == OrderNode::INVALID_INDEX) old_level.head = n;
-        else                               nodes_[p].next = n;
-        if (n == OrderNode::INVALID_INDEX) old_level.tail = p;
-        else                               nodes_[n].prev = p;
+        uint32_t p = nodes_.prev(idx);
+        uint32_t n = nodes_.next(idx);
+        if (p == OrderNode::INVALID_INDEX) level.head = n;
+        else                               nodes_.next(p) = n;
+        if (n == OrderNode::INVALID_INDEX) level.tail = p;
+        else                               nodes_.prev(n) = p;
     }
 
-    old_level.total_qty -= node.qty;
+    level.total_qty -= nodes_.qty(idx);
 
-    if (node.side == OrderSide::Bid && node.price == best_bid_price_) {
-        // scan downward to find next non-empty bid
-        for (int64_t p = best_bid_price_; p >= min_price_; --p) {
-            size_t li = static_cast<size_t>(p - min_price_);
-            if (bids_[li].head != OrderNode::INVALID_INDEX) {
-                best_bid_price_ = p;
-                break;
-            }
+    const bool emptied = (level.head == OrderNode::INVALID_INDEX);
+    if (features_enabled_) touch(nodes_.side(idx), price, -nodes_.qty(idx), emptied);
+    if (!emptied) return;
+
+    // Level emptied: drop it from the index and, if it was the touch,
+    // find the next best level with a bitmap scan.
+    if (is_bid) {
+        bid_levels_.clear(level_idx);
+        if (price == best_bid_price_) {
+            best_bid_price_ = prevOccupied(bid_levels_, price);
+        }
+    } else {
+        ask_levels_.clear(level_idx);
+        if (price == best_ask_price_) {
+            best_ask_price_ = nextOccupied(ask_levels_, price);
         }
     }
+}
 
-    if (node.side == OrderSide::Ask && node.price == best_ask_price_) {
-        // scan upward to find next non-empty ask
-        for (int64_t p = best_ask_price_; p <= max_price_; ++p) {
-            size_t li = static_cast<size_t>(p - min_price_);
-            if (asks_[li].head != OrderNode::INVALID_INDEX) {
-                best_ask_price_ = p;
-                break;
-            }
+void OrderBook::evictLevels(PriceLevel* levels, LevelBitmap& occupied,
+                            int64_t lo, int64_t hi) {
+    for (int64_t p = nextOccupied(occupied, lo); p <= hi; ) {
+        const size_t slot = slotOf(p);
+        PriceLevel& level = levels[slot];
+        for (uint32_t idx = level.head; idx != OrderNode::INVALID_INDEX; ) {
+            const uint32_t next = nodes_.next(idx);
+            unbindId(nodes_.orderId(idx));
+            freeNode(idx);
+            ++evicted_orders_;
+            idx = next;
         }
+        level = PriceLevel();
+        occupied.clear(slot);
+
+        if (p == hi) break;
+        p = nextOccupied(occupied, p + 1);
     }
+}
 
-    node.price = u.price;
-    node.qty   = u.qty;
-    node.next  = OrderNode::INVALID_INDEX;
-    node.prev  = OrderNode::INVALID_INDEX;
+void OrderBook::evictRange(int64_t lo, int64_t hi) {
+    evictLevels(bids_, bid_levels_, lo, hi);
+    evictLevels(asks_, ask_levels_, lo, hi);
+}
 
-    size_t new_idx = static_cast<size_t>(u.price - min_price_);
-    PriceLevel* new_levels = (node.side == OrderSide::Bid) ? bids_ : asks_;
-    PriceLevel& new_level = new_levels[new_idx];
+bool OrderBook::recenter(int64_t price) {
+    // Centre on the mid; fall back to whichever side exists, then to the
+    // incoming price for an empty book.
+    const bool has_bid = best_bid_price_ >= min_price_;
+    const bool has_ask = best_ask_price_ <= max_price_;
+    int64_t center = price;
+    if (has_bid && has_ask) center = best_bid_price_ + (best_ask_price_ - best_bid_price_) / 2;
+    else if (has_bid)       center = best_bid_price_;
+    else if (has_ask)       center = best_ask_price_;
+
+    const int64_t width   = static_cast<int64_t>(num_levels_);
+    const int64_t new_min = center - width / 2;
+    if (price < new_min || price >= new_min + width) return false;  // too far from the mid
+
+    // Evict the levels that leave the window; their slots are reused by the
+    // prices entering on the other side.
+    const int64_t shift = new_min - min_price_;
+    if (shift >= width || shift <= -width) evictRange(min_price_, max_price_);
+    else if (shift > 0)                    evictRange(min_price_, new_min - 1);
+    else                                   evictRange(new_min + width, max_price_);
+
+    origin_slot_ = static_cast<size_t>(
+        ((static_cast<int64_t>(origin_slot_) + shift % width) + width) % width);
+    min_price_ = new_min;
+    max_price_ = new_min + width - 1;
+
+    best_bid_price_ = prevOccupied(bid_levels_, max_price_);
+    best_ask_price_ = nextOccupied(ask_levels_, min_price_);
+    features_dirty_ = true;   // evictions and moved sentinels: re-walk depth
+    return true;
+}
 
-    if (new_level.head == OrderNode::INVALID_INDEX) {
-        new_level.head = idx;
-        new_level.tail = idx;
-    } else {
-        node.prev = new_level.tail;
-        nodes_[new_level.tail].next = idx;
-        new_level.tail = idx;
-    }
+void OrderBook::insertOrder(const MarketUpdate& u) {
+    uint32_t idx = allocNode();
+    if (idx == OrderNode::INVALID_INDEX) return;
 
-    new_level.total_qty += node.qty;
+    nodes_.orderId(idx) = u.order_id;
+    nodes_.price(idx)   = u.price;
+    nodes_.qty(idx)     = u.qty;
+    nodes_.side(idx)    = u.side;
 
-    if (node.side == OrderSide::Bid && u.price > best_bid_price_) {
-        best_bid_price_ = u.price;
-    }
-    if (node.side == OrderSide::Ask && u.price < best_ask_price_) {
-        best_ask_price_ = u.price;
+    linkNode(idx);
+
+    // An order nobody can cancel would pin its level for the session.
+    if (!bindId(u.order_id, idx)) {
+        unlinkNode(idx);
+        freeNode(idx);
     }
 }
 
-void OrderBook::cancelOrder(const MarketUpdate& u) {
-    uint32_t idx = id_to_index_[u.order_id];
+void OrderBook::modifyOrder(const MarketUpdate& u) {
+    uint32_t idx = findId(u.order_id);
     if (idx == OrderNode::INVALID_INDEX) return;
 
-    OrderNode& node = nodes_[idx];
-    size_t level_idx = static_cast<size_t>(node.price - min_price_);
-    PriceLevel* levels = (node.side == OrderSide::Bid) ? bids_ : asks_;
-    PriceLevel& level = levels[level_idx];
+    if (u.price == nodes_.price(idx)) {
+        int32_t delta = u.qty - nodes_.qty(idx);
+        nodes_.qty(idx) = u.qty;
 
-    {
-        uint32_t p = node.prev;
-        uint32_t n = node.next;
-        if (p == OrderNode::INVALID_INDEX) level.head = n;
-        else                               nodes_[p].next = n;
-        if (n == OrderNode::INVALID_INDEX) level.tail = p;
-        else                               nodes_[n].prev = p;
+        size_t level_idx = slotOf(u.price);
+        PriceLevel* levels = (nodes_.side(idx) == OrderSide::Bid) ? bids_ : asks_;
+        PriceLevel& level = levels[level_idx];
+
+        level.total_qty += delta;
+        if (features_enabled_) touch(nodes_.side(idx), u.price, delta, false);
+        return;
     }
 
-    level.total_qty -= node.qty;
+    // price change: remove from old level (O(1) via prev/next), re-append
+    // at the tail of the new level (loses time priority, as on exchange).
+    unlinkNode(idx);
 
-    if (node.side == OrderSide::Bid && node.price == best_bid_price_) {
-        for (int64_t p = best_bid_price_; p >= min_price_; --p) {
-            size_t li = static_cast<size_t>(p - min_price_);
-            if (bids_[li].head != OrderNode::INVALID_INDEX) {
-                best_bid_price_ = p;
-                break;
-            }
-        }
-    }
+    nodes_.price(idx) = u.price;
+    nodes_.qty(idx)   = u.qty;
 
-    if (node.side == OrderSide::Ask && node.price == best_ask_price_) {
-        for (int64_t p = best_ask_price_; p <= max_price_; ++p) {
-            size_t li = static_cast<size_t>(p - min_price_);
-            if (asks_[li].head != OrderNode::INVALID_INDEX) {
-                best_ask_price_ = p;
-                break;
-            }
-        }
-    }
+    linkNode(idx);
+}
+
+void OrderBook::cancelOrder(const MarketUpdate& u) {
+    uint32_t idx = findId(u.order_id);
+    if (idx == OrderNode::INVALID_INDEX) return;
+
+    unlinkNode(idx);
 
     freeNode(idx);
-    id_to_index_[u.order_id] = OrderNode::INVALID_INDEX;
+    unbindId(u.order_id);
 }
 
 void OrderBook::applyUpdate(const MarketUpdate& u) {
-    if (u.order_id >= max_orders_) return;
+    if (!features_enabled_) {
+        applyToLadder(u);
+        return;
+    }
+    num_touches_ = 0;
+    applyToLadder(u);
+    updateFeatures();
+}
+
+void OrderBook::applyToLadder(const MarketUpdate& u) {
+    if (hashed_ids_ ? u.order_id == OrderIdMap::EMPTY_KEY
+                    : u.order_id >= max_orders_) return;
 
     // Cancel uses node.price (not u.price), so skip the range check for it.
     if (u.type == UpdateType::Cancel) {
@@ -224,7 +320,9 @@ void OrderBook::applyUpdate(const MarketUpdate& u) {
         return;
     }
 
-    if (u.price < min_price_ || u.price > max_price_) return;
+    if (u.price < min_price_ || u.price > max_price_) {
+        if (!sliding_ || !recenter(u.price)) return;
+    }
 
     switch (u.type) {
         case UpdateType::Add:    insertOrder(u); break;
@@ -238,39 +336,214 @@ bool OrderBook::getBestBid(PriceLevel& out) const {
         return false;
     }
 
-    int64_t p = best_bid_price_;
-    while (p >= min_price_) {
-        size_t idx = static_cast<size_t>(p - min_price_);
-        const PriceLevel& lvl = bids_[idx];
+    out = bids_[slotOf(best_bid_price_)];
+    out.price = best_bid_price_;
+    return true;
+}
 
-        if (lvl.head != OrderNode::INVALID_INDEX) {
-            out = lvl;
-            out.price = p;
-            return true;
+bool OrderBook::getBestAsk(PriceLevel& out) const {
+    if (best_ask_price_ > max_price_) {
+        return false;
+    }
+
+    out = asks_[slotOf(best_ask_price_)];
+    out.price = best_ask_price_;
+    return true;
+}
+
+size_t OrderBook::getDepth(OrderSide side, size_t n,
+                           int64_t* price_out, int64_t* qty_out) const {
+    size_t k = 0;
+    if (side == OrderSide::Bid) {
+        for (int64_t p = best_bid_price_; k < n && p >= min_price_; ) {
+            price_out[k] = p;
+            qty_out[k]   = bids_[slotOf(p)].total_qty;
+            ++k;
+            if (p == min_price_) break;
+            p = prevOccupied(bid_levels_, p - 1);
+        }
+    } else {
+        for (int64_t p = best_ask_price_; k < n && p <= max_price_; ) {
+            price_out[k] = p;
+            qty_out[k]   = asks_[slotOf(p)].total_qty;
+            ++k;
+            if (p == max_price_) break;
+            p = nextOccupied(ask_levels_, p + 1);
+        }
+    }
+    return k;
+}
+
+void OrderBook::snapshotOrders(std::vector<BookOrder>& out) const {
+    auto append_level = [&](const PriceLevel& level) {
+        for (uint32_t idx = level.head; idx != OrderNode::INVALID_INDEX; idx = nodes_.next(idx)) {
+            out.push_back({nodes_.orderId(idx), nodes_.price(idx), nodes_.qty(idx),
+                           nodes_.side(idx), {}});
         }
-        --p;
+    };
+    for (int64_t p = best_bid_price_; p >= min_price_; ) {
+        append_level(bids_[slotOf(p)]);
+        if (p == min_price_) break;
+        p = prevOccupied(bid_levels_, p - 1);
     }
+    for (int64_t p = best_ask_price_; p <= max_price_; ) {
+        append_level(asks_[slotOf(p)]);
+        if (p == max_price_) break;
+        p = nextOccupied(ask_levels_, p + 1);
+    }
+}
 
-    return false;
+void OrderBook::restoreOrders(const BookOrder* orders, size_t n) {
+    MarketUpdate u{};
+    u.type = UpdateType::Add;
+    for (size_t i = 0; i < n; ++i) {
+        u.order_id = orders[i].order_id;
+        u.price    = orders[i].price;
+        u.qty      = orders[i].qty;
+        u.side     = orders[i].side;
+        applyUpdate(u);
+    }
 }
 
-bool OrderBook::getBestAsk(PriceLevel& out) const {
-    if (best_ask_price_ > max_price_) {
+bool OrderBook::copyStateFrom(const OrderBook& other) {
+    if (&other == this) return true;
+    if (num_levels_ != other.num_levels_ || max_orders_ != other.max_orders_
+        || hashed_ids_ != other.hashed_ids_) {
         return false;
     }
+    std::copy(other.bids_, other.bids_ + num_levels_, bids_);
+    std::copy(other.asks_, other.asks_ + num_levels_, asks_);
+    nodes_.copyFrom(other.nodes_, max_orders_);
+    if (hashed_ids_) id_map_ = other.id_map_;
+    else             id_to_index_ = other.id_to_index_;
+    bid_levels_ = other.bid_levels_;
+    ask_levels_ = other.ask_levels_;
+
+    min_price_        = other.min_price_;
+    max_price_        = other.max_price_;
+    origin_slot_      = other.origin_slot_;
+    sliding_          = other.sliding_;
+    evicted_orders_   = other.evicted_orders_;
+    free_head_        = other.free_head_;
+    best_bid_price_   = other.best_bid_price_;
+    best_ask_price_   = other.best_ask_price_;
+    features_enabled_ = other.features_enabled_;
+    features_dirty_   = other.features_dirty_;
+    depth_levels_     = other.depth_levels_;
+    depth_floor_bid_  = other.depth_floor_bid_;
+    depth_floor_ask_  = other.depth_floor_ask_;
+    num_touches_      = other.num_touches_;
+    std::copy(std::begin(other.touches_), std::end(other.touches_), touches_);
+    features_         = other.features_;
+    return true;
+}
+
+void OrderBook::enableFeatures(size_t depth_levels) {
+    features_enabled_ = true;
+    depth_levels_     = depth_levels ? depth_levels : 1;
+    features_         = BookFeatures{};
+    features_dirty_   = true;
+    num_touches_      = 0;
+    updateFeatures();
+}
+
+void OrderBook::touch(OrderSide side, int64_t price, int64_t qty_delta,
+                      bool level_set_changed) noexcept {
+    touches_[num_touches_++] = {price, qty_delta, side, level_set_changed};
+}
 
-    int64_t p = best_ask_price_;
-    while (p <= max_price_) {
-        size_t idx = static_cast<size_t>(p - min_price_);
-        const PriceLevel& lvl = asks_[idx];
+void OrderBook::recomputeDepth(OrderSide side) {
+    int64_t qty = 0;
+    size_t  k   = 0;
+    if (side == OrderSide::Bid) {
+        int64_t floor = min_price_ - 1;
+        for (int64_t p = best_bid_price_; k < depth_levels_ && p >= min_price_; ) {
+            qty  += bids_[slotOf(p)].total_qty;
+            floor = p;
+            ++k;
+            if (p == min_price_) break;
+            p = prevOccupied(bid_levels_, p - 1);
+        }
+        features_.depth_bid_qty = qty;
+        depth_floor_bid_ = (k >= depth_levels_) ? floor : min_price_ - 1;
+    } else {
+        int64_t floor = max_price_ + 1;
+        for (int64_t p = best_ask_price_; k < depth_levels_ && p <= max_price_; ) {
+            qty  += asks_[slotOf(p)].total_qty;
+            floor = p;
+            ++k;
+            if (p == max_price_) break;
+            p = nextOccupied(ask_levels_, p + 1);
+        }
+        features_.depth_ask_qty = qty;
+        depth_floor_ask_ = (k >= depth_levels_) ? floor : max_price_ + 1;
+    }
+}
 
-        if (lvl.head != OrderNode::INVALID_INDEX) {
-            out = lvl;
-            out.price = p;
-            return true;
+void OrderBook::updateFeatures() {
+    BookFeatures& f = features_;
+    const int64_t old_bid_depth = f.depth_bid_qty;
+    const int64_t old_ask_depth = f.depth_ask_qty;
+
+    // Depth over the top N levels: touches below the Nth level are ignored,
+    // qty changes on an existing level inside the window are applied as a
+    // delta, and only a level appearing/disappearing inside it re-walks.
+    if (features_dirty_) {
+        recomputeDepth(OrderSide::Bid);
+        recomputeDepth(OrderSide::Ask);
+        features_dirty_ = false;
+    } else {
+        bool rewalk_bid = false, rewalk_ask = false;
+        for (uint8_t i = 0; i < num_touches_; ++i) {
+            const LevelTouch& t = touches_[i];
+            if (t.side == OrderSide::Bid) {
+                if (t.price < depth_floor_bid_) continue;
+                if (t.level_set_changed) rewalk_bid = true;
+                else                     f.depth_bid_qty += t.qty_delta;
+            } else {
+                if (t.price > depth_floor_ask_) continue;
+                if (t.level_set_changed) rewalk_ask = true;
+                else                     f.depth_ask_qty += t.qty_delta;
+            }
         }
-        ++p;
+        if (rewalk_bid) recomputeDepth(OrderSide::Bid);
+        if (rewalk_ask) recomputeDepth(OrderSide::Ask);
     }
 
-    return false;
+    if (f.depth_bid_qty != old_bid_depth || f.depth_ask_qty != old_ask_depth) {
+        const int64_t total = f.depth_bid_qty + f.depth_ask_qty;
+        f.depth_imbalance = total > 0
+            ? (double)(f.depth_bid_qty - f.depth_ask_qty) / (double)total
+            : 0.0;
+    }
+
+    // BBO: best prices are cached, so this is two level loads.
+    const bool    has_bid = best_bid_price_ >= min_price_;
+    const bool    has_ask = best_ask_price_ <= max_price_;
+    const int64_t bid_qty = has_bid ? bids_[slotOf(best_bid_price_)].total_qty : 0;
+    const int64_t ask_qty = has_ask ? asks_[slotOf(best_ask_price_)].total_qty : 0;
+    const int64_t bid_px  = has_bid ? best_bid_price_ : 0;
+    const int64_t ask_px  = has_ask ? best_ask_price_ : 0;
+
+    f.top_changed = has_bid != f.has_bid || has_ask != f.has_ask
+                 || bid_px  != f.bid_price || ask_px != f.ask_price
+                 || bid_qty != f.bid_qty   || ask_qty != f.ask_qty;
+    if (!f.top_changed) return;
+
+    f.has_bid   = has_bid;
+    f.has_ask   = has_ask;
+    f.bid_price = bid_px;
+    f.ask_price = ask_px;
+    f.bid_qty   = bid_qty;
+    f.ask_qty   = ask_qty;
+    if (has_bid && has_ask) {
+        f.spread = ask_px - bid_px;
+        const int64_t q = bid_qty + ask_qty;
+        f.microprice = q > 0
+            ? ((double)bid_px * (double)ask_qty + (double)ask_px * (double)bid_qty) / (double)q
+            : 0.5 * (double)(bid_px + ask_px);
+    } else {
+        f.spread     = 0;
+        f.microprice = 0.0;
+    }
 }
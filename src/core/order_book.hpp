@@ -1,24 +1,14 @@
 #pragma once
 
 #include "market_data.hpp"
+#include "level_bitmap.hpp"
+#include "order_id_map.hpp"
+#include "order_node_store.hpp"
 #include <cstdint>
 #include <cstddef>
 #include <limits>
 #include <vector>
 
-struct alignas(64) OrderNode {
-  uint64_t order_id;   // unique identifier
-  int64_t  price;      // price in ticks
-  int32_t  qty;        // remaining quantity
-  uint32_t next;       // index of next node in list, or INVALID_INDEX
-  uint32_t prev;       // index of prev node in list, or INVALID_INDEX
-  OrderSide side;      // bid or ask
-  uint8_t  _pad[35];   // padding to keep struct 64 bytes and aligned
-
-  static constexpr uint32_t INVALID_INDEX =
-      std::numeric_limits<uint32_t>::max();
-};
-
 struct alignas(64) PriceLevel {
   uint32_t head;  // index of first order in this level
   uint32_t tail;  // index of last order (optional but helpful)
@@ -32,11 +22,64 @@ struct alignas(64) PriceLevel {
       total_qty(0) {}
 };
 
+// Ladder that covers `width_ticks` levels around `center_price` and slides
+// with the market: an Add/Modify outside the window re-centres it on the
+// current mid, evicting orders on levels that fall off the far edge. Updates
+// further than width_ticks/2 from the mid are dropped.
+struct SlidingWindow {
+    int64_t center_price;
+    size_t  width_ticks;
+};
+
+// Top-of-book features kept current by applyUpdate once
+// OrderBook::enableFeatures() has been called. Strategies read them for free;
+// one that only reacts to the BBO can return early when !top_changed.
+struct BookFeatures {
+    bool    has_bid         = false;
+    bool    has_ask         = false;
+    bool    top_changed     = false; // best price or best-level qty changed by the last update
+    int64_t bid_price       = 0;
+    int64_t ask_price       = 0;
+    int64_t bid_qty         = 0;     // total qty at the best bid
+    int64_t ask_qty         = 0;
+    int64_t spread          = 0;     // ask_price - bid_price (two-sided book only)
+    double  microprice      = 0.0;   // qty-weighted mid (two-sided book only)
+    int64_t depth_bid_qty   = 0;     // total qty over the top depth_levels bid levels
+    int64_t depth_ask_qty   = 0;
+    double  depth_imbalance = 0.0;   // (depth_bid - depth_ask) / (depth_bid + depth_ask)
+};
+
+// One resting order, as written by OrderBook::snapshotOrders.
+struct BookOrder {
+    uint64_t  order_id;
+    int64_t   price;
+    int32_t   qty;
+    OrderSide side;
+    uint8_t   _pad[3];
+};
+static_assert(sizeof(BookOrder) == 24, "BookOrder is stored in checkpoint files");
+
+// How order_id is mapped to a node index.
+//   Dense  — vector indexed by order_id; IDs must be < max_orders.
+//   Hashed — OrderIdMap; any 64-bit ID except UINT64_MAX, at most
+//            max_orders live at once.
+enum class OrderIdIndex : uint8_t {
+    Dense,
+    Hashed
+};
+
 class OrderBook {
 public:
+    // Dense ladder: one PriceLevel per tick in [min_price, max_price].
     OrderBook(int64_t min_price,
               int64_t max_price,
-              size_t   max_orders);
+              size_t   max_orders,
+              OrderIdIndex id_index = OrderIdIndex::Dense);
+
+    // Ring of width_ticks slots that re-centres as prices drift.
+    OrderBook(SlidingWindow window,
+              size_t        max_orders,
+              OrderIdIndex  id_index = OrderIdIndex::Dense);
 
     ~OrderBook();
 
@@ -50,22 +93,114 @@ public:
     [[nodiscard]] bool getBestBid(PriceLevel& out) const;
     [[nodiscard]] bool getBestAsk(PriceLevel& out) const;
 
+    // Top-of-book depth: writes up to n non-empty levels of `side`, best
+    // first, as parallel price/qty arrays. Walks the occupancy bitmap, so
+    // empty ticks between levels cost nothing. Returns the number written.
+    size_t getDepth(OrderSide side, size_t n,
+                    int64_t* price_out, int64_t* qty_out) const;
+
+    // Start maintaining BookFeatures; depth imbalance covers the top
+    // `depth_levels` levels per side.
+    void enableFeatures(size_t depth_levels);
+    bool featuresEnabled() const noexcept { return features_enabled_; }
+    const BookFeatures& features() const noexcept { return features_; }
+
+    // Appends every resting order to `out`: bids best-first, then asks
+    // best-first, each level in queue order. restoreOrders() on an empty dense
+    // book built with the same arguments rebuilds the same levels, queues and
+    // features. A sliding window re-centres on the restored orders, so its
+    // bounds may differ. Live order IDs are assumed unique: if an ID was
+    // re-added, the restore may bind it to the other node. Statistics such as
+    // evictedOrders() are not carried over.
+    void snapshotOrders(std::vector<BookOrder>& out) const;
+    void restoreOrders(const BookOrder* orders, size_t n);
+
+    // Exact copy of `other`'s state: node, level and order-ID arrays,
+    // occupancy bitmaps, window position, features and statistics, so the
+    // two books then evolve identically. Costs a memcpy of every array
+    // (about BYTES_PER_NODE * max_orders), independent of how many orders
+    // rest. Returns false, leaving this book untouched, unless both were
+    // built with the same ladder size, max_orders and ID index.
+    bool copyStateFrom(const OrderBook& other);
+
+    // Current ladder bounds (fixed for a dense ladder).
+    int64_t  minPrice() const noexcept { return min_price_; }
+    int64_t  maxPrice() const noexcept { return max_price_; }
+    size_t   maxOrders() const noexcept { return max_orders_; }
+    OrderIdIndex idIndex() const noexcept {
+        return hashed_ids_ ? OrderIdIndex::Hashed : OrderIdIndex::Dense;
+    }
+    // Orders dropped because their level slid out of the window.
+    uint64_t evictedOrders() const noexcept { return evicted_orders_; }
+
 private:
     int64_t min_price_;
     int64_t max_price_;
     size_t  num_levels_;
+    // Ladder slot holding min_price_. Always 0 for a dense ladder; a
+    // sliding window rotates it instead of moving PriceLevels.
+    size_t  origin_slot_ = 0;
+    bool    sliding_     = false;
+    uint64_t evicted_orders_ = 0;
     size_t  max_orders_;
     PriceLevel* bids_;
     PriceLevel* asks_;
-    OrderNode* nodes_;
+    NodeStore  nodes_;
     uint32_t free_head_;
-    std::vector<uint32_t> id_to_index_;
-    int64_t best_bid_price_;
-    int64_t best_ask_price_;
+    bool    hashed_ids_;
+    std::vector<uint32_t> id_to_index_;   // OrderIdIndex::Dense
+    OrderIdMap            id_map_;        // OrderIdIndex::Hashed
+    // Occupancy of bids_/asks_ (one bit per level) so the next best level
+    // is found with a few bit scans instead of walking the ladder.
+    LevelBitmap bid_levels_;
+    LevelBitmap ask_levels_;
+    int64_t best_bid_price_;   // min_price_ - 1 when no bids
+    int64_t best_ask_price_;   // max_price_ + 1 when no asks
+
+    // Feature maintenance. insert/modify/cancel record which levels they
+    // touched; only touches inside the top-N window (or ones that add or
+    // remove a level there) cost a depth re-walk.
+    struct LevelTouch {
+        int64_t   price;
+        int64_t   qty_delta;
+        OrderSide side;
+        bool      level_set_changed;  // level was created or emptied
+    };
+    bool         features_enabled_ = false;
+    bool         features_dirty_   = false;
+    size_t       depth_levels_     = 0;
+    int64_t      depth_floor_bid_  = 0;  // price of the Nth bid level, or min_price_ - 1
+    int64_t      depth_floor_ask_  = 0;  // price of the Nth ask level, or max_price_ + 1
+    uint8_t      num_touches_      = 0;
+    LevelTouch   touches_[2];
+    BookFeatures features_;
+
+    void touch(OrderSide side, int64_t price, int64_t qty_delta, bool level_set_changed) noexcept;
+    void recomputeDepth(OrderSide side);
+    void updateFeatures();
+    void applyToLadder(const MarketUpdate& u);
 
     uint32_t allocNode();
     void     freeNode(uint32_t idx);
 
+    uint32_t findId(uint64_t order_id) const noexcept;
+    bool     bindId(uint64_t order_id, uint32_t idx) noexcept;   // false: ID not stored
+    void     unbindId(uint64_t order_id) noexcept;
+
+    size_t  slotOf(int64_t price) const noexcept;
+    int64_t priceOf(size_t slot) const noexcept;
+    // Nearest occupied level inside the window, walking the ring from
+    // `price`; returns min_price_ - 1 / max_price_ + 1 when there is none.
+    int64_t prevOccupied(const LevelBitmap& levels, int64_t price) const noexcept;
+    int64_t nextOccupied(const LevelBitmap& levels, int64_t price) const noexcept;
+
+    void linkNode(uint32_t idx);    // append to the tail of node's level
+    void unlinkNode(uint32_t idx);  // O(1) unlink, refreshes best price
+
+    bool recenter(int64_t price);
+    void evictRange(int64_t lo, int64_t hi);
+    void evictLevels(PriceLevel* levels, LevelBitmap& occupied, int64_t lo, int64_t hi);
+
     void insertOrder(const MarketUpdate& u);
     void modifyOrder(const MarketUpdate& u);
     void cancelOrder(const MarketUpdate& u);
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// OrderIdMap
+//
+// Open-addressing hash map from 64-bit exchange order IDs to node indices.
+//
+//   - power-of-two table, sized once for at most `max_entries` live keys at a
+//     load factor <= 0.5, so the hot path never rehashes or allocates
+//   - Fibonacci (multiplicative) hashing: sequential and strided IDs spread
+//     evenly across the table
+//   - linear probing over 16-byte slots, 4 per cache line
+//   - backward-shift deletion: erase pulls later entries of the probe chain
+//     into the hole, so there are no tombstones and probe lengths do not
+//     degrade over a session of add/cancel churn
+//
+// EMPTY_KEY (UINT64_MAX) marks a free slot and cannot be stored.
+// ---------------------------------------------------------------------------
+class OrderIdMap {
+public:
+    static constexpr uint64_t EMPTY_KEY = std::numeric_limits<uint64_t>::max();
+    static constexpr uint32_t NOT_FOUND = std::numeric_limits<uint32_t>::max();
+
+    explicit OrderIdMap(size_t max_entries = 0) {
+        size_t cap = 16;
+        while (cap < max_entries * 2) cap <<= 1;
+        slots_.assign(cap, Slot{EMPTY_KEY, NOT_FOUND});
+        mask_  = cap - 1;
+        shift_ = 64 - static_cast<unsigned>(std::countr_zero(cap));
+    }
+
+    size_t size()     const noexcept { return size_; }
+    size_t capacity() const noexcept { return slots_.size(); }
+
+    uint32_t find(uint64_t key) const noexcept {
+        for (size_t i = home(key);; i = (i + 1) & mask_) {
+            const Slot& s = slots_[i];
+            if (s.key == key)       return s.value;
+            if (s.key == EMPTY_KEY) return NOT_FOUND;
+        }
+    }
+
+    // Inserts or overwrites. Returns false if the key is reserved or the
+    // table is at its sizing limit.
+    bool insert(uint64_t key, uint32_t value) noexcept {
+        if (key == EMPTY_KEY) return false;
+        for (size_t i = home(key);; i = (i + 1) & mask_) {
+            Slot& s = slots_[i];
+            if (s.key == key) {
+                s.value = value;
+                return true;
+            }
+            if (s.key == EMPTY_KEY) {
+                if (size_ * 2 >= slots_.size()) return false;
+                s.key   = key;
+                s.value = value;
+                ++size_;
+                return true;
+            }
+        }
+    }
+
+    void erase(uint64_t key) noexcept {
+        size_t i = home(key);
+        for (;; i = (i + 1) & mask_) {
+            if (slots_[i].key == key)       break;
+            if (slots_[i].key == EMPTY_KEY) return;
+        }
+
+        // Backward-shift: walk the rest of the cluster and move back any
+        // entry whose home slot is not cyclically inside (hole, j].
+        size_t hole = i;
+        for (size_t j = (i + 1) & mask_; slots_[j].key != EMPTY_KEY; j = (j + 1) & mask_) {
+            const size_t h = home(slots_[j].key);
+            if (((j - h) & mask_) >= ((j - hole) & mask_)) {
+                slots_[hole] = slots_[j];
+                hole = j;
+            }
+        }
+        slots_[hole] = Slot{EMPTY_KEY, NOT_FOUND};
+        --size_;
+    }
+
+    void clear() noexcept {
+        slots_.assign(slots_.size(), Slot{EMPTY_KEY, NOT_FOUND});
+        size_ = 0;
+    }
+
+private:
+    struct Slot {
+        uint64_t key;
+        uint32_t value;
+    };
+
+    size_t home(uint64_t key) const noexcept {
+        return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> shift_);
+    }
+
+    std::vector<Slot> slots_;
+    size_t            mask_  = 0;
+    unsigned          shift_ = 0;
+    size_t            size_  = 0;
+};
@@ -0,0 +1,149 @@
+#pragma once
+
+#include "market_data.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <new>
+
+// ---------------------------------------------------------------------------
+// Order node storage for OrderBook.
+//
+// Both stores expose the same per-field accessors (qty/next/prev are the hot
+// fields touched by every unlink and qty update; order_id/price/side are
+// written on insert and read on unlink/evict). OrderBook is written against
+// that interface and `NodeStore` picks the layout at compile time:
+//
+//   AosNodeStore  (default)            one 64-byte OrderNode per order
+//   SoaNodeStore  (TRADING_SPLIT_ORDER_NODES)
+//                                      qty[] / next[] / prev[] dense parallel
+//                                      arrays + a 24-byte cold record
+// ---------------------------------------------------------------------------
+
+struct alignas(64) OrderNode {
+  uint64_t order_id;   // unique identifier
+  int64_t  price;      // price in ticks
+  int32_t  qty;        // remaining quantity
+  uint32_t next;       // index of next node in list, or INVALID_INDEX
+  uint32_t prev;       // index of prev node in list, or INVALID_INDEX
+  OrderSide side;      // bid or ask
+  uint8_t  _pad[35];   // padding to keep struct 64 bytes and aligned
+
+  static constexpr uint32_t INVALID_INDEX =
+      std::numeric_limits<uint32_t>::max();
+};
+
+class AosNodeStore {
+public:
+    static constexpr size_t BYTES_PER_NODE = sizeof(OrderNode);
+    static constexpr const char* NAME = "aos";
+
+    explicit AosNodeStore(size_t n) : nodes_(new OrderNode[n]) {}
+    ~AosNodeStore() { delete[] nodes_; }
+
+    AosNodeStore(const AosNodeStore&)            = delete;
+    AosNodeStore& operator=(const AosNodeStore&) = delete;
+
+    // Copies nodes [0, n) of a store of at least n nodes.
+    void copyFrom(const AosNodeStore& other, size_t n) noexcept {
+        std::memcpy(nodes_, other.nodes_, sizeof(OrderNode) * n);
+    }
+
+    uint64_t&  orderId(uint32_t i) noexcept { return nodes_[i].order_id; }
+    int64_t&   price(uint32_t i)   noexcept { return nodes_[i].price; }
+    int32_t&   qty(uint32_t i)     noexcept { return nodes_[i].qty; }
+    uint32_t&  next(uint32_t i)    noexcept { return nodes_[i].next; }
+    uint32_t&  prev(uint32_t i)    noexcept { return nodes_[i].prev; }
+    OrderSide& side(uint32_t i)    noexcept { return nodes_[i].side; }
+
+    uint64_t  orderId(uint32_t i) const noexcept { return nodes_[i].order_id; }
+    int64_t   price(uint32_t i)   const noexcept { return nodes_[i].price; }
+    int32_t   qty(uint32_t i)     const noexcept { return nodes_[i].qty; }
+    uint32_t  next(uint32_t i)    const noexcept { return nodes_[i].next; }
+    uint32_t  prev(uint32_t i)    const noexcept { return nodes_[i].prev; }
+    OrderSide side(uint32_t i)    const noexcept { return nodes_[i].side; }
+
+private:
+    OrderNode* nodes_;
+};
+
+// Fields only needed on insert, on unlink (to find the level) and on evict.
+struct OrderNodeCold {
+    uint64_t  order_id;
+    int64_t   price;
+    OrderSide side;
+};
+
+class SoaNodeStore {
+public:
+    static constexpr size_t BYTES_PER_NODE =
+        sizeof(int32_t) + 2 * sizeof(uint32_t) + sizeof(OrderNodeCold);
+    static constexpr const char* NAME = "soa";
+
+    explicit SoaNodeStore(size_t n)
+        : qty_(alloc<int32_t>(n))
+        , next_(alloc<uint32_t>(n))
+        , prev_(alloc<uint32_t>(n))
+        , cold_(alloc<OrderNodeCold>(n))
+    {
+        // Touch every page up front so the hot path never takes a first-use
+        // page fault (AosNodeStore gets this from the free-list build).
+        std::memset(qty_,  0, sizeof(int32_t) * n);
+        std::memset(next_, 0, sizeof(uint32_t) * n);
+        std::memset(prev_, 0, sizeof(uint32_t) * n);
+        std::memset(cold_, 0, sizeof(OrderNodeCold) * n);
+    }
+
+    ~SoaNodeStore() {
+        release(qty_);
+        release(next_);
+        release(prev_);
+        release(cold_);
+    }
+
+    SoaNodeStore(const SoaNodeStore&)            = delete;
+    SoaNodeStore& operator=(const SoaNodeStore&) = delete;
+
+    void copyFrom(const SoaNodeStore& other, size_t n) noexcept {
+        std::memcpy(qty_,  other.qty_,  sizeof(int32_t) * n);
+        std::memcpy(next_, other.next_, sizeof(uint32_t) * n);
+        std::memcpy(prev_, other.prev_, sizeof(uint32_t) * n);
+        std::memcpy(cold_, other.cold_, sizeof(OrderNodeCold) * n);
+    }
+
+    uint64_t&  orderId(uint32_t i) noexcept { return cold_[i].order_id; }
+    int64_t&   price(uint32_t i)   noexcept { return cold_[i].price; }
+    int32_t&   qty(uint32_t i)     noexcept { return qty_[i]; }
+    uint32_t&  next(uint32_t i)    noexcept { return next_[i]; }
+    uint32_t&  prev(uint32_t i)    noexcept { return prev_[i]; }
+    OrderSide& side(uint32_t i)    noexcept { return cold_[i].side; }
+
+    uint64_t  orderId(uint32_t i) const noexcept { return cold_[i].order_id; }
+    int64_t   price(uint32_t i)   const noexcept { return cold_[i].price; }
+    int32_t   qty(uint32_t i)     const noexcept { return qty_[i]; }
+    uint32_t  next(uint32_t i)    const noexcept { return next_[i]; }
+    uint32_t  prev(uint32_t i)    const noexcept { return prev_[i]; }
+    OrderSide side(uint32_t i)    const noexcept { return cold_[i].side; }
+
+private:
+    template <typename T>
+    static T* alloc(size_t n) {
+        return static_cast<T*>(::operator new[](sizeof(T) * n, std::align_val_t(64)));
+    }
+    template <typename T>
+    static void release(T* p) {
+        ::operator delete[](p, std::align_val_t(64));
+    }
+
+    int32_t*       qty_;
+    uint32_t*      next_;
+    uint32_t*      prev_;
+    OrderNodeCold* cold_;
+};
+
+#ifdef TRADING_SPLIT_ORDER_NODES
+using NodeStore = SoaNodeStore;
+#else
+using NodeStore = AosNodeStore;
+#endif
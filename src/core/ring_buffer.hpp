@@ -1,4 +1,5 @@
 #pragma once
+#include <algorithm>
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
@@ -7,7 +8,9 @@
 #include <cassert>
 #include <type_traits>
 #include <cstring>
+#include <span>
 #include "market_data.hpp"
+#include "wait_strategy.hpp"
 
 template<typename T>
 class SpscRing {
@@ -30,16 +33,25 @@ public:
         ::operator delete[](buffer_, std::align_val_t(64));
     }
 
+    // Each side keeps a private copy of the other side's index (cached_tail_
+    // for the producer, cached_head_ for the consumer) and only reloads the
+    // shared atomic when that copy says the ring is too full / too empty for
+    // the request. While the ring is neither, a push or pop touches no cache
+    // line the other core is writing.
+
     bool push(const T& item)
     {
         const size_t head = head_.load(std::memory_order_relaxed);
         const size_t next_head = head + 1;
-        const size_t tail = tail_.load(std::memory_order_acquire);
-        if(next_head - tail > capacity_) {
-            return false; // Queue is full
+        if (next_head - cached_tail_ > capacity_) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (next_head - cached_tail_ > capacity_) {
+                return false; // Queue is full
+            }
         }
         std::memcpy(&buffer_[head & mask_], &item, sizeof(T));
         head_.store(next_head, std::memory_order_release);
+        if (doorbell_) doorbell_->ring();
         return true;
     }
 
@@ -47,25 +59,136 @@ public:
     {
         const size_t head = head_.load(std::memory_order_relaxed);
         const size_t next = head + 1;
-        const size_t tail = tail_.load(std::memory_order_acquire);
-        if ((next - tail) > capacity_) return false; // full
+        if ((next - cached_tail_) > capacity_) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if ((next - cached_tail_) > capacity_) return false; // full
+        }
         std::memcpy(&buffer_[head & mask_], &item, sizeof(T));
         head_.store(next, std::memory_order_release);
+        if (doorbell_) doorbell_->ring();
         return true;
     }
 
+    // Pushes up to `count` items from `items` with a single head update.
+    // Returns how many were pushed (0 if the queue is full).
+    size_t push_bulk(const T* items, size_t count)
+    {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        size_t n = std::min(count, capacity_ - (head - cached_tail_));
+        if (n < count) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            n = std::min(count, capacity_ - (head - cached_tail_));
+            if (n == 0) return 0;
+        }
+        const size_t idx   = head & mask_;
+        const size_t first = std::min(n, capacity_ - idx);   // up to the wrap point
+        std::memcpy(&buffer_[idx], items, first * sizeof(T));
+        std::memcpy(&buffer_[0], items + first, (n - first) * sizeof(T));
+        head_.store(head + n, std::memory_order_release);
+        if (doorbell_) doorbell_->ring();
+        return n;
+    }
+
+    size_t push_bulk(std::span<const T> items)
+    {
+        return push_bulk(items.data(), items.size());
+    }
+
+    // In-place producer API: up to `n` free slots starting at the write
+    // position, contiguous in the buffer (a claim never crosses its end).
+    // Fill them, then commit(k) publishes the first k. Empty while full.
+    // No push may run between claim and commit.
+    std::span<T> claim(size_t n)
+    {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (capacity_ - (head - cached_tail_) < n) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+        }
+        const size_t idx = head & mask_;
+        n = std::min({n, capacity_ - (head - cached_tail_), capacity_ - idx});
+        return {&buffer_[idx], n};
+    }
+
+    void commit(size_t n)
+    {
+        head_.store(head_.load(std::memory_order_relaxed) + n, std::memory_order_release);
+        if (doorbell_) doorbell_->ring();
+    }
+
+    // Producer-side wakeup for consumers that park (WaitStrategy::Kind::Park):
+    // every publish after this rings `bell`. Set before the producer starts.
+    void set_doorbell(Doorbell* bell) { doorbell_ = bell; }
+
+    // End of stream: the producer publishes nothing after close(). A
+    // consumer that reads closed() == true and then finds the ring empty has
+    // seen every item (close() is ordered after the last publish).
+    void close()
+    {
+        closed_.store(true, std::memory_order_release);
+        if (doorbell_) doorbell_->ring();
+    }
+
+    bool closed() const { return closed_.load(std::memory_order_acquire); }
+
+    // The most a claim can return right now: slots from the write position
+    // to the end of the buffer.
+    size_t claim_limit() const
+    {
+        return capacity_ - (head_.load(std::memory_order_relaxed) & mask_);
+    }
+
     bool pop(T& out)
     {
         const size_t tail = tail_.load(std::memory_order_relaxed);
-        const size_t head = head_.load(std::memory_order_acquire);
-        if(tail == head) {
-            return false; // Queue is empty
+        if (tail == cached_head_) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail == cached_head_) {
+                return false; // Queue is empty
+            }
         }
         out = std::move(buffer_[tail & mask_]);
         tail_.store(tail + 1, std::memory_order_release);
         return true;
     }
 
+    // Pops up to out.size() items into `out` with a single tail update.
+    // Returns how many were popped (0 if the queue is empty).
+    size_t pop_bulk(std::span<T> out)
+    {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t n = std::min(out.size(), cached_head_ - tail);
+        if (n < out.size()) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            n = std::min(out.size(), cached_head_ - tail);
+            if (n == 0) return 0;
+        }
+        const size_t idx   = tail & mask_;
+        const size_t first = std::min(n, capacity_ - idx);   // up to the wrap point
+        std::memcpy(out.data(), &buffer_[idx], first * sizeof(T));
+        std::memcpy(out.data() + first, &buffer_[0], (n - first) * sizeof(T));
+        tail_.store(tail + n, std::memory_order_release);
+        return n;
+    }
+
+    // In-place consumer API: up to `n` published items starting at the read
+    // position, contiguous in the buffer. They stay valid, and are not
+    // overwritten, until release(k) hands the first k back to the producer.
+    std::span<const T> peek(size_t n)
+    {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (cached_head_ - tail < n) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+        }
+        const size_t idx = tail & mask_;
+        n = std::min({n, cached_head_ - tail, capacity_ - idx});
+        return {&buffer_[idx], n};
+    }
+
+    void release(size_t n)
+    {
+        tail_.store(tail_.load(std::memory_order_relaxed) + n, std::memory_order_release);
+    }
+
     void reset()
     {
         size_t head = head_.load(std::memory_order_relaxed);
@@ -76,6 +199,9 @@ public:
         }
         head_.store(0, std::memory_order_relaxed);
         tail_.store(0, std::memory_order_relaxed);
+        cached_head_ = 0;
+        cached_tail_ = 0;
+        closed_.store(false, std::memory_order_relaxed);
     }
 
     size_t size() const
@@ -90,6 +216,11 @@ private:
     const size_t capacity_;
     const size_t mask_;
     T* buffer_;
+    // Each index shares its line with the owning side's cache of the other.
     alignas(64) std::atomic<size_t> head_;
+    size_t cached_tail_ = 0;   // producer only
+    Doorbell* doorbell_ = nullptr;   // producer only
+    std::atomic<bool> closed_{false};   // written once, by the producer
     alignas(64) std::atomic<size_t> tail_;
+    size_t cached_head_ = 0;   // consumer only
 };
\ No newline at end of file
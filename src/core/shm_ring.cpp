@@ -0,0 +1,232 @@
+#include "shm_ring.hpp"
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <iostream>
+#include <new>
+#include <utility>
+
+namespace {
+
+constexpr std::size_t HUGE_PAGE = 2u << 20;
+
+std::size_t round_up(std::size_t n, std::size_t to) {
+    return (n + to - 1) / to * to;
+}
+
+std::size_t data_offset() {
+    return round_up(sizeof(ShmRingHeader), 64);
+}
+
+} // namespace
+
+ShmRing::~ShmRing() {
+    reset();
+}
+
+ShmRing::ShmRing(ShmRing&& other) noexcept {
+    *this = std::move(other);
+}
+
+ShmRing& ShmRing::operator=(ShmRing&& other) noexcept {
+    if (this != &other) {
+        reset();
+        header_      = std::exchange(other.header_, nullptr);
+        slots_       = std::exchange(other.slots_, nullptr);
+        capacity_    = other.capacity_;
+        mask_        = other.mask_;
+        map_bytes_   = other.map_bytes_;
+        producer_    = other.producer_;
+        path_        = std::move(other.path_);
+        hugetlbfs_   = other.hugetlbfs_;
+        cached_tail_ = other.cached_tail_;
+        cached_head_ = other.cached_head_;
+    }
+    return *this;
+}
+
+void ShmRing::detach() {
+    reset();
+}
+
+#ifdef _WIN32
+
+ShmRing ShmRing::create(const char*, std::size_t, const ShmRingOptions&) {
+    std::cerr << "ShmRing: shared-memory rings need POSIX shm_open\n";
+    return {};
+}
+
+ShmRing ShmRing::attach(const char*, Resume, const ShmRingOptions&) {
+    std::cerr << "ShmRing: shared-memory rings need POSIX shm_open\n";
+    return {};
+}
+
+void ShmRing::reset() noexcept {}
+
+#else  // POSIX
+
+namespace {
+
+// shm_open names are "/name"; a hugetlbfs segment is a file of that name.
+std::string segment_path(const char* name, const ShmRingOptions& opts) {
+    std::string base = (name[0] == '/') ? name + 1 : name;
+    if (opts.hugetlbfs_dir) return std::string(opts.hugetlbfs_dir) + "/" + base;
+    return "/" + base;
+}
+
+int open_segment(const std::string& path, const ShmRingOptions& opts, int flags) {
+    if (opts.hugetlbfs_dir) return ::open(path.c_str(), flags | O_CLOEXEC, 0600);
+    return ::shm_open(path.c_str(), flags, 0600);
+}
+
+void unlink_segment(const std::string& path, bool hugetlbfs) {
+    if (hugetlbfs) ::unlink(path.c_str());
+    else           ::shm_unlink(path.c_str());
+}
+
+void* map_segment(int fd, std::size_t bytes, const ShmRingOptions& opts) {
+    int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+    if (opts.populate) flags |= MAP_POPULATE;
+#endif
+    void* p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, flags, fd, 0);
+    if (p == MAP_FAILED) return nullptr;
+#ifdef MADV_HUGEPAGE
+    // Best effort, as in MappedFile: without shmem THP this is a no-op.
+    if (opts.huge_pages && !opts.hugetlbfs_dir) ::madvise(p, bytes, MADV_HUGEPAGE);
+#endif
+    return p;
+}
+
+} // namespace
+
+ShmRing ShmRing::create(const char* name, std::size_t capacity_pow2, const ShmRingOptions& opts) {
+    ShmRing ring;
+    if (capacity_pow2 == 0 || (capacity_pow2 & (capacity_pow2 - 1)) != 0) {
+        std::cerr << "ShmRing: capacity must be a power of 2\n";
+        return ring;
+    }
+    const std::string path = segment_path(name, opts);
+    const bool huge = opts.huge_pages || opts.hugetlbfs_dir;
+    const std::size_t page  = huge ? HUGE_PAGE : static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    const std::size_t bytes = round_up(data_offset() + capacity_pow2 * sizeof(MarketUpdate), page);
+
+    // Replace a segment left behind by a producer that did not shut down.
+    unlink_segment(path, opts.hugetlbfs_dir != nullptr);
+    const int fd = open_segment(path, opts, O_CREAT | O_EXCL | O_RDWR);
+    if (fd < 0) {
+        std::cerr << "ShmRing: cannot create " << path << "\n";
+        return ring;
+    }
+    // `bytes` is a huge-page multiple on hugetlbfs, which rejects others.
+    void* p = (::ftruncate(fd, static_cast<off_t>(bytes)) == 0) ? map_segment(fd, bytes, opts) : nullptr;
+    ::close(fd);
+    if (!p) {
+        std::cerr << "ShmRing: cannot size or map " << path << "\n";
+        unlink_segment(path, opts.hugetlbfs_dir != nullptr);
+        return ring;
+    }
+
+    auto* h = new (p) ShmRingHeader{};
+    h->magic         = ShmRingHeader::MAGIC;
+    h->version       = ShmRingHeader::VERSION;
+    h->record_size   = sizeof(MarketUpdate);
+    h->capacity      = capacity_pow2;
+    h->data_offset   = data_offset();
+    h->segment_bytes = bytes;
+    h->closed.store(0, std::memory_order_relaxed);
+    h->consumer_pid.store(0, std::memory_order_relaxed);
+    h->head.store(0, std::memory_order_relaxed);
+    h->tail.store(0, std::memory_order_relaxed);
+    h->ready.store(1, std::memory_order_release);
+
+    ring.header_    = h;
+    ring.slots_     = reinterpret_cast<MarketUpdate*>(static_cast<char*>(p) + h->data_offset);
+    ring.capacity_  = capacity_pow2;
+    ring.mask_      = capacity_pow2 - 1;
+    ring.map_bytes_ = bytes;
+    ring.producer_  = true;
+    ring.path_      = path;
+    ring.hugetlbfs_ = opts.hugetlbfs_dir != nullptr;
+    return ring;
+}
+
+ShmRing ShmRing::attach(const char* name, Resume resume, const ShmRingOptions& opts) {
+    ShmRing ring;
+    const std::string path = segment_path(name, opts);
+    const int fd = open_segment(path, opts, O_RDWR);
+    if (fd < 0) {
+        std::cerr << "ShmRing: no ring at " << path << "\n";
+        return ring;
+    }
+    struct stat st;
+    const std::size_t bytes = (::fstat(fd, &st) == 0) ? static_cast<std::size_t>(st.st_size) : 0;
+    void* p = (bytes >= sizeof(ShmRingHeader)) ? map_segment(fd, bytes, opts) : nullptr;
+    ::close(fd);
+    if (!p) {
+        std::cerr << "ShmRing: cannot map " << path << "\n";
+        return ring;
+    }
+
+    auto* h = static_cast<ShmRingHeader*>(p);
+    const bool layout_ok =
+        h->ready.load(std::memory_order_acquire) == 1 &&
+        h->magic == ShmRingHeader::MAGIC && h->version == ShmRingHeader::VERSION &&
+        h->record_size == sizeof(MarketUpdate) && h->data_offset == data_offset() &&
+        h->capacity != 0 && (h->capacity & (h->capacity - 1)) == 0 &&
+        h->segment_bytes == bytes &&
+        h->data_offset + h->capacity * sizeof(MarketUpdate) <= bytes;
+    if (!layout_ok) {
+        std::cerr << "ShmRing: " << path << " has an incompatible header\n";
+        ::munmap(p, bytes);
+        return ring;
+    }
+
+    // Take the consumer role; a previous consumer that died without
+    // detaching no longer exists as a process.
+    const std::int32_t self = static_cast<std::int32_t>(::getpid());
+    std::int32_t owner = 0;
+    while (!h->consumer_pid.compare_exchange_strong(owner, self, std::memory_order_acq_rel)) {
+        if (owner == self || ::kill(owner, 0) == 0 || errno != ESRCH) {
+            std::cerr << "ShmRing: " << path << " already has a consumer (pid " << owner << ")\n";
+            ::munmap(p, bytes);
+            return ring;
+        }
+    }
+    if (resume == Resume::Latest) {
+        h->tail.store(h->head.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    ring.header_      = h;
+    ring.slots_       = reinterpret_cast<MarketUpdate*>(static_cast<char*>(p) + h->data_offset);
+    ring.capacity_    = h->capacity;
+    ring.mask_        = h->capacity - 1;
+    ring.map_bytes_   = bytes;
+    ring.producer_    = false;
+    ring.path_        = path;
+    ring.hugetlbfs_   = opts.hugetlbfs_dir != nullptr;
+    ring.cached_head_ = h->tail.load(std::memory_order_relaxed);
+    return ring;
+}
+
+void ShmRing::reset() noexcept {
+    if (!header_) return;
+    if (producer_) {
+        unlink_segment(path_, hugetlbfs_);
+    } else {
+        std::int32_t self = static_cast<std::int32_t>(::getpid());
+        header_->consumer_pid.compare_exchange_strong(self, 0, std::memory_order_acq_rel);
+    }
+    ::munmap(header_, map_bytes_);
+    header_ = nullptr;
+    slots_  = nullptr;
+}
+
+#endif
@@ -0,0 +1,232 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+
+#include "market_data.hpp"
+
+// ---------------------------------------------------------------------------
+// ShmRing — SpscRing<MarketUpdate> in a named shared-memory segment, so the
+// producer (feed handler process) and the consumer (strategy process) can
+// be different processes.
+//
+// The segment is a header followed by the slots:
+//
+//   line 0   ShmRingHeader: magic, version, record size, capacity, layout,
+//            producer/consumer state          (written at create/attach)
+//   line 1   head                             (producer)
+//   line 2   tail                             (consumer)
+//   ...      capacity * sizeof(MarketUpdate)  (from data_offset)
+//
+// push/pop/bulk/claim/peek behave exactly as in SpscRing; each process keeps
+// its own cached copy of the other side's index. The producer creates the
+// segment and outlives consumers: a consumer attaches (at most one at a
+// time), detaches, and a new one can attach later and resume at the tail
+// its predecessor left, or skip to the newest item. A consumer that died
+// without detaching is detected by its pid and replaced.
+//
+// POSIX only; on other platforms create/attach fail (ok() is false).
+// ---------------------------------------------------------------------------
+
+struct ShmRingHeader {
+    static constexpr std::uint64_t MAGIC   = 0x474E5252484D4453ull;   // "SDMHRRNG"
+    static constexpr std::uint32_t VERSION = 1;
+
+    std::uint64_t              magic;
+    std::uint32_t              version;
+    std::uint32_t              record_size;      // sizeof(MarketUpdate)
+    std::uint64_t              capacity;         // slots, power of two
+    std::uint64_t              data_offset;      // bytes from the segment start
+    std::uint64_t              segment_bytes;
+    std::atomic<std::uint32_t> ready;            // set last by the creator
+    std::atomic<std::uint32_t> closed;           // producer published its last item
+    std::atomic<std::int32_t>  consumer_pid;     // 0: no consumer attached
+    std::uint32_t              _pad0;
+    std::uint8_t               _pad1[8];
+
+    alignas(64) std::atomic<std::uint64_t> head;
+    alignas(64) std::atomic<std::uint64_t> tail;
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free &&
+              std::atomic<std::uint32_t>::is_always_lock_free,
+              "shared-memory indices must be lock-free (address-free) atomics");
+static_assert(sizeof(ShmRingHeader) == 192, "header layout is part of the segment format");
+
+struct ShmRingOptions {
+    // Round the segment up to 2 MiB and ask for transparent huge pages
+    // (takes effect where /sys/kernel/mm/transparent_hugepage/shmem_enabled
+    // allows it).
+    bool        huge_pages    = false;
+    // Place the segment in this hugetlbfs mount (e.g. /dev/hugepages)
+    // instead of shm_open's /dev/shm; both sides must pass the same dir.
+    const char* hugetlbfs_dir = nullptr;
+    // Fault every page in at create/attach rather than on first touch.
+    bool        populate      = false;
+};
+
+class ShmRing {
+public:
+    enum class Resume {
+        Tail,     // continue from where the previous consumer stopped
+        Latest,   // drop whatever is queued
+    };
+
+    ShmRing() = default;
+    ~ShmRing();
+
+    ShmRing(ShmRing&& other) noexcept;
+    ShmRing& operator=(ShmRing&& other) noexcept;
+    ShmRing(const ShmRing&)            = delete;
+    ShmRing& operator=(const ShmRing&) = delete;
+
+    // Producer: creates (replacing any stale segment of that name) and maps
+    // the ring. The segment is removed again when the producer's ShmRing is
+    // destroyed; attached consumers keep their mapping until they detach.
+    static ShmRing create(const char* name, std::size_t capacity_pow2,
+                          const ShmRingOptions& opts = {});
+
+    // Consumer: maps an existing ring. Fails if it does not exist yet, its
+    // header does not match this build (version, record size, layout), or
+    // a live process is already attached as consumer.
+    static ShmRing attach(const char* name, Resume resume = Resume::Tail,
+                          const ShmRingOptions& opts = {});
+
+    bool ok() const noexcept { return header_ != nullptr; }
+    bool isProducer() const noexcept { return producer_; }
+    const ShmRingHeader& header() const noexcept { return *header_; }
+    std::size_t capacity() const noexcept { return capacity_; }
+
+    // Consumer: give up the consumer role and unmap. Also done by the
+    // destructor.
+    void detach();
+
+    // Producer: no more items will be pushed. Consumers see closed() once
+    // they have read everything before it.
+    void close() noexcept { header_->closed.store(1, std::memory_order_release); }
+    bool closed() const noexcept { return header_->closed.load(std::memory_order_acquire) != 0; }
+    bool consumerAttached() const noexcept {
+        return header_->consumer_pid.load(std::memory_order_acquire) != 0;
+    }
+
+    // ---- producer ------------------------------------------------------
+
+    bool push(const MarketUpdate& item) { return push_bulk(&item, 1) == 1; }
+
+    std::size_t push_bulk(const MarketUpdate* items, std::size_t count)
+    {
+        const std::uint64_t head = header_->head.load(std::memory_order_relaxed);
+        std::size_t n = std::min<std::size_t>(count, capacity_ - (head - cached_tail_));
+        if (n < count) {
+            cached_tail_ = header_->tail.load(std::memory_order_acquire);
+            n = std::min<std::size_t>(count, capacity_ - (head - cached_tail_));
+            if (n == 0) return 0;
+        }
+        const std::size_t idx   = head & mask_;
+        const std::size_t first = std::min(n, capacity_ - idx);
+        std::memcpy(&slots_[idx], items, first * sizeof(MarketUpdate));
+        std::memcpy(&slots_[0], items + first, (n - first) * sizeof(MarketUpdate));
+        header_->head.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+    std::size_t push_bulk(std::span<const MarketUpdate> items)
+    {
+        return push_bulk(items.data(), items.size());
+    }
+
+    std::span<MarketUpdate> claim(std::size_t n)
+    {
+        const std::uint64_t head = header_->head.load(std::memory_order_relaxed);
+        if (capacity_ - (head - cached_tail_) < n) {
+            cached_tail_ = header_->tail.load(std::memory_order_acquire);
+        }
+        const std::size_t idx = head & mask_;
+        n = std::min<std::size_t>({n, capacity_ - (head - cached_tail_), capacity_ - idx});
+        return {&slots_[idx], n};
+    }
+
+    void commit(std::size_t n)
+    {
+        header_->head.store(header_->head.load(std::memory_order_relaxed) + n,
+                            std::memory_order_release);
+    }
+
+    std::size_t claim_limit() const
+    {
+        return capacity_ - (header_->head.load(std::memory_order_relaxed) & mask_);
+    }
+
+    // ---- consumer ------------------------------------------------------
+
+    bool pop(MarketUpdate& out)
+    {
+        const std::span<const MarketUpdate> s = peek(1);
+        if (s.empty()) return false;
+        out = s[0];
+        release(1);
+        return true;
+    }
+
+    std::size_t pop_bulk(std::span<MarketUpdate> out)
+    {
+        const std::uint64_t tail = header_->tail.load(std::memory_order_relaxed);
+        std::size_t n = std::min<std::size_t>(out.size(), cached_head_ - tail);
+        if (n < out.size()) {
+            cached_head_ = header_->head.load(std::memory_order_acquire);
+            n = std::min<std::size_t>(out.size(), cached_head_ - tail);
+            if (n == 0) return 0;
+        }
+        const std::size_t idx   = tail & mask_;
+        const std::size_t first = std::min(n, capacity_ - idx);
+        std::memcpy(out.data(), &slots_[idx], first * sizeof(MarketUpdate));
+        std::memcpy(out.data() + first, &slots_[0], (n - first) * sizeof(MarketUpdate));
+        header_->tail.store(tail + n, std::memory_order_release);
+        return n;
+    }
+
+    std::span<const MarketUpdate> peek(std::size_t n)
+    {
+        const std::uint64_t tail = header_->tail.load(std::memory_order_relaxed);
+        if (cached_head_ - tail < n) {
+            cached_head_ = header_->head.load(std::memory_order_acquire);
+        }
+        const std::size_t idx = tail & mask_;
+        n = std::min<std::size_t>({n, cached_head_ - tail, capacity_ - idx});
+        return {&slots_[idx], n};
+    }
+
+    void release(std::size_t n)
+    {
+        header_->tail.store(header_->tail.load(std::memory_order_relaxed) + n,
+                            std::memory_order_release);
+    }
+
+    std::size_t size() const
+    {
+        const std::uint64_t head = header_->head.load(std::memory_order_acquire);
+        const std::uint64_t tail = header_->tail.load(std::memory_order_acquire);
+        return head >= tail ? head - tail : 0;
+    }
+
+    bool empty() const { return size() == 0; }
+
+private:
+    void reset() noexcept;
+
+    ShmRingHeader* header_      = nullptr;
+    MarketUpdate*  slots_       = nullptr;
+    std::size_t    capacity_    = 0;
+    std::size_t    mask_        = 0;
+    std::size_t    map_bytes_   = 0;
+    bool           producer_    = false;
+    std::string    path_;                  // hugetlbfs file, or shm name
+    bool           hugetlbfs_   = false;
+    std::uint64_t  cached_tail_ = 0;       // producer only
+    std::uint64_t  cached_head_ = 0;       // consumer only
+};
@@ -0,0 +1,149 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <thread>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+// ---------------------------------------------------------------------------
+// Consumer wait strategies for the rings.
+//
+// A consumer that finds its ring empty calls WaitStrategy::idle(ready) and
+// retries; after it got work it calls reset(). What idle() does depends on
+// the kind:
+//
+//   BusySpin   one pause instruction. Lowest latency, burns the core.
+//   SpinYield  pause for `spin_limit` idle calls, then sched_yield on every
+//              call. Gives the core to other runnable threads but never
+//              sleeps, so an idle consumer still shows as 100% CPU.
+//   Park       spin as SpinYield, then sleep on the ring's Doorbell (a futex
+//              on Linux) until the producer publishes or `park_timeout`
+//              passes. Idle consumers use no CPU; the first item after a
+//              park pays a wakeup.
+//
+// Parking needs the producer's help: SpscRing::set_doorbell() makes every
+// publish call Doorbell::ring(), which is a fence and a load while nobody is
+// parked and a futex wake only when a consumer is.
+// ---------------------------------------------------------------------------
+
+inline void cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
+
+class Doorbell {
+public:
+    // Producer side, after publishing. Wakes parked consumers, if any.
+    void ring() noexcept {
+        // Pairs with the waiter count increment in park(): either the
+        // consumer sees the new item or this load sees the waiter.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters_.load(std::memory_order_relaxed) != 0) {
+            seq_.fetch_add(1, std::memory_order_release);
+            wake();
+        }
+    }
+
+    // Consumer side. Sleeps until ring() or `timeout`, unless `ready()`
+    // (re-checked after announcing the waiter) is already true.
+    template <typename Ready>
+    void park(Ready&& ready, std::chrono::nanoseconds timeout) noexcept {
+        const std::uint32_t seq = seq_.load(std::memory_order_acquire);
+        waiters_.fetch_add(1, std::memory_order_relaxed);
+        // The other half of ring()'s fence: orders the increment before
+        // ready()'s loads, which a seq_cst RMW alone does not.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!ready()) sleep(seq, timeout);
+        waiters_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    std::uint64_t wakeups() const noexcept { return wakeups_.load(std::memory_order_relaxed); }
+
+private:
+    void wake() noexcept {
+        wakeups_.fetch_add(1, std::memory_order_relaxed);
+#ifdef __linux__
+        ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&seq_), FUTEX_WAKE_PRIVATE, INT_MAX,
+                  nullptr, nullptr, 0);
+#else
+        seq_.notify_all();
+#endif
+    }
+
+    void sleep(std::uint32_t seq, std::chrono::nanoseconds timeout) noexcept {
+#ifdef __linux__
+        // Returns at once if seq_ has moved on since it was read.
+        const struct timespec ts{static_cast<time_t>(timeout.count() / 1'000'000'000),
+                                 static_cast<long>(timeout.count() % 1'000'000'000)};
+        ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&seq_), FUTEX_WAIT_PRIVATE, seq,
+                  &ts, nullptr, 0);
+#else
+        (void)timeout;   // std::atomic::wait has no timeout
+        seq_.wait(seq, std::memory_order_acquire);
+#endif
+    }
+
+    static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t), "futex word");
+
+    std::atomic<std::uint32_t> seq_{0};       // futex word
+    std::atomic<std::uint32_t> waiters_{0};
+    std::atomic<std::uint64_t> wakeups_{0};   // futex wakes issued, for benchmarks
+};
+
+class WaitStrategy {
+public:
+    enum class Kind { BusySpin, SpinYield, Park };
+
+    struct Options {
+        Kind                     kind         = Kind::BusySpin;
+        std::uint32_t            spin_limit   = 1024;   // idle calls spent spinning first
+        std::chrono::nanoseconds park_timeout = std::chrono::milliseconds(1);
+    };
+
+    WaitStrategy() = default;
+    // Park needs the doorbell the consumer's ring rings.
+    explicit WaitStrategy(const Options& opts, Doorbell* doorbell = nullptr)
+        : opts_(opts), doorbell_(doorbell) {}
+
+    Kind kind() const noexcept { return opts_.kind; }
+
+    void reset() noexcept { idle_calls_ = 0; }
+
+    // Called when the consumer found nothing to do. `ready()` reports
+    // whether there is work now (items, or the producer having finished);
+    // only Park consults it, to avoid sleeping past a publish.
+    template <typename Ready>
+    void idle(Ready&& ready) noexcept {
+        if (opts_.kind == Kind::BusySpin || idle_calls_ < opts_.spin_limit) {
+            ++idle_calls_;
+            cpu_relax();
+        } else if (opts_.kind == Kind::Park && doorbell_) {
+            doorbell_->park(ready, opts_.park_timeout);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+    void idle() noexcept {
+        idle([] { return false; });
+    }
+
+private:
+    Options       opts_;
+    Doorbell*     doorbell_   = nullptr;
+    std::uint32_t idle_calls_ = 0;
+};
@@ -0,0 +1,306 @@
+#include "engine/batch_imbalance_strategy.hpp"
+
+#include <algorithm>
+#include <limits>
+
+// trading_core and its users build with -ffp-contract=off (CMakeLists.txt):
+// a fused multiply-add in either EMA step would make the two round apart.
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define BATCH_HAVE_SIMD_PATH 1
+#else
+#define BATCH_HAVE_SIMD_PATH 0
+#endif
+
+namespace {
+
+constexpr double INF = std::numeric_limits<double>::infinity();
+
+// ---------------------------------------------------------------------------
+// EMA kernels. Each steps the lanes it is given by up to `n` ticks and
+// stops after the first tick on which any lane's EMA leaves
+// [lower, upper]. Returns the ticks applied and sets `crossed` if it
+// stopped early for a signal. The EMA is alpha*raw + (1-alpha)*ema, as in
+// ImbalanceStrategy::on_tick, with alpha*raw hoisted out of the loop.
+// ---------------------------------------------------------------------------
+
+// LANE_GROUP lanes, plain C++.
+std::uint32_t step_scalar(double* ema, const double* alpha, const double* oma,
+                          const double* upper, const double* lower,
+                          double raw, std::uint32_t n, bool& crossed) noexcept {
+    constexpr std::size_t L = BatchImbalanceStrategy::LANE_GROUP;
+    double e[L], a[L];
+    for (std::size_t l = 0; l < L; ++l) {
+        e[l] = ema[l];
+        a[l] = alpha[l] * raw;
+    }
+    std::uint32_t k = 0;
+    while (k < n) {
+        bool out = false;
+        for (std::size_t l = 0; l < L; ++l) {
+            e[l] = a[l] + oma[l] * e[l];
+            out |= (e[l] > upper[l]) | (e[l] < lower[l]);
+        }
+        ++k;
+        if (out) {
+            crossed = true;
+            break;
+        }
+    }
+    std::copy(e, e + L, ema);
+    return k;
+}
+
+#if BATCH_HAVE_SIMD_PATH
+// U vectors of 4 lanes: U independent EMA chains hide the mul+add latency.
+template <std::size_t U>
+__attribute__((target("avx2")))
+std::uint32_t step_avx2(double* ema, const double* alpha, const double* oma,
+                        const double* upper, const double* lower,
+                        double raw, std::uint32_t n, bool& crossed) noexcept {
+    const __m256d r = _mm256_set1_pd(raw);
+    __m256d e[U], a[U], o[U], hi[U], lo[U];
+#pragma GCC unroll 8
+    for (std::size_t u = 0; u < U; ++u) {
+        e[u]  = _mm256_loadu_pd(ema + 4 * u);
+        a[u]  = _mm256_mul_pd(_mm256_loadu_pd(alpha + 4 * u), r);
+        o[u]  = _mm256_loadu_pd(oma + 4 * u);
+        hi[u] = _mm256_loadu_pd(upper + 4 * u);
+        lo[u] = _mm256_loadu_pd(lower + 4 * u);
+    }
+    std::uint32_t k = 0;
+    while (k < n) {
+        __m256d out = _mm256_setzero_pd();
+#pragma GCC unroll 8
+        for (std::size_t u = 0; u < U; ++u) {
+            e[u] = _mm256_add_pd(a[u], _mm256_mul_pd(o[u], e[u]));
+            out  = _mm256_or_pd(out, _mm256_or_pd(_mm256_cmp_pd(e[u], hi[u], _CMP_GT_OQ),
+                                                  _mm256_cmp_pd(e[u], lo[u], _CMP_LT_OQ)));
+        }
+        ++k;
+        if (_mm256_movemask_pd(out)) {
+            crossed = true;
+            break;
+        }
+    }
+#pragma GCC unroll 8
+    for (std::size_t u = 0; u < U; ++u) _mm256_storeu_pd(ema + 4 * u, e[u]);
+    return k;
+}
+
+// U vectors of 8 lanes.
+template <std::size_t U>
+__attribute__((target("avx512f")))
+std::uint32_t step_avx512(double* ema, const double* alpha, const double* oma,
+                          const double* upper, const double* lower,
+                          double raw, std::uint32_t n, bool& crossed) noexcept {
+    const __m512d r = _mm512_set1_pd(raw);
+    __m512d e[U], a[U], o[U], hi[U], lo[U];
+#pragma GCC unroll 8
+    for (std::size_t u = 0; u < U; ++u) {
+        e[u]  = _mm512_loadu_pd(ema + 8 * u);
+        a[u]  = _mm512_mul_pd(_mm512_loadu_pd(alpha + 8 * u), r);
+        o[u]  = _mm512_loadu_pd(oma + 8 * u);
+        hi[u] = _mm512_loadu_pd(upper + 8 * u);
+        lo[u] = _mm512_loadu_pd(lower + 8 * u);
+    }
+    std::uint32_t k = 0;
+    while (k < n) {
+        __mmask8 out = 0;
+#pragma GCC unroll 8
+        for (std::size_t u = 0; u < U; ++u) {
+            e[u] = _mm512_add_pd(a[u], _mm512_mul_pd(o[u], e[u]));
+            out |= _mm512_cmp_pd_mask(e[u], hi[u], _CMP_GT_OQ)
+                 | _mm512_cmp_pd_mask(e[u], lo[u], _CMP_LT_OQ);
+        }
+        ++k;
+        if (out) {
+            crossed = true;
+            break;
+        }
+    }
+#pragma GCC unroll 8
+    for (std::size_t u = 0; u < U; ++u) _mm512_storeu_pd(ema + 8 * u, e[u]);
+    return k;
+}
+#endif
+
+using StepFn = std::uint32_t (*)(double*, const double*, const double*, const double*,
+                                 const double*, double, std::uint32_t, bool&) noexcept;
+
+// The widest kernel for `remaining` lanes (a multiple of LANE_GROUP) and
+// the lanes it takes: up to 4 AVX-512 or 4 AVX2 vectors at a time.
+StepFn kernel_for(BatchImbalanceStrategy::Isa isa, std::size_t remaining,
+                  std::size_t& width) noexcept {
+#if BATCH_HAVE_SIMD_PATH
+    switch (isa) {
+    case BatchImbalanceStrategy::Isa::Avx512:
+        if (remaining >= 32) { width = 32; return &step_avx512<4>; }
+        if (remaining >= 16) { width = 16; return &step_avx512<2>; }
+        width = 8;
+        return &step_avx512<1>;
+    case BatchImbalanceStrategy::Isa::Avx2:
+        if (remaining >= 16) { width = 16; return &step_avx2<4>; }
+        width = 8;
+        return &step_avx2<2>;
+    case BatchImbalanceStrategy::Isa::Scalar:
+        break;
+    }
+#else
+    (void)isa;
+    (void)remaining;
+#endif
+    width = BatchImbalanceStrategy::LANE_GROUP;
+    return &step_scalar;
+}
+
+}  // namespace
+
+// ---------------------------------------------------------------------------
+// BatchImbalanceStrategy
+// ---------------------------------------------------------------------------
+BatchImbalanceStrategy::Isa BatchImbalanceStrategy::cpuBest() noexcept {
+#if BATCH_HAVE_SIMD_PATH
+    static const Isa best = [] {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) return Isa::Avx512;
+        if (__builtin_cpu_supports("avx2"))    return Isa::Avx2;
+        return Isa::Scalar;
+    }();
+    return best;
+#else
+    return Isa::Scalar;
+#endif
+}
+
+const char* BatchImbalanceStrategy::isaName(Isa isa) noexcept {
+    switch (isa) {
+    case Isa::Avx512: return "avx512";
+    case Isa::Avx2:   return "avx2";
+    case Isa::Scalar: break;
+    }
+    return "scalar";
+}
+
+BatchImbalanceStrategy::BatchImbalanceStrategy(const double* ema_alpha, const double* threshold,
+                                               std::size_t n, Isa max_isa)
+    : n_(n)
+    , isa_(std::min(max_isa, cpuBest()))
+{
+    const std::size_t lanes = (n + LANE_GROUP - 1) / LANE_GROUP * LANE_GROUP;
+    alpha_.assign(lanes, 0.0);
+    one_minus_alpha_.assign(lanes, 1.0);
+    threshold_.assign(lanes, INF);
+    upper_.assign(lanes, INF);
+    lower_.assign(lanes, -INF);
+    ema_.assign(lanes, 0.0);
+    position_.assign(lanes, 0);
+    entry_price_.assign(lanes, 0);
+    realized_pnl_.assign(lanes, 0.0);
+    unrealized_pnl_.assign(lanes, 0.0);
+    signals_emitted_.assign(lanes, 0);
+    round_trips_.assign(lanes, 0);
+    for (std::size_t i = 0; i < n; ++i) {
+        alpha_[i]           = ema_alpha[i];
+        one_minus_alpha_[i] = 1.0 - ema_alpha[i];
+        threshold_[i]       = threshold[i];
+        set_bounds(i);
+    }
+}
+
+void BatchImbalanceStrategy::on_top(bool two_sided, int64_t bid_price, int64_t ask_price,
+                                    int64_t bid_qty, int64_t ask_qty) {
+    top_valid_ = two_sided && bid_qty + ask_qty != 0;
+    if (!top_valid_) return;
+    bid_price_ = bid_price;
+    ask_price_ = ask_price;
+    mid_       = (bid_price + ask_price) / 2;
+    raw_       = (double)(bid_qty - ask_qty) / (double)(bid_qty + ask_qty);
+}
+
+void BatchImbalanceStrategy::on_ticks(std::uint32_t n) {
+    if (!top_valid_ || n == 0) return;
+    ticks_ += n;
+
+    const std::size_t lanes = alpha_.size();
+    for (std::size_t g = 0; g < lanes; ) {
+        std::size_t  width;
+        const StepFn step = kernel_for(isa_, lanes - g, width);
+        const std::size_t end = g + width;
+
+        std::uint32_t done   = 0;
+        bool          marked = false;
+        while (done < n) {
+            bool crossed = false;
+            done += step(ema_.data() + g, alpha_.data() + g, one_minus_alpha_.data() + g,
+                         upper_.data() + g, lower_.data() + g, raw_, n - done, crossed);
+            if (crossed) {
+                signal_lanes(g, end);
+                marked = done == n;
+            }
+        }
+        // The mark only changes with a signal or a new top, so the last
+        // tick's mark stands for every tick of the call.
+        if (!marked) mark_lanes(g, end);
+        g = end;
+    }
+}
+
+void BatchImbalanceStrategy::mark_lanes(std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i) {
+        if (position_[i] != 0) {
+            unrealized_pnl_[i] = (double)(mid_ - entry_price_[i]) * position_[i];
+        }
+    }
+}
+
+void BatchImbalanceStrategy::signal_lanes(std::size_t begin, std::size_t end) {
+    mark_lanes(begin, end);
+    for (std::size_t i = begin; i < end; ++i) {
+        int           dir;
+        int64_t       price;
+        const double  e = ema_[i];
+        if (e > threshold_[i] && position_[i] != 1) {
+            dir   = 1;
+            price = ask_price_;
+        } else if (e < -threshold_[i] && position_[i] != -1) {
+            dir   = -1;
+            price = bid_price_;
+        } else {
+            continue;
+        }
+        if (position_[i] != 0) {
+            realized_pnl_[i] += (double)(price - entry_price_[i]) * position_[i];
+            unrealized_pnl_[i] = 0.0;
+            ++round_trips_[i];
+        }
+        position_[i]    = dir;
+        entry_price_[i] = price;
+        ++signals_emitted_[i];
+        set_bounds(i);
+    }
+}
+
+void BatchImbalanceStrategy::set_bounds(std::size_t i) {
+    upper_[i] = position_[i] == 1  ? INF  : threshold_[i];
+    lower_[i] = position_[i] == -1 ? -INF : -threshold_[i];
+}
+
+ImbalanceStrategy::State BatchImbalanceStrategy::state(std::size_t i) const {
+    ImbalanceStrategy::State st;
+    st.top_valid       = top_valid_;
+    st.bid_price       = bid_price_;
+    st.ask_price       = ask_price_;
+    st.mid             = mid_;
+    st.raw             = raw_;
+    st.ema             = ema_[i];
+    st.last_signal     = position_[i];
+    st.position        = position_[i];
+    st.entry_price     = entry_price_[i];
+    st.realized_pnl    = realized_pnl_[i];
+    st.unrealized_pnl  = unrealized_pnl_[i];
+    st.ticks           = ticks_;
+    st.signals_emitted = signals_emitted_[i];
+    st.round_trips     = round_trips_[i];
+    return st;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "engine/imbalance_strategy.hpp"
+
+// ---------------------------------------------------------------------------
+// BatchImbalanceStrategy — many ImbalanceStrategy configurations
+// (ema_alpha, threshold) stepped together over one top of book.
+//
+// Every configuration sees the same imbalance, so the top is set once per
+// change (on_top) and shared by all of them. Per-configuration state is
+// kept in structure-of-arrays form, padded to a multiple of LANE_GROUP.
+// on_ticks(n) advances every configuration by n updates under the current
+// top: the EMA steps and the signal test run on AVX-512 (8 doubles per
+// vector) or AVX2 (4), whichever the CPU has, several vectors at a time.
+// Signals are rare, so a tick where any lane of a group would signal falls
+// back to scalar code for that group, which also does the position flip,
+// PnL and counters. Between signals the mark-to-market does not change
+// within one top, so it is applied once per on_ticks call.
+//
+// Each lane ends in exactly the State a book-free ImbalanceStrategy with
+// the same parameters would (no FMA contraction; prices below 2^53).
+// Signals are counted, not queued: there is no poll_signal().
+// ---------------------------------------------------------------------------
+class BatchImbalanceStrategy {
+public:
+    enum class Isa { Scalar, Avx2, Avx512 };
+
+    static constexpr std::size_t LANE_GROUP = 8;   // one AVX-512 vector of doubles
+
+    // `n` configurations, ema_alpha[i] and threshold[i]. `max_isa` caps
+    // the instruction set (tests, A/B benchmarks); the CPU decides the rest.
+    BatchImbalanceStrategy(const double* ema_alpha, const double* threshold, std::size_t n,
+                           Isa max_isa = Isa::Avx512);
+
+    std::size_t size() const noexcept { return n_; }
+    Isa         isa()  const noexcept { return isa_; }
+    static Isa  cpuBest() noexcept;
+    static const char* isaName(Isa isa) noexcept;
+
+    // New top of book, as ImbalanceStrategy::on_top.
+    void on_top(bool two_sided, int64_t bid_price, int64_t ask_price,
+                int64_t bid_qty, int64_t ask_qty);
+
+    // `n` updates under the current top, as n calls to ImbalanceStrategy::on_tick.
+    void on_ticks(std::uint32_t n);
+    void on_tick() { on_ticks(1); }
+
+    // Lane i as an ImbalanceStrategy::State (top_read is false: no book).
+    ImbalanceStrategy::State state(std::size_t i) const;
+
+private:
+    // Scalar signal rules for lanes [begin, end) after their EMA step.
+    void signal_lanes(std::size_t begin, std::size_t end);
+    void mark_lanes(std::size_t begin, std::size_t end);
+    void set_bounds(std::size_t i);
+
+    std::size_t n_;
+    Isa         isa_;
+
+    // Shared top of book
+    bool     top_valid_ = false;
+    int64_t  bid_price_ = 0;
+    int64_t  ask_price_ = 0;
+    int64_t  mid_       = 0;
+    double   raw_       = 0.0;
+    uint64_t ticks_     = 0;
+
+    // Per configuration, padded lanes never signal (alpha 0, bounds ±inf)
+    std::vector<double>   alpha_;
+    std::vector<double>   one_minus_alpha_;
+    std::vector<double>   threshold_;
+    std::vector<double>   upper_;    // EMA above this signals: threshold, or +inf when long
+    std::vector<double>   lower_;    // EMA below this signals: -threshold, or -inf when short
+    std::vector<double>   ema_;
+    std::vector<int>      position_; // also the last signal: both flip together
+    std::vector<int64_t>  entry_price_;
+    std::vector<double>   realized_pnl_;
+    std::vector<double>   unrealized_pnl_;
+    std::vector<uint64_t> signals_emitted_;
+    std::vector<uint64_t> round_trips_;
+};
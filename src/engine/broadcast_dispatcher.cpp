@@ -0,0 +1,74 @@
+#include "engine/broadcast_dispatcher.hpp"
+
+#include <cassert>
+
+#include "core/order_book.hpp"
+#include "util/cpu_affinity.hpp"
+
+BroadcastDispatcher::BroadcastDispatcher(std::size_t num_readers, std::size_t queue_capacity)
+    : ring_(queue_capacity, num_readers)
+    , feed_handler_(ring_)
+{
+    readers_.reserve(num_readers);
+}
+
+BroadcastDispatcher::~BroadcastDispatcher() {
+    finish();
+}
+
+void BroadcastDispatcher::addReader(OrderBook& book, Strategy& strategy, const RiskManager* risk) {
+    assert(readers_.size() < ring_.numReaders());
+    readers_.push_back(std::make_unique<Reader>(book, strategy, risk));
+}
+
+void BroadcastDispatcher::start(const std::vector<std::uint32_t>& cores) {
+    // An unregistered reader would never release and stall the producer.
+    assert(readers_.size() == ring_.numReaders());
+    producer_done_.store(false, std::memory_order_relaxed);
+    for (std::size_t i = 0; i < readers_.size(); ++i) {
+        const bool pin = i < cores.size();
+        const std::uint32_t core = pin ? cores[i] : 0;
+        readers_[i]->thread = std::thread([this, i, pin, core] {
+            if (pin) pin_thread_to_core(core);
+            consume(i);
+        });
+    }
+}
+
+void BroadcastDispatcher::finish() {
+    producer_done_.store(true, std::memory_order_release);
+    for (auto& reader : readers_) {
+        if (reader->thread.joinable()) reader->thread.join();
+    }
+}
+
+void BroadcastDispatcher::consume(std::size_t index) {
+    Reader& rd = *readers_[index];
+    std::uint64_t n = 0, accepted = 0;
+    StrategySignal sig;
+    auto drain = [&] {
+        const auto batch = ring_.peek(index, 256);   // read in place
+        for (const MarketUpdate& u : batch) {
+            rd.book.applyUpdate(u);
+            rd.strategy.on_market_update(u);
+            while (rd.strategy.poll_signal(sig)) {
+                if (!rd.risk || rd.risk->check(sig)) ++accepted;
+            }
+        }
+        ring_.release(index, batch.size());
+        n += batch.size();
+        return !batch.empty();
+    };
+    while (true) {
+        if (drain()) {
+            continue;
+        } else if (producer_done_.load(std::memory_order_acquire)) {
+            // Producer is finished — drain whatever is left in the ring.
+            while (drain()) {}
+            break;
+        }
+        // else: ring transiently empty, producer still running — spin
+    }
+    rd.consumed = n;
+    rd.signals  = accepted;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "core/broadcast_ring.hpp"
+#include "engine/strategy_interface.hpp"
+#include "feed/feed_handler.hpp"
+#include "risk/risk_manager.hpp"
+
+class OrderBook;
+
+// ---------------------------------------------------------------------------
+// BroadcastDispatcher
+//
+// Several strategies on one decode of the feed, each on its own thread:
+//
+//   replay → feedHandler() → BroadcastRing ─┬→ reader 0 → OrderBook 0 → Strategy 0
+//                                           ├→ reader 1 → OrderBook 1 → Strategy 1
+//                                           └→ ...
+//
+// Every reader applies every update to its own book, then calls its
+// strategy, polling signals after each update as EventLoop does. The
+// producer runs at the pace of the slowest reader. Register exactly
+// `num_readers` readers with addReader() before start(); the books,
+// strategies and risk managers are the caller's and must outlive finish().
+// ---------------------------------------------------------------------------
+class BroadcastDispatcher {
+public:
+    BroadcastDispatcher(std::size_t num_readers, std::size_t queue_capacity);
+    ~BroadcastDispatcher();
+
+    BroadcastDispatcher(const BroadcastDispatcher&)            = delete;
+    BroadcastDispatcher& operator=(const BroadcastDispatcher&) = delete;
+
+    std::size_t numReaders() const noexcept { return ring_.numReaders(); }
+
+    // Producer-side entry point (pass to run_mmap_replay).
+    FeedHandler& feedHandler() noexcept { return feed_handler_; }
+
+    // `risk` may be null: every signal is then accepted.
+    void addReader(OrderBook& book, Strategy& strategy, const RiskManager* risk = nullptr);
+
+    // Launch one thread per reader. If `cores` is non-empty, reader i is
+    // pinned to cores[i].
+    void start(const std::vector<std::uint32_t>& cores = {});
+
+    // Call once the producer has published its last update: readers drain
+    // the ring and are joined.
+    void finish();
+
+    // Valid after finish().
+    std::uint64_t consumed(std::size_t reader) const noexcept { return readers_[reader]->consumed; }
+    std::uint64_t signals(std::size_t reader) const noexcept { return readers_[reader]->signals; }
+
+private:
+    struct Reader {
+        Reader(OrderBook& b, Strategy& s, const RiskManager* r) : book(b), strategy(s), risk(r) {}
+
+        OrderBook&         book;
+        Strategy&          strategy;
+        const RiskManager* risk;
+        std::uint64_t      consumed = 0;
+        std::uint64_t      signals  = 0;   // passed the risk check
+        std::thread        thread;
+    };
+
+    void consume(std::size_t index);
+
+    MdBroadcast                          ring_;
+    FeedHandler                          feed_handler_;
+    std::vector<std::unique_ptr<Reader>> readers_;
+    std::atomic<bool>                    producer_done_{false};
+};
@@ -1,47 +1,227 @@
 #pragma once
 
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
+#include "core/order_book.hpp"
+#include "core/ring_buffer.hpp"
+#include "core/wait_strategy.hpp"
 #include "engine/strategy_interface.hpp"
 #include "risk/risk_manager.hpp"
+#include "util/timer.hpp"
 
-struct MarketUpdate;
-class OrderBook;
+// What on_timer() runs on.
+//   Wall   steady_clock, read once per loop pass; for live feeds.
+//   Event  SimClock driven by MarketUpdate::ts: on_timer(t) is called
+//          for every multiple t of the interval, before the first
+//          update with ts >= t. Deterministic, and the loop never
+//          reads the machine's clock.
+enum class LoopClock { Wall, Event };
 
-template <typename T>
-class SpscRing;
-
-class EventLoop {
+// ---------------------------------------------------------------------------
+// BasicEventLoop<StrategyT, RiskT, BookT>
+//
+// MD queue → BookT::applyUpdate → StrategyT callbacks → RiskT::check → out
+// queue. The hot path calls the three through their concrete types, so with
+// a final strategy class (ImbalanceStrategy) the per-update strategy calls
+// are direct and inlined into the batch loop.
+//
+// EventLoop is the instantiation on the Strategy interface: one virtual
+// call per update and per poll, but any strategy plugs in without
+// recompiling the loop. It is compiled once, in event_loop.cpp.
+// ---------------------------------------------------------------------------
+template <typename StrategyT, typename RiskT = RiskManager, typename BookT = OrderBook>
+class BasicEventLoop {
 public:
     using MdQueue  = SpscRing<MarketUpdate>;
     using OutQueue = SpscRing<StrategySignal>;
+    using Clock    = LoopClock;
 
-    EventLoop(MdQueue&      md_queue,
-              OutQueue&     out_queue,
-              OrderBook&    order_book,
-              Strategy&     strategy,
-              RiskManager&  risk_manager,
-              std::uint64_t timer_interval_ns);
+    BasicEventLoop(MdQueue&      md_queue,
+                   OutQueue&     out_queue,
+                   BookT&        order_book,
+                   StrategyT&    strategy,
+                   RiskT&        risk_manager,
+                   std::uint64_t timer_interval_ns,
+                   Clock         clock = Clock::Wall);
 
+    // Batch mode: processes what is already queued and returns the first
+    // time both queues are empty. The producer must have finished (and the
+    // queue must hold the whole feed) before this is called.
     void run();
 
+    // Streaming mode, on its own thread while the producer runs on another:
+    // returns once the market-data queue is closed (FeedHandler::endOfStream)
+    // and drained, or after stop(). The queue only has to absorb the
+    // producer running ahead, not hold the feed.
+    void run_streaming();
+
+    // What run_streaming() does while the queue is empty (busy-spin by
+    // default). Call before the producer starts: Park makes every publish
+    // ring this loop's doorbell. With Clock::Wall a parked loop fires
+    // timers up to park_timeout late.
+    void set_wait_strategy(const WaitStrategy::Options& wait);
+
+    // Shutdown from any thread: run_streaming() returns without draining.
+    void stop() noexcept;
+
     std::uint64_t updates_processed() const noexcept {
         return updates_processed_;
     }
 
+    // Feed time of the latest update (Clock::Event).
+    const SimClock& sim_clock() const noexcept { return sim_clock_; }
+
 private:
+    static constexpr std::size_t MD_BATCH = 256;
+
     bool handle_market_data();
+    bool handle_market_batch();
     bool handle_strategy_output();
     void maybe_fire_timer(std::uint64_t now_ns);
 
 private:
-    MdQueue&     md_queue_;
-    OutQueue&    out_queue_;
-    OrderBook&   order_book_;
-    Strategy&    strategy_;
-    RiskManager& risk_;
+    MdQueue&   md_queue_;
+    OutQueue&  out_queue_;
+    BookT&     order_book_;
+    StrategyT& strategy_;
+    RiskT&     risk_;
 
+    Clock         clock_;
+    SimClock      sim_clock_;
     std::uint64_t last_timer_ts_ns_{0};
     std::uint64_t timer_interval_ns_{0};
 
     std::uint64_t updates_processed_ = 0;
-};
\ No newline at end of file
+
+    WaitStrategy::Options wait_;
+    Doorbell              doorbell_;
+    std::atomic<bool>     stop_requested_{false};
+};
+
+using EventLoop = BasicEventLoop<Strategy>;
+
+template <typename StrategyT, typename RiskT, typename BookT>
+BasicEventLoop<StrategyT, RiskT, BookT>::BasicEventLoop(MdQueue&      md_queue,
+                                                        OutQueue&     out_queue,
+                                                        BookT&        order_book,
+                                                        StrategyT&    strategy,
+                                                        RiskT&        risk_manager,
+                                                        std::uint64_t timer_interval_ns,
+                                                        Clock         clock)
+    : md_queue_(md_queue)
+    , out_queue_(out_queue)
+    , order_book_(order_book)
+    , strategy_(strategy)
+    , risk_(risk_manager)
+    , clock_(clock)
+    , sim_clock_(clock == Clock::Event ? timer_interval_ns : 0)
+    , timer_interval_ns_(timer_interval_ns)
+{
+    if (clock_ == Clock::Wall) last_timer_ts_ns_ = get_monotonic_ns();
+}
+
+template <typename StrategyT, typename RiskT, typename BookT>
+void BasicEventLoop<StrategyT, RiskT, BookT>::run() {
+    while (true) {
+        bool did_work = false;
+
+        did_work |= handle_market_data();
+        did_work |= handle_strategy_output();
+
+        if (clock_ == Clock::Wall) maybe_fire_timer(get_monotonic_ns());
+
+        if (!did_work) {
+            break;
+        }
+    }
+}
+
+template <typename StrategyT, typename RiskT, typename BookT>
+void BasicEventLoop<StrategyT, RiskT, BookT>::run_streaming() {
+    WaitStrategy wait(wait_, &doorbell_);
+    while (!stop_requested_.load(std::memory_order_relaxed)) {
+        // Read before draining: if the queue was already closed and the
+        // drain then finds it empty, every update has been processed.
+        const bool closed = md_queue_.closed();
+
+        // One batch per pass, so output, timers and stop() are serviced
+        // while the producer keeps the queue non-empty.
+        bool did_work = false;
+        did_work |= handle_market_batch();
+        did_work |= handle_strategy_output();
+
+        if (clock_ == Clock::Wall) maybe_fire_timer(get_monotonic_ns());
+
+        if (did_work) {
+            wait.reset();
+            continue;
+        }
+        if (closed) break;
+        wait.idle([&] {
+            return !md_queue_.empty() || md_queue_.closed()
+                || stop_requested_.load(std::memory_order_relaxed);
+        });
+    }
+}
+
+template <typename StrategyT, typename RiskT, typename BookT>
+void BasicEventLoop<StrategyT, RiskT, BookT>::set_wait_strategy(const WaitStrategy::Options& wait) {
+    wait_ = wait;
+    md_queue_.set_doorbell(wait.kind == WaitStrategy::Kind::Park ? &doorbell_ : nullptr);
+}
+
+template <typename StrategyT, typename RiskT, typename BookT>
+void BasicEventLoop<StrategyT, RiskT, BookT>::stop() noexcept {
+    stop_requested_.store(true, std::memory_order_relaxed);
+    doorbell_.ring();
+}
+
+template <typename StrategyT, typename RiskT, typename BookT>
+bool BasicEventLoop<StrategyT, RiskT, BookT>::handle_market_data() {
+    bool did_work = false;
+    while (handle_market_batch()) did_work = true;
+    return did_work;
+}
+
+template <typename StrategyT, typename RiskT, typename BookT>
+bool BasicEventLoop<StrategyT, RiskT, BookT>::handle_market_batch() {
+    // Read in place from the ring: one head/tail exchange with the producer
+    // per batch and no copy out of the slots.
+    const auto batch = md_queue_.peek(MD_BATCH);
+    if (batch.empty()) return false;
+    updates_processed_ += batch.size();
+    // Wall mode leaves sim_clock_ without a timer: one compare per update.
+    for (const MarketUpdate& mu : batch) {
+        sim_clock_.advance(mu.ts, [this](std::uint64_t t) { strategy_.on_timer(t); });
+        order_book_.applyUpdate(mu);
+        strategy_.on_market_update(mu);
+    }
+    md_queue_.release(batch.size());
+    return true;
+}
+
+template <typename StrategyT, typename RiskT, typename BookT>
+bool BasicEventLoop<StrategyT, RiskT, BookT>::handle_strategy_output() {
+    bool did_work = false;
+
+    StrategySignal sig;
+    while (strategy_.poll_signal(sig)) {
+        did_work = true;
+        if (risk_.check(sig)) {
+            out_queue_.push(sig);
+        }
+    }
+
+    return did_work;
+}
+
+template <typename StrategyT, typename RiskT, typename BookT>
+void BasicEventLoop<StrategyT, RiskT, BookT>::maybe_fire_timer(std::uint64_t now_ns) {
+    if (now_ns - last_timer_ts_ns_ >= timer_interval_ns_) {
+        strategy_.on_timer(now_ns);
+        last_timer_ts_ns_ = now_ns;
+    }
+}
+
+extern template class BasicEventLoop<Strategy>;
@@ -13,6 +13,9 @@
 //     (bid_qty - ask_qty) / (bid_qty + ask_qty)   ∈ [-1, +1]
 //
 // An EMA of the raw imbalance is maintained each tick (configurable alpha).
+// When the book maintains BookFeatures (OrderBook::enableFeatures) the BBO is
+// read from the feature block and the raw imbalance is only recomputed when
+// features().top_changed is set; deeper updates just step the EMA.
 //
 // Rules:
 //   EMA > +threshold → buy  at best ask (if not already long)
@@ -21,55 +24,83 @@
 // PnL tracking (in price ticks, mark-to-market):
 //   Fills are assumed immediate at the signal price.
 //   A new signal in the opposite direction closes the current position first.
+//
+// Without a book (second constructor) the strategy is driven directly with
+// on_top()/on_tick(), e.g. by a parameter sweep over a precomputed
+// top-of-book stream (engine/param_sweep.hpp).
 // ---------------------------------------------------------------------------
-class ImbalanceStrategy : public Strategy {
+class ImbalanceStrategy final : public Strategy {
 public:
     ImbalanceStrategy(const OrderBook& ob,
                       double           ema_alpha  = 0.1,
                       double           threshold  = 0.3)
-        : ob_(ob)
+        : ob_(&ob)
+        , alpha_(ema_alpha)
+        , threshold_(threshold)
+    {}
+
+    // Book-free: only on_top()/on_tick() may be called.
+    ImbalanceStrategy(double ema_alpha, double threshold)
+        : ob_(nullptr)
         , alpha_(ema_alpha)
         , threshold_(threshold)
     {}
 
     // Called after order_book_.applyUpdate() — book is already current.
     void on_market_update(const MarketUpdate&) override {
-        PriceLevel bid, ask;
-        if (!ob_.getBestBid(bid) || !ob_.getBestAsk(ask)) return;
-        if (bid.total_qty + ask.total_qty == 0) return;
+        if (ob_->featuresEnabled()) {
+            const BookFeatures& f = ob_->features();
+            // The first tick reads the top unconditionally: the book may
+            // have been seeded (seek_feed) before the strategy saw it.
+            if (f.top_changed || !top_read_) {
+                top_read_ = true;
+                on_top(f.has_bid && f.has_ask, f.bid_price, f.ask_price, f.bid_qty, f.ask_qty);
+            }
+        } else {
+            PriceLevel bid, ask;
+            const bool two_sided = ob_->getBestBid(bid) && ob_->getBestAsk(ask);
+            on_top(two_sided, bid.price, ask.price, bid.total_qty, ask.total_qty);
+        }
+        on_tick();
+    }
 
-        // Raw imbalance ∈ [-1, +1]
-        double raw = (double)(bid.total_qty - ask.total_qty)
-                   / (double)(bid.total_qty + ask.total_qty);
+    // New top of book (`two_sided`: both a best bid and a best ask exist).
+    void on_top(bool two_sided, int64_t bid_price, int64_t ask_price,
+                int64_t bid_qty, int64_t ask_qty) {
+        top_valid_ = two_sided && bid_qty + ask_qty != 0;
+        if (top_valid_) set_top(bid_price, ask_price, bid_qty, ask_qty);
+    }
 
-        // EMA update
-        ema_ = alpha_ * raw + (1.0 - alpha_) * ema_;
+    // One update under the current top: EMA step, mark, signal rules.
+    void on_tick() {
+        if (!top_valid_) return;
 
-        int64_t mid = (bid.price + ask.price) / 2;
+        // EMA update
+        ema_ = alpha_ * raw_ + (1.0 - alpha_) * ema_;
 
         // Mark open position to market
         if (position_ != 0) {
-            unrealized_pnl_ = (double)(mid - entry_price_) * position_;
+            unrealized_pnl_ = (double)(mid_ - entry_price_) * position_;
         }
 
         // Buy signal: EMA strongly positive → price likely to rise
         if (ema_ > threshold_ && last_signal_ != 1) {
-            close_position(ask.price);   // close any open short
+            close_position(ask_price_);  // close any open short
             position_    = 1;
-            entry_price_ = ask.price;
+            entry_price_ = ask_price_;
             last_signal_ = 1;
             ++signals_emitted_;
-            pending_     = {ask.price, 1};
+            pending_     = {ask_price_, 1};
             has_pending_ = true;
         }
         // Sell signal: EMA strongly negative → price likely to fall
         else if (ema_ < -threshold_ && last_signal_ != -1) {
-            close_position(bid.price);   // close any open long
+            close_position(bid_price_);  // close any open long
             position_    = -1;
-            entry_price_ = bid.price;
+            entry_price_ = bid_price_;
             last_signal_ = -1;
             ++signals_emitted_;
-            pending_     = {bid.price, -1};
+            pending_     = {bid_price_, -1};
             has_pending_ = true;
         }
 
@@ -91,7 +122,7 @@ public:
         // Close position at current mid for final PnL
         double final_pnl = realized_pnl_;
         PriceLevel bid, ask;
-        if (position_ != 0 && ob_.getBestBid(bid) && ob_.getBestAsk(ask)) {
+        if (position_ != 0 && ob_ && ob_->getBestBid(bid) && ob_->getBestAsk(ask)) {
             int64_t mid = (bid.price + ask.price) / 2;
             final_pnl += (double)(mid - entry_price_) * position_;
         }
@@ -111,7 +142,71 @@ public:
     double   realized_pnl()   const { return realized_pnl_; }
     uint64_t ticks()          const { return ticks_; }
 
+    // Everything on_market_update reads or writes, so a run can be paused
+    // and resumed on another instance (engine/segmented_backtest.hpp).
+    struct State {
+        bool     top_valid       = false;
+        bool     top_read        = false;
+        int64_t  bid_price       = 0;
+        int64_t  ask_price       = 0;
+        int64_t  mid             = 0;
+        double   raw             = 0.0;
+        double   ema             = 0.0;
+        int      last_signal     = 0;
+        int      position        = 0;
+        int64_t  entry_price     = 0;
+        double   realized_pnl    = 0.0;
+        double   unrealized_pnl  = 0.0;
+        uint64_t ticks           = 0;
+        uint64_t signals_emitted = 0;
+        uint64_t round_trips     = 0;
+
+        bool operator==(const State&) const = default;
+
+        // Same trading state, ignoring the running totals (ticks, signals,
+        // round trips, realized PnL): from here on both emit the same
+        // signals for the same book and updates.
+        bool sameCarry(const State& o) const {
+            return ema == o.ema && last_signal == o.last_signal && position == o.position
+                && entry_price == o.entry_price;
+        }
+    };
+
+    State state() const {
+        return {top_valid_, top_read_, bid_price_, ask_price_, mid_, raw_, ema_,
+                last_signal_, position_, entry_price_, realized_pnl_, unrealized_pnl_,
+                ticks_, signals_emitted_, round_trips_};
+    }
+
+    // Drops any unpolled signal.
+    void setState(const State& st) {
+        top_valid_       = st.top_valid;
+        top_read_        = st.top_read;
+        bid_price_       = st.bid_price;
+        ask_price_       = st.ask_price;
+        mid_             = st.mid;
+        raw_             = st.raw;
+        ema_             = st.ema;
+        last_signal_     = st.last_signal;
+        position_        = st.position;
+        entry_price_     = st.entry_price;
+        realized_pnl_    = st.realized_pnl;
+        unrealized_pnl_  = st.unrealized_pnl;
+        ticks_           = st.ticks;
+        signals_emitted_ = st.signals_emitted;
+        round_trips_     = st.round_trips;
+        has_pending_     = false;
+    }
+
 private:
+    void set_top(int64_t bid_price, int64_t ask_price, int64_t bid_qty, int64_t ask_qty) {
+        bid_price_ = bid_price;
+        ask_price_ = ask_price;
+        mid_       = (bid_price + ask_price) / 2;
+        // Raw imbalance ∈ [-1, +1]
+        raw_ = (double)(bid_qty - ask_qty) / (double)(bid_qty + ask_qty);
+    }
+
     void close_position(int64_t close_price) {
         if (position_ == 0) return;
         realized_pnl_ += (double)(close_price - entry_price_) * position_;
@@ -121,10 +216,18 @@ private:
         ++round_trips_;
     }
 
-    const OrderBook& ob_;
+    const OrderBook* ob_;   // null when driven by on_top()/on_tick()
     double           alpha_;
     double           threshold_;
 
+    // Top of book as of the last update that changed it
+    bool     top_valid_       = false;
+    bool     top_read_        = false;   // features path: top read at least once
+    int64_t  bid_price_       = 0;
+    int64_t  ask_price_       = 0;
+    int64_t  mid_             = 0;
+    double   raw_             = 0.0;
+
     double   ema_             = 0.0;
     int      last_signal_     = 0;    // +1 last buy, -1 last sell, 0 none
     int      position_        = 0;    // +1 long, -1 short, 0 flat
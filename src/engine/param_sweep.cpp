@@ -0,0 +1,151 @@
+#include "engine/param_sweep.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <span>
+#include <system_error>
+#include <thread>
+
+#include "core/order_book.hpp"
+#include "engine/imbalance_strategy.hpp"
+#include "util/work_stealing_pool.hpp"
+
+bool build_top_of_book_stream(const char* feed, const IndexBookConfig& book,
+                              std::size_t depth_levels, TopOfBookStream& out) {
+    OrderBook ob(book.min_price, book.max_price, static_cast<std::size_t>(book.max_orders),
+                 book.id_index);
+    ob.enableFeatures(depth_levels);
+    out.runs.clear();
+    out.updates = 0;
+
+    std::error_code ec;
+    if (!std::filesystem::is_regular_file(feed, ec)) return false;
+
+    out.updates = replay_feed_records(feed, {}, UINT64_MAX,
+        [&](std::span<const MarketUpdate> records) {
+            for (const MarketUpdate& u : records) {
+                ob.applyUpdate(u);
+                const BookFeatures& f = ob.features();
+                // A new run wherever ImbalanceStrategy would re-read the top.
+                if (f.top_changed || out.runs.empty() || out.runs.back().updates == UINT32_MAX) {
+                    out.runs.push_back({f.bid_price, f.ask_price, f.bid_qty, f.ask_qty, 0,
+                                        f.has_bid && f.has_ask});
+                }
+                ++out.runs.back().updates;
+            }
+            return true;
+        });
+    return true;
+}
+
+std::vector<SweepParams> make_sweep_grid(const std::vector<double>& alphas,
+                                         const std::vector<double>& thresholds) {
+    std::vector<SweepParams> grid;
+    grid.reserve(alphas.size() * thresholds.size());
+    for (double a : alphas) {
+        for (double t : thresholds) grid.push_back({a, t});
+    }
+    return grid;
+}
+
+void SweepResults::resize(std::size_t n) {
+    ema_alpha.resize(n);
+    threshold.resize(n);
+    ticks.resize(n);
+    signals.resize(n);
+    round_trips.resize(n);
+    realized_pnl.resize(n);
+    total_pnl.resize(n);
+    ema.resize(n);
+}
+
+bool SweepResults::writeCsv(const char* path) const {
+    FILE* f = std::fopen(path, "w");
+    if (!f) return false;
+    std::fprintf(f, "ema_alpha,threshold,ticks,signals,round_trips,realized_pnl,total_pnl,ema\n");
+    for (std::size_t i = 0; i < rows(); ++i) {
+        std::fprintf(f, "%.17g,%.17g,%llu,%llu,%llu,%.17g,%.17g,%.17g\n",
+                     ema_alpha[i], threshold[i],
+                     (unsigned long long)ticks[i], (unsigned long long)signals[i],
+                     (unsigned long long)round_trips[i],
+                     realized_pnl[i], total_pnl[i], ema[i]);
+    }
+    return std::fclose(f) == 0;
+}
+
+SweepResults run_param_sweep(const TopOfBookStream& stream, const std::vector<SweepParams>& grid,
+                             const SweepOptions& opts, SweepStats* stats) {
+    SweepResults res;
+    res.resize(grid.size());
+
+    const std::size_t block   = std::max<std::size_t>(opts.block, 1);
+    const std::size_t tasks   = (grid.size() + block - 1) / block;
+    const std::size_t threads = opts.threads ? opts.threads
+                                             : std::max(1u, std::thread::hardware_concurrency());
+    WorkStealingPool pool(std::min(threads, std::max<std::size_t>(tasks, 1)), opts.cores);
+
+    // Final mark, as ImbalanceStrategy::print_summary takes it from the book.
+    const bool two_sided = !stream.runs.empty() && stream.runs.back().two_sided;
+    const std::int64_t final_mid =
+        two_sided ? (stream.runs.back().bid_price + stream.runs.back().ask_price) / 2 : 0;
+
+    pool.run(tasks, [&](std::size_t task, std::size_t) {
+        const std::size_t begin = task * block;
+        const std::size_t end   = std::min(begin + block, grid.size());
+        std::vector<ImbalanceStrategy::State> states(end - begin);
+        // Each run is read once for the whole block.
+        if (opts.batched) {
+            std::vector<double> alphas, thresholds;
+            for (std::size_t i = begin; i < end; ++i) {
+                alphas.push_back(grid[i].ema_alpha);
+                thresholds.push_back(grid[i].threshold);
+            }
+            BatchImbalanceStrategy batch(alphas.data(), thresholds.data(), end - begin,
+                                         opts.max_isa);
+            for (const TopRun& r : stream.runs) {
+                batch.on_top(r.two_sided, r.bid_price, r.ask_price, r.bid_qty, r.ask_qty);
+                batch.on_ticks(r.updates);
+            }
+            for (std::size_t i = 0; i < states.size(); ++i) states[i] = batch.state(i);
+        } else {
+            std::vector<ImbalanceStrategy> strategies;
+            strategies.reserve(end - begin);
+            for (std::size_t i = begin; i < end; ++i) {
+                strategies.emplace_back(grid[i].ema_alpha, grid[i].threshold);
+            }
+            for (const TopRun& r : stream.runs) {
+                for (ImbalanceStrategy& s : strategies) {
+                    s.on_top(r.two_sided, r.bid_price, r.ask_price, r.bid_qty, r.ask_qty);
+                    for (std::uint32_t k = 0; k < r.updates; ++k) s.on_tick();
+                }
+            }
+            for (std::size_t i = 0; i < states.size(); ++i) states[i] = strategies[i].state();
+        }
+        // Rows of one task are contiguous; tasks write disjoint ranges.
+        for (std::size_t i = begin; i < end; ++i) {
+            const ImbalanceStrategy::State& st = states[i - begin];
+            double total = st.realized_pnl;
+            if (st.position != 0 && two_sided) {
+                total += (double)(final_mid - st.entry_price) * st.position;
+            }
+            res.ema_alpha[i]    = grid[i].ema_alpha;
+            res.threshold[i]    = grid[i].threshold;
+            res.ticks[i]        = st.ticks;
+            res.signals[i]      = st.signals_emitted;
+            res.round_trips[i]  = st.round_trips;
+            res.realized_pnl[i] = st.realized_pnl;
+            res.total_pnl[i]    = total;
+            res.ema[i]          = st.ema;
+        }
+    });
+
+    if (stats) {
+        stats->threads = pool.size();
+        stats->tasks   = tasks;
+        stats->steals  = pool.steals();
+        stats->isa     = opts.batched ? std::min(opts.max_isa, BatchImbalanceStrategy::cpuBest())
+                                      : BatchImbalanceStrategy::Isa::Scalar;
+    }
+    return res;
+}
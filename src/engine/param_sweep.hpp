@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "engine/batch_imbalance_strategy.hpp"
+#include "replay/feed_index.hpp"
+
+// ---------------------------------------------------------------------------
+// Parameter sweep
+//
+// Evaluates many ImbalanceStrategy configurations (ema_alpha, threshold)
+// over one feed. The strategy only reads the top of the book, so the feed
+// is replayed through an OrderBook once, into a TopOfBookStream: the top
+// after every change and the number of updates it stayed for. All
+// configurations then run over that one shared, read-only stream through
+// the book-free on_top()/on_tick() entry points. Neither the feed nor a
+// book is held per worker.
+//
+// The grid is cut into blocks of `block` configurations, one task each, on
+// a WorkStealingPool. A task walks the stream once and steps its whole
+// block at each entry, as one BatchImbalanceStrategy (SIMD across the
+// block) or, with `batched` off, one ImbalanceStrategy per configuration.
+// Either way the result is identical to running run_backtest's strategy
+// once per configuration.
+// ---------------------------------------------------------------------------
+
+// Top of book for `updates` consecutive updates.
+struct TopRun {
+    std::int64_t  bid_price;
+    std::int64_t  ask_price;
+    std::int64_t  bid_qty;
+    std::int64_t  ask_qty;
+    std::uint32_t updates;
+    bool          two_sided;   // both a best bid and a best ask
+};
+
+struct TopOfBookStream {
+    std::vector<TopRun> runs;
+    std::uint64_t       updates = 0;   // sum of runs[i].updates
+};
+
+// Replays `feed` (raw or compact, mapped once) through a book configured
+// by `book` with features over `depth_levels`. Returns false if the feed
+// cannot be read.
+bool build_top_of_book_stream(const char* feed, const IndexBookConfig& book,
+                              std::size_t depth_levels, TopOfBookStream& out);
+
+struct SweepParams {
+    double ema_alpha;
+    double threshold;
+};
+
+// Every (alpha, threshold) pair of the two axes, alpha-major.
+std::vector<SweepParams> make_sweep_grid(const std::vector<double>& alphas,
+                                         const std::vector<double>& thresholds);
+
+// One row per configuration, in grid order; one vector per column.
+struct SweepResults {
+    std::vector<double>        ema_alpha;
+    std::vector<double>        threshold;
+    std::vector<std::uint64_t> ticks;
+    std::vector<std::uint64_t> signals;
+    std::vector<std::uint64_t> round_trips;
+    std::vector<double>        realized_pnl;
+    std::vector<double>        total_pnl;      // realized + open position at the final mid
+    std::vector<double>        ema;
+
+    std::size_t rows() const noexcept { return ema_alpha.size(); }
+    void resize(std::size_t n);
+
+    // Header line plus one line per row. Returns false if the file cannot
+    // be written.
+    bool writeCsv(const char* path) const;
+};
+
+struct SweepOptions {
+    std::size_t                threads = 0;    // 0: std::thread::hardware_concurrency()
+    std::size_t                block   = 64;   // configurations per task
+    bool                       batched = true; // BatchImbalanceStrategy per block
+    BatchImbalanceStrategy::Isa max_isa = BatchImbalanceStrategy::Isa::Avx512;
+    std::vector<std::uint32_t> cores;          // worker i on cores[i % size] if set
+};
+
+struct SweepStats {
+    std::size_t   threads = 0;
+    std::size_t   tasks   = 0;
+    std::uint64_t steals  = 0;
+    BatchImbalanceStrategy::Isa isa = BatchImbalanceStrategy::Isa::Scalar;   // if batched
+};
+
+SweepResults run_param_sweep(const TopOfBookStream& stream, const std::vector<SweepParams>& grid,
+                             const SweepOptions& opts = {}, SweepStats* stats = nullptr);
@@ -0,0 +1,266 @@
+#include "engine/segmented_backtest.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <system_error>
+#include <thread>
+
+#include "core/order_book.hpp"
+#include "engine/param_sweep.hpp"
+#include "util/cpu_affinity.hpp"
+
+namespace {
+
+using State = ImbalanceStrategy::State;
+
+std::unique_ptr<OrderBook> make_book(const IndexBookConfig& cfg, std::size_t depth_levels) {
+    auto book = std::make_unique<OrderBook>(cfg.min_price, cfg.max_price,
+                                            static_cast<std::size_t>(cfg.max_orders), cfg.id_index);
+    book->enableFeatures(depth_levels);
+    return book;
+}
+
+// Mid of a two-sided book, the mark ImbalanceStrategy::print_summary uses.
+bool book_mid(const OrderBook& book, std::int64_t& mid) {
+    PriceLevel bid, ask;
+    if (!book.getBestBid(bid) || !book.getBestAsk(ask)) return false;
+    mid = (bid.price + ask.price) / 2;
+    return true;
+}
+
+double total_pnl(const State& st, bool has_mid, std::int64_t mid) {
+    double pnl = st.realized_pnl;
+    if (st.position != 0 && has_mid) pnl += (double)(mid - st.entry_price) * st.position;
+    return pnl;
+}
+
+// `to`, with the running totals it gained since `from` added onto `base`.
+State advance(const State& base, const State& from, const State& to) {
+    State st = to;
+    st.ticks           = base.ticks + (to.ticks - from.ticks);
+    st.signals_emitted = base.signals_emitted + (to.signals_emitted - from.signals_emitted);
+    st.round_trips     = base.round_trips + (to.round_trips - from.round_trips);
+    // PnL steps are whole ticks, so these sums are exact.
+    st.realized_pnl    = base.realized_pnl + (to.realized_pnl - from.realized_pnl);
+    return st;
+}
+
+// ---------------------------------------------------------------------------
+// Runner — one strategy over a book, recording accepted signals, every
+// `sync_every` records the strategy state and, with `record_tops`, the top
+// of book as TopRuns (engine/param_sweep.hpp).
+// ---------------------------------------------------------------------------
+struct SyncPoint {
+    State       state;
+    std::size_t signals;   // signals recorded before this point
+};
+
+struct Runner {
+    Runner(OrderBook& ob, const BacktestOptions& opts)
+        : book(ob), strategy(ob, opts.ema_alpha, opts.threshold) {}
+
+    OrderBook&                  book;
+    ImbalanceStrategy           strategy;
+    std::vector<StrategySignal> signals;
+    std::vector<SyncPoint>      syncs;
+    std::vector<TopRun>         tops;
+    std::uint64_t               updates     = 0;
+    std::uint64_t               sync_every  = 0;
+    bool                        record_tops = false;
+
+    void step(std::span<const MarketUpdate> run, const RiskManager* risk) {
+        StrategySignal sig;
+        for (const MarketUpdate& u : run) {
+            book.applyUpdate(u);
+            if (record_tops) {
+                // A new run wherever ImbalanceStrategy would re-read the top.
+                const BookFeatures& f = book.features();
+                if (f.top_changed || tops.empty() || tops.back().updates == UINT32_MAX) {
+                    tops.push_back({f.bid_price, f.ask_price, f.bid_qty, f.ask_qty, 0,
+                                    f.has_bid && f.has_ask});
+                }
+                ++tops.back().updates;
+            }
+            strategy.on_market_update(u);
+            while (strategy.poll_signal(sig)) {
+                if (risk && risk->check(sig)) signals.push_back(sig);
+            }
+            if (sync_every != 0 && ++updates % sync_every == 0) {
+                syncs.push_back({strategy.state(), signals.size()});
+            }
+        }
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Segment — records [begin, end) on their own book.
+// ---------------------------------------------------------------------------
+struct Segment {
+    Segment(const IndexBookConfig& cfg, const BacktestOptions& opts,
+            std::uint64_t first, std::uint64_t last)
+        : book(make_book(cfg, opts.depth_levels))
+        , run(*book, opts)
+        , begin(first)
+        , end(last) {}
+
+    std::unique_ptr<OrderBook> book;
+    Runner                     run;
+    std::uint64_t              begin;
+    std::uint64_t              end;
+    FeedPosition               start;        // position of record `begin`
+    State                      start_state;
+    State                      end_state;
+    bool                       has_end_mid = false;
+    std::int64_t               end_mid     = 0;
+    bool                       ok = true;
+};
+
+void run_segment(Segment& seg, const char* feed, const FeedIndex& index,
+                 const RiskManager& risk, const BacktestOptions& opts) {
+    if (seg.begin != 0) {
+        const std::uint64_t warm_from = seg.begin - std::min(opts.warmup_records, seg.begin);
+        FeedPosition pos;
+        if (!seek_feed_record(feed, &index, warm_from, *seg.book, pos)) {
+            seg.ok = false;
+            return;
+        }
+        replay_feed_records(feed, pos, seg.begin - warm_from,
+                            [&](std::span<const MarketUpdate> r) {
+                                seg.run.step(r, nullptr);
+                                return true;
+                            },
+                            &seg.start);
+        seg.run.updates     = 0;
+        seg.run.sync_every  = opts.sync_records;
+        seg.run.record_tops = true;
+    }
+    seg.start_state = seg.run.strategy.state();
+    seg.run.updates = replay_feed_records(feed, seg.start, seg.end - seg.begin,
+                                          [&](std::span<const MarketUpdate> r) {
+                                              seg.run.step(r, &risk);
+                                              return true;
+                                          });
+    seg.end_state   = seg.run.strategy.state();
+    seg.has_end_mid = book_mid(*seg.book, seg.end_mid);
+}
+
+// Replays the strategy alone over `seg`'s top-of-book stream, resumed
+// from `carry`, until it reaches a sync point where the parallel run had
+// the same carry; from there on the parallel run's signals and totals are
+// correct. The book does not depend on the strategy, so the stream is what
+// a replay of the feed would show it. Returns the state after the segment
+// and sets `signals`.
+State rerun_segment(const Segment& seg, const RiskManager& risk, const BacktestOptions& opts,
+                    const State& carry, std::vector<StrategySignal>& signals,
+                    std::uint64_t& replayed) {
+    ImbalanceStrategy again(opts.ema_alpha, opts.threshold);
+    again.setState(carry);
+
+    const std::vector<SyncPoint>& syncs = seg.run.syncs;
+    std::uint64_t  updates = 0;
+    StrategySignal sig;
+    for (const TopRun& r : seg.run.tops) {
+        again.on_top(r.two_sided, r.bid_price, r.ask_price, r.bid_qty, r.ask_qty);
+        for (std::uint32_t k = 0; k < r.updates; ++k) {
+            again.on_tick();
+            while (again.poll_signal(sig)) {
+                if (risk.check(sig)) signals.push_back(sig);
+            }
+            if (opts.sync_records == 0 || ++updates % opts.sync_records != 0) continue;
+            const SyncPoint& sync = syncs[updates / opts.sync_records - 1];
+            const State      st   = again.state();
+            if (st.sameCarry(sync.state)) {
+                replayed += updates;
+                signals.insert(signals.end(), seg.run.signals.begin() + sync.signals,
+                               seg.run.signals.end());
+                return advance(st, sync.state, seg.end_state);
+            }
+        }
+    }
+    replayed += seg.run.updates;
+    return again.state();
+}
+
+} // namespace
+
+BacktestResult run_serial_backtest(const char* feed, const IndexBookConfig& book,
+                                   const RiskManager& risk, const BacktestOptions& opts) {
+    Segment seg(book, opts, 0, UINT64_MAX);
+    seg.run.updates = replay_feed_records(feed, {}, UINT64_MAX,
+                                          [&](std::span<const MarketUpdate> r) {
+                                              seg.run.step(r, &risk);
+                                              return true;
+                                          });
+    BacktestResult res;
+    res.state     = seg.run.strategy.state();
+    std::int64_t mid = 0;
+    const bool has_mid = book_mid(*seg.book, mid);
+    res.total_pnl = total_pnl(res.state, has_mid, mid);
+    res.signals   = std::move(seg.run.signals);
+    res.updates   = seg.run.updates;
+    res.segments  = 1;
+    return res;
+}
+
+BacktestResult run_segmented_backtest(const char* feed, const FeedIndex& index,
+                                      const RiskManager& risk, const BacktestOptions& opts) {
+    IndexBookConfig cfg;
+    if (index.ok()) {
+        cfg.min_price  = index.header().min_price;
+        cfg.max_price  = index.header().max_price;
+        cfg.max_orders = index.header().max_orders;
+        cfg.id_index   = static_cast<OrderIdIndex>(index.header().id_index);
+    }
+    std::error_code ec;
+    const auto bytes = std::filesystem::file_size(feed, ec);
+    const std::uint64_t n = index.ok() ? index.header().num_records : 0;
+    const std::size_t   k = static_cast<std::size_t>(
+        std::min<std::uint64_t>(std::max<std::size_t>(opts.segments, 1), n));
+    if (ec || !index.ok() || bytes != index.header().feed_bytes || k < 2) {
+        return run_serial_backtest(feed, cfg, risk, opts);
+    }
+
+    // Each thread builds and frees its own book (max_orders-sized, touched
+    // in full by the constructor), so neither happens k times serially.
+    std::vector<std::unique_ptr<Segment>> segs(k);
+    std::vector<std::thread> threads;
+    threads.reserve(k);
+    for (std::size_t i = 0; i < k; ++i) {
+        const bool pin = i < opts.cores.size();
+        const std::uint32_t core = pin ? opts.cores[i] : 0;
+        threads.emplace_back([&, i, pin, core] {
+            if (pin) pin_thread_to_core(core);
+            segs[i] = std::make_unique<Segment>(cfg, opts, n * i / k, n * (i + 1) / k);
+            run_segment(*segs[i], feed, index, risk, opts);
+            segs[i]->book.reset();   // the runner is done with it
+        });
+    }
+    for (auto& t : threads) t.join();
+    if (!std::all_of(segs.begin(), segs.end(), [](const auto& s) { return s->ok; })) {
+        return run_serial_backtest(feed, cfg, risk, opts);
+    }
+
+    BacktestResult res;
+    res.segments = k;
+    State carry  = segs[0]->end_state;
+    res.signals  = std::move(segs[0]->run.signals);
+    res.updates  = segs[0]->run.updates;
+    for (std::size_t i = 1; i < k; ++i) {
+        Segment& seg = *segs[i];
+        res.updates += seg.run.updates;
+        if (seg.start_state.sameCarry(carry)) {
+            carry = advance(carry, seg.start_state, seg.end_state);
+            res.signals.insert(res.signals.end(), seg.run.signals.begin(), seg.run.signals.end());
+            continue;
+        }
+        std::vector<StrategySignal> signals;
+        carry = rerun_segment(seg, risk, opts, carry, signals, res.rerun_records);
+        res.signals.insert(res.signals.end(), signals.begin(), signals.end());
+        ++res.reruns;
+    }
+    res.state     = carry;
+    res.total_pnl = total_pnl(carry, segs[k - 1]->has_end_mid, segs[k - 1]->end_mid);
+    return res;
+}
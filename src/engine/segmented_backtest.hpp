@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "engine/imbalance_strategy.hpp"
+#include "engine/strategy_interface.hpp"
+#include "replay/feed_index.hpp"
+#include "risk/risk_manager.hpp"
+
+// ---------------------------------------------------------------------------
+// Segmented backtest
+//
+// Runs ImbalanceStrategy over one feed file as K record ranges in parallel,
+// one thread (and OrderBook) per range, and produces exactly the result of
+// a serial run:
+//
+//   1. Segment i covers records [i*N/K, (i+1)*N/K). Its book is seeded from
+//      the feed index (latest checkpoint, then catch-up), `warmup_records`
+//      before its start.
+//   2. The warmup records drive the strategy without recording signals,
+//      so its EMA and position converge to what the serial run carries in.
+//      From the segment start the strategy state is recorded, and the top
+//      of book is kept as a TopRun stream (engine/param_sweep.hpp).
+//   3. After all threads finish, segments are reconciled in order: if the
+//      state segment i started with has the same carry as where segment
+//      i-1 really ended (State::sameCarry), its signals and PnL are taken
+//      as is. Otherwise the strategy alone is replayed again on the
+//      calling thread over the segment's top-of-book stream, resumed from
+//      segment i-1's end state, until it reaches one of the states the
+//      parallel run recorded every `sync_records` with the same carry
+//      (positions only re-align on a signal). The parallel run's signals
+//      and PnL are spliced in from there. No feed record or book update is
+//      replayed, so a carry that never re-aligns (an EMA stalled one ulp
+//      apart) costs one strategy step per record.
+//
+// Every signal is polled right after the update that produced it and
+// passed through the risk check, as EventLoop does.
+// ---------------------------------------------------------------------------
+
+struct BacktestOptions {
+    double        ema_alpha      = 0.1;
+    double        threshold      = 0.3;
+    std::size_t   depth_levels   = 5;         // OrderBook::enableFeatures
+    std::size_t   segments       = 4;
+    std::uint64_t warmup_records = 100'000;
+    std::uint64_t sync_records   = 4'096;
+    // Segment i runs on cores[i] if present.
+    std::vector<std::uint32_t> cores;
+};
+
+struct BacktestResult {
+    ImbalanceStrategy::State    state;            // as left by a serial run
+    double                      total_pnl = 0.0;  // realized + open position at the final mid
+    std::vector<StrategySignal> signals;          // passed the risk check, in feed order
+    std::uint64_t               updates  = 0;
+    std::size_t                 segments = 0;
+    std::size_t                 reruns   = 0;     // segments replayed again in step 3
+    std::uint64_t               rerun_records = 0;   // strategy updates replayed in step 3
+};
+
+// Reference: the whole feed through one book and strategy.
+BacktestResult run_serial_backtest(const char* feed, const IndexBookConfig& book,
+                                   const RiskManager& risk, const BacktestOptions& opts = {});
+
+// Segments are seeded from `index` and use the book configuration it was
+// built with. Falls back to run_serial_backtest if the index does not match
+// the feed or the feed is too short to split.
+BacktestResult run_segmented_backtest(const char* feed, const FeedIndex& index,
+                                      const RiskManager& risk, const BacktestOptions& opts = {});
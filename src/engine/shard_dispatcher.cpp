@@ -0,0 +1,77 @@
+#include "engine/shard_dispatcher.hpp"
+
+#include "util/cpu_affinity.hpp"
+
+ShardDispatcher::ShardDispatcher(std::size_t num_shards, std::size_t queue_capacity,
+                                 const WaitStrategy::Options& wait)
+    : wait_(wait)
+{
+    std::vector<MdQueue*> queues;
+    shards_.reserve(num_shards);
+    for (std::size_t i = 0; i < num_shards; ++i) {
+        shards_.push_back(std::make_unique<Shard>(queue_capacity));
+        Shard& shard = *shards_.back();
+        // Only parking consumers need the producer to ring.
+        if (wait_.kind == WaitStrategy::Kind::Park) shard.queue.set_doorbell(&shard.doorbell);
+        queues.push_back(&shard.queue);
+    }
+    feed_handler_ = std::make_unique<FeedHandler>(queues.data(), queues.size());
+}
+
+ShardDispatcher::~ShardDispatcher() {
+    finish();
+}
+
+void ShardDispatcher::start(const std::vector<std::uint32_t>& cores) {
+    producer_done_.store(false, std::memory_order_relaxed);
+    for (std::size_t i = 0; i < shards_.size(); ++i) {
+        Shard& shard = *shards_[i];
+        const bool pin = i < cores.size();
+        const std::uint32_t core = pin ? cores[i] : 0;
+        shard.thread = std::thread([this, &shard, pin, core] {
+            if (pin) pin_thread_to_core(core);
+            consume(shard);
+        });
+    }
+}
+
+void ShardDispatcher::finish() {
+    producer_done_.store(true, std::memory_order_release);
+    for (auto& shard : shards_) {
+        shard->doorbell.ring();   // wake a parked consumer to see producer_done_
+        if (shard->thread.joinable()) shard->thread.join();
+    }
+}
+
+std::uint64_t ShardDispatcher::consumed() const noexcept {
+    std::uint64_t total = 0;
+    for (const auto& shard : shards_) total += shard->consumed;
+    return total;
+}
+
+void ShardDispatcher::consume(Shard& shard) {
+    std::uint64_t n = 0;
+    WaitStrategy wait(wait_, &shard.doorbell);
+    auto drain = [&] {
+        const auto batch = shard.queue.peek(256);   // read in place
+        for (const MarketUpdate& u : batch) shard.books.applyUpdate(u);
+        shard.queue.release(batch.size());
+        n += batch.size();
+        return !batch.empty();
+    };
+    while (true) {
+        if (drain()) {
+            wait.reset();
+            continue;
+        } else if (producer_done_.load(std::memory_order_acquire)) {
+            // Producer is finished — drain whatever is left in the ring.
+            while (drain()) {}
+            break;
+        }
+        // Ring transiently empty, producer still running.
+        wait.idle([&] {
+            return !shard.queue.empty() || producer_done_.load(std::memory_order_acquire);
+        });
+    }
+    shard.consumed = n;
+}
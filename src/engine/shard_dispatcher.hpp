@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "core/book_manager.hpp"
+#include "core/ring_buffer.hpp"
+#include "core/wait_strategy.hpp"
+#include "feed/feed_handler.hpp"
+
+// ---------------------------------------------------------------------------
+// ShardDispatcher
+//
+// Multi-instrument pipeline with one producer and N consumer threads:
+//
+//   replay → feedHandler() ──shardOf(symbol_id)──→ SpscRing[k] → consumer k
+//                                                                → BookManager[k]
+//
+// Every symbol is owned by exactly one shard, so each book is only touched by
+// its shard's thread and the shards share nothing but the producer. Register
+// books with addBook() before start(); the dispatcher places each one on the
+// shard that FeedHandler::shardOf() routes its symbol to. `wait` sets what
+// a consumer does while its ring is empty (core/wait_strategy.hpp).
+// ---------------------------------------------------------------------------
+class ShardDispatcher {
+public:
+    ShardDispatcher(std::size_t num_shards, std::size_t queue_capacity,
+                    const WaitStrategy::Options& wait = {});
+    ~ShardDispatcher();
+
+    ShardDispatcher(const ShardDispatcher&)            = delete;
+    ShardDispatcher& operator=(const ShardDispatcher&) = delete;
+
+    std::size_t numShards() const noexcept { return shards_.size(); }
+
+    // Producer-side entry point (pass to run_mmap_replay).
+    FeedHandler& feedHandler() noexcept { return *feed_handler_; }
+
+    std::size_t shardOf(std::uint16_t symbol_id) const noexcept {
+        return FeedHandler::shardOf(symbol_id, shards_.size());
+    }
+
+    BookManager& books(std::size_t shard) noexcept { return shards_[shard]->books; }
+
+    template <typename... Args>
+    OrderBook& addBook(std::uint16_t symbol_id, Args&&... args) {
+        return books(shardOf(symbol_id)).addBook(symbol_id, std::forward<Args>(args)...);
+    }
+
+    // Launch one consumer per shard. If `cores` is non-empty, shard i is
+    // pinned to cores[i].
+    void start(const std::vector<std::uint32_t>& cores = {});
+
+    // Call once the producer has published its last update: consumers drain
+    // their rings and are joined.
+    void finish();
+
+    // Valid after finish().
+    std::uint64_t consumed(std::size_t shard) const noexcept { return shards_[shard]->consumed; }
+    std::uint64_t consumed() const noexcept;
+
+private:
+    struct Shard {
+        explicit Shard(std::size_t capacity) : queue(capacity) {}
+
+        MdQueue       queue;
+        Doorbell      doorbell;
+        BookManager   books;
+        std::uint64_t consumed = 0;
+        std::thread   thread;
+    };
+
+    void consume(Shard& shard);
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::unique_ptr<FeedHandler>        feed_handler_;
+    WaitStrategy::Options               wait_;
+    std::atomic<bool>                   producer_done_{false};
+};
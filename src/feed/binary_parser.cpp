@@ -13,4 +13,16 @@ size_t BinaryParser::parse(const uint8_t* begin,
     // Feed file is raw MarketUpdate structs written by generate_feed
     std::memcpy(&out, begin, sizeof(MarketUpdate));
     return sizeof(MarketUpdate);
-}
\ No newline at end of file
+}
+
+std::span<const MarketUpdate> BinaryParser::parseBatch(const uint8_t* begin,
+                                                       const uint8_t* end,
+                                                       size_t max_records) const noexcept
+{
+    if (reinterpret_cast<uintptr_t>(begin) % alignof(MarketUpdate) != 0) {
+        return {};
+    }
+    const size_t whole = static_cast<size_t>(end - begin) / sizeof(MarketUpdate);
+    const size_t n     = whole < max_records ? whole : max_records;
+    return { reinterpret_cast<const MarketUpdate*>(begin), n };
+}
@@ -1,4 +1,8 @@
+#pragma once
+
+#include <cstddef>
 #include <cstdint>
+#include <span>
 #include "../core/market_data.hpp"
 
 struct BinaryParser {
@@ -6,4 +10,12 @@ struct BinaryParser {
     size_t parse(const uint8_t* begin,
                       const uint8_t* end,
                       MarketUpdate& out);
+
+    // Zero-copy: views up to `max_records` whole records in place, without
+    // copying them out of the buffer. Returns an empty span if less than one
+    // record remains or `begin` is not aligned for MarketUpdate; in the
+    // latter case parse() still works.
+    std::span<const MarketUpdate> parseBatch(const uint8_t* begin,
+                                             const uint8_t* end,
+                                             size_t max_records) const noexcept;
 };
@@ -0,0 +1,346 @@
+#include "compact_codec.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define COMPACT_HAVE_AVX2_PATH 1
+#else
+#define COMPACT_HAVE_AVX2_PATH 0
+#endif
+
+namespace {
+
+inline uint64_t zigzag(int64_t v) noexcept {
+    return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+inline int64_t unzigzag(uint64_t v) noexcept {
+    return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+}
+
+// Smallest of 0/1/2/4/8 bytes that holds `range`.
+inline uint8_t width_for(uint64_t range) noexcept {
+    if (range == 0)          return 0;
+    if (range <= 0xFF)       return 1;
+    if (range <= 0xFFFF)     return 2;
+    if (range <= 0xFFFFFFFF) return 4;
+    return 8;
+}
+
+inline bool valid_width(uint8_t w) noexcept {
+    return w == 0 || w == 1 || w == 2 || w == 4 || w == 8;
+}
+
+inline uint8_t meta_of(const MarketUpdate& u) noexcept {
+    return static_cast<uint8_t>((static_cast<uint8_t>(u.type) & 0x0F)
+                              | (static_cast<uint8_t>(u.side) << 4));
+}
+
+// ---------------------------------------------------------------------------
+// Column unpacking: dst[i] = base + load_width(src + i * w)
+// ---------------------------------------------------------------------------
+void unpack_scalar(const uint8_t* src, uint8_t w, uint64_t base,
+                   size_t n, uint64_t* dst) noexcept {
+    switch (w) {
+    case 0: std::fill(dst, dst + n, base); break;
+    case 1: for (size_t i = 0; i < n; ++i) dst[i] = base + src[i]; break;
+    case 2: for (size_t i = 0; i < n; ++i) { uint16_t v; std::memcpy(&v, src + 2 * i, 2); dst[i] = base + v; } break;
+    case 4: for (size_t i = 0; i < n; ++i) { uint32_t v; std::memcpy(&v, src + 4 * i, 4); dst[i] = base + v; } break;
+    default: for (size_t i = 0; i < n; ++i) { uint64_t v; std::memcpy(&v, src + 8 * i, 8); dst[i] = base + v; } break;
+    }
+}
+
+// In place: x[i] = prev + unzigzag(x[i]), prev = x[i].
+void undelta_scalar(uint64_t* x, size_t n, uint64_t start) noexcept {
+    uint64_t prev = start;
+    for (size_t i = 0; i < n; ++i) {
+        prev += static_cast<uint64_t>(unzigzag(x[i]));
+        x[i] = prev;
+    }
+}
+
+void unzigzag_scalar(uint64_t* x, size_t n) noexcept {
+    for (size_t i = 0; i < n; ++i) x[i] = static_cast<uint64_t>(unzigzag(x[i]));
+}
+
+#if COMPACT_HAVE_AVX2_PATH
+
+// Widens 4 values per iteration with vpmovzx{bq,wq,dq}; the tail is scalar
+// so no load reads past the end of the column.
+__attribute__((target("avx2")))
+void unpack_avx2(const uint8_t* src, uint8_t w, uint64_t base,
+                 size_t n, uint64_t* dst) noexcept {
+    const __m256i vbase = _mm256_set1_epi64x(static_cast<long long>(base));
+    size_t i = 0;
+    switch (w) {
+    case 0:
+        for (; i + 4 <= n; i += 4) _mm256_storeu_si256((__m256i*)(dst + i), vbase);
+        break;
+    case 1:
+        for (; i + 4 <= n; i += 4) {
+            int32_t raw; std::memcpy(&raw, src + i, 4);
+            const __m256i v = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(raw));
+            _mm256_storeu_si256((__m256i*)(dst + i), _mm256_add_epi64(v, vbase));
+        }
+        break;
+    case 2:
+        for (; i + 4 <= n; i += 4) {
+            const __m256i v = _mm256_cvtepu16_epi64(_mm_loadl_epi64((const __m128i*)(src + 2 * i)));
+            _mm256_storeu_si256((__m256i*)(dst + i), _mm256_add_epi64(v, vbase));
+        }
+        break;
+    case 4:
+        for (; i + 4 <= n; i += 4) {
+            const __m256i v = _mm256_cvtepu32_epi64(_mm_loadu_si128((const __m128i*)(src + 4 * i)));
+            _mm256_storeu_si256((__m256i*)(dst + i), _mm256_add_epi64(v, vbase));
+        }
+        break;
+    default:
+        for (; i + 4 <= n; i += 4) {
+            const __m256i v = _mm256_loadu_si256((const __m256i*)(src + 8 * i));
+            _mm256_storeu_si256((__m256i*)(dst + i), _mm256_add_epi64(v, vbase));
+        }
+        break;
+    }
+    unpack_scalar(src + w * i, w, base, n - i, dst + i);
+}
+
+__attribute__((target("avx2")))
+inline __m256i unzigzag4(__m256i x) noexcept {
+    const __m256i one = _mm256_set1_epi64x(1);
+    return _mm256_xor_si256(_mm256_srli_epi64(x, 1),
+                            _mm256_sub_epi64(_mm256_setzero_si256(), _mm256_and_si256(x, one)));
+}
+
+// Un-zigzag + inclusive prefix sum, 4 lanes at a time: two shift-and-add
+// steps inside the register, then add the running total carried from the
+// previous group.
+__attribute__((target("avx2")))
+void undelta_avx2(uint64_t* x, size_t n, uint64_t start) noexcept {
+    const __m256i zero  = _mm256_setzero_si256();
+    __m256i       carry = _mm256_set1_epi64x(static_cast<long long>(start));
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i v = unzigzag4(_mm256_loadu_si256((const __m256i*)(x + i)));
+        // [a b c d] + [0 a b c]
+        v = _mm256_add_epi64(v, _mm256_blend_epi32(
+                _mm256_permute4x64_epi64(v, _MM_SHUFFLE(2, 1, 0, 0)), zero, 0x03));
+        // + [0 0 a a+b]
+        v = _mm256_add_epi64(v, _mm256_blend_epi32(
+                _mm256_permute4x64_epi64(v, _MM_SHUFFLE(1, 0, 0, 0)), zero, 0x0F));
+        v = _mm256_add_epi64(v, carry);
+        _mm256_storeu_si256((__m256i*)(x + i), v);
+        carry = _mm256_permute4x64_epi64(v, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+    undelta_scalar(x + i, n - i, i ? x[i - 1] : start);
+}
+
+__attribute__((target("avx2")))
+void unzigzag_avx2(uint64_t* x, size_t n) noexcept {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_si256((__m256i*)(x + i),
+                            unzigzag4(_mm256_loadu_si256((const __m256i*)(x + i))));
+    }
+    unzigzag_scalar(x + i, n - i);
+}
+
+#endif
+
+void unpack(bool simd, const uint8_t* src, uint8_t w, uint64_t base,
+            size_t n, uint64_t* dst) noexcept {
+#if COMPACT_HAVE_AVX2_PATH
+    if (simd) return unpack_avx2(src, w, base, n, dst);
+#endif
+    (void)simd;
+    unpack_scalar(src, w, base, n, dst);
+}
+
+void undelta(bool simd, uint64_t* x, size_t n, uint64_t start) noexcept {
+#if COMPACT_HAVE_AVX2_PATH
+    if (simd) return undelta_avx2(x, n, start);
+#endif
+    (void)simd;
+    undelta_scalar(x, n, start);
+}
+
+void unzigzag_all(bool simd, uint64_t* x, size_t n) noexcept {
+#if COMPACT_HAVE_AVX2_PATH
+    if (simd) return unzigzag_avx2(x, n);
+#endif
+    (void)simd;
+    unzigzag_scalar(x, n);
+}
+
+} // namespace
+
+bool is_compact_feed(const uint8_t* begin, const uint8_t* end) noexcept {
+    return static_cast<size_t>(end - begin) >= sizeof(CompactFileHeader)
+        && std::memcmp(begin, COMPACT_MAGIC, sizeof(COMPACT_MAGIC)) == 0;
+}
+
+// ---------------------------------------------------------------------------
+// CompactFeedWriter
+// ---------------------------------------------------------------------------
+CompactFeedWriter::CompactFeedWriter(std::ostream& out, uint32_t block_records)
+    : out_(out)
+    , header_pos_(out.tellp())
+    , block_records_(std::clamp<uint32_t>(block_records, 1, 0xFFFF))
+{
+    pending_.reserve(block_records_);
+    for (auto& c : cols_) c.resize(block_records_);
+
+    CompactFileHeader h{};
+    std::memcpy(h.magic, COMPACT_MAGIC, sizeof(h.magic));
+    h.version       = COMPACT_VERSION;
+    h.block_records = block_records_;
+    h.num_records   = 0;
+    out_.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    bytes_written_ += sizeof(h);
+}
+
+void CompactFeedWriter::write(const MarketUpdate& u) {
+    pending_.push_back(u);
+    ++num_records_;
+    if (pending_.size() == block_records_) flushBlock();
+}
+
+void CompactFeedWriter::flushBlock() {
+    const size_t n = pending_.size();
+    if (n == 0) return;
+
+    CompactBlockHeader h{};
+    h.count          = static_cast<uint16_t>(n);
+    h.first_ts       = pending_[0].ts;
+    h.first_order_id = pending_[0].order_id;
+    h.first_price    = pending_[0].price;
+
+    uint64_t prev_ts = h.first_ts, prev_id = h.first_order_id;
+    int64_t  prev_px = h.first_price;
+    for (size_t i = 0; i < n; ++i) {
+        const MarketUpdate& u = pending_[i];
+        cols_[COL_TS][i]       = zigzag(static_cast<int64_t>(u.ts - prev_ts));
+        cols_[COL_ORDER_ID][i] = zigzag(static_cast<int64_t>(u.order_id - prev_id));
+        cols_[COL_PRICE][i]    = zigzag(static_cast<int64_t>(
+                                     static_cast<uint64_t>(u.price) - static_cast<uint64_t>(prev_px)));
+        cols_[COL_QTY][i]      = zigzag(u.qty);
+        cols_[COL_SYMBOL][i]   = u.symbol_id;
+        cols_[COL_META][i]     = meta_of(u);
+        prev_ts = u.ts;
+        prev_id = u.order_id;
+        prev_px = u.price;
+    }
+
+    payload_.clear();
+    for (size_t c = 0; c < COMPACT_NUM_COLUMNS; ++c) {
+        const auto [lo, hi] = std::minmax_element(cols_[c].begin(), cols_[c].begin() + n);
+        const uint64_t base = *lo;
+        const uint8_t  w    = width_for(*hi - base);
+        h.base[c]  = base;
+        h.width[c] = w;
+
+        const size_t at = payload_.size();
+        payload_.resize(at + n * w);
+        uint8_t* dst = payload_.data() + at;
+        for (size_t i = 0; i < n; ++i) {
+            const uint64_t v = cols_[c][i] - base;   // little-endian: low w bytes
+            std::memcpy(dst + i * w, &v, w);
+        }
+    }
+    h.payload_bytes = static_cast<uint32_t>(payload_.size());
+
+    out_.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    out_.write(reinterpret_cast<const char*>(payload_.data()),
+               static_cast<std::streamsize>(payload_.size()));
+    bytes_written_ += sizeof(h) + payload_.size();
+    pending_.clear();
+}
+
+void CompactFeedWriter::finish() {
+    flushBlock();
+    const std::streamoff end = out_.tellp();
+    if (header_pos_ < 0 || end < 0) return;   // not seekable: num_records stays 0
+    out_.seekp(header_pos_ + static_cast<std::streamoff>(offsetof(CompactFileHeader, num_records)));
+    out_.write(reinterpret_cast<const char*>(&num_records_), sizeof(num_records_));
+    out_.seekp(end);
+    out_.flush();
+}
+
+// ---------------------------------------------------------------------------
+// CompactBlockDecoder
+// ---------------------------------------------------------------------------
+bool CompactBlockDecoder::cpuHasAvx2() noexcept {
+#if COMPACT_HAVE_AVX2_PATH
+    static const bool has = [] {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+    }();
+    return has;
+#else
+    return false;
+#endif
+}
+
+CompactBlockDecoder::CompactBlockDecoder(bool allow_simd)
+    : simd_(allow_simd && cpuHasAvx2())
+{}
+
+size_t CompactBlockDecoder::blockSize(const uint8_t* p, const uint8_t* end) noexcept {
+    if (static_cast<size_t>(end - p) < sizeof(CompactBlockHeader)) return 0;
+    uint32_t payload;
+    std::memcpy(&payload, p + offsetof(CompactBlockHeader, payload_bytes), sizeof(payload));
+    const size_t total = sizeof(CompactBlockHeader) + payload;
+    return static_cast<size_t>(end - p) >= total ? total : 0;
+}
+
+size_t CompactBlockDecoder::decode(const uint8_t* p, const uint8_t* end,
+                                   MarketUpdate* out, size_t capacity, size_t& consumed) {
+    consumed = 0;
+    const size_t total = blockSize(p, end);
+    if (total == 0) return 0;
+
+    CompactBlockHeader h;
+    std::memcpy(&h, p, sizeof(h));
+    const size_t n = h.count;
+    if (n == 0 || n > capacity) return 0;
+
+    size_t expect = 0;
+    for (size_t c = 0; c < COMPACT_NUM_COLUMNS; ++c) {
+        if (!valid_width(h.width[c])) return 0;
+        expect += n * h.width[c];
+    }
+    if (expect != h.payload_bytes) return 0;
+
+    const uint8_t* col = p + sizeof(CompactBlockHeader);
+    for (size_t c = 0; c < COMPACT_NUM_COLUMNS; ++c) {
+        if (cols_[c].size() < n) cols_[c].resize(n);
+        unpack(simd_, col, h.width[c], h.base[c], n, cols_[c].data());
+        col += n * h.width[c];
+    }
+    undelta(simd_, cols_[COL_TS].data(),       n, h.first_ts);
+    undelta(simd_, cols_[COL_ORDER_ID].data(), n, h.first_order_id);
+    undelta(simd_, cols_[COL_PRICE].data(),    n, static_cast<uint64_t>(h.first_price));
+    unzigzag_all(simd_, cols_[COL_QTY].data(), n);
+
+    const uint64_t* ts  = cols_[COL_TS].data();
+    const uint64_t* id  = cols_[COL_ORDER_ID].data();
+    const uint64_t* px  = cols_[COL_PRICE].data();
+    const uint64_t* qty = cols_[COL_QTY].data();
+    const uint64_t* sym = cols_[COL_SYMBOL].data();
+    const uint64_t* mt  = cols_[COL_META].data();
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = MarketUpdate{ts[i],
+                              static_cast<UpdateType>(mt[i] & 0x0F),
+                              id[i],
+                              static_cast<int64_t>(px[i]),
+                              static_cast<int64_t>(qty[i]),
+                              static_cast<OrderSide>((mt[i] >> 4) & 0x0F),
+                              0,
+                              static_cast<uint16_t>(sym[i]),
+                              {}};
+    }
+
+    consumed = total;
+    return n;
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+#include "../core/market_data.hpp"
+
+// ---------------------------------------------------------------------------
+// Compact feed format
+//
+// A file header followed by independently decodable blocks of up to
+// `block_records` updates. Inside a block every field is a column:
+//
+//   ts, order_id, price   zigzag(delta to the previous record); record 0 is
+//                         stored in the block header, so its delta is 0
+//   qty                   zigzag(qty)
+//   symbol_id             raw
+//   meta                  type | side << 4
+//
+// Each column is frame-of-reference packed: the block header holds the
+// column minimum and a byte width (0, 1, 2, 4 or 8) wide enough for
+// (value - minimum); the payload holds `count` values of that width. A
+// column whose values are all equal (e.g. order_id deltas of +1) costs 0
+// bytes per record.
+//
+// Layout (little-endian, no padding between payload columns):
+//   CompactFileHeader
+//   { CompactBlockHeader, column 0 .. column 5 } *
+//
+// MarketUpdate padding/reserved bytes are not stored and decode as zero.
+// ---------------------------------------------------------------------------
+
+inline constexpr char     COMPACT_MAGIC[8]      = {'M', 'D', 'C', 'O', 'M', 'P', 'C', 'T'};
+inline constexpr uint32_t COMPACT_VERSION       = 1;
+inline constexpr uint32_t COMPACT_BLOCK_RECORDS = 1024;   // default records per block
+inline constexpr size_t   COMPACT_NUM_COLUMNS   = 6;
+
+enum CompactColumn : uint8_t {
+    COL_TS, COL_ORDER_ID, COL_PRICE, COL_QTY, COL_SYMBOL, COL_META
+};
+
+struct CompactFileHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t block_records;   // max records per block
+    uint64_t num_records;     // total records in the file
+};
+static_assert(sizeof(CompactFileHeader) == 24);
+
+struct CompactBlockHeader {
+    uint32_t payload_bytes;                 // column bytes following this header
+    uint16_t count;                         // records in this block, >= 1
+    uint8_t  width[COMPACT_NUM_COLUMNS];    // bytes per value: 0, 1, 2, 4 or 8
+    uint8_t  _pad[4];
+    uint64_t first_ts;                      // record 0, the delta columns' start
+    uint64_t first_order_id;
+    int64_t  first_price;
+    uint64_t base[COMPACT_NUM_COLUMNS];     // column minimum
+};
+static_assert(sizeof(CompactBlockHeader) == 88);
+
+// True if the buffer starts with a compact file header.
+bool is_compact_feed(const uint8_t* begin, const uint8_t* end) noexcept;
+
+// ---------------------------------------------------------------------------
+// CompactFeedWriter — buffers updates and writes full blocks to `out`.
+// finish() writes the last partial block and, if the stream is seekable,
+// patches num_records in the file header.
+// ---------------------------------------------------------------------------
+class CompactFeedWriter {
+public:
+    explicit CompactFeedWriter(std::ostream& out,
+                               uint32_t block_records = COMPACT_BLOCK_RECORDS);
+
+    void     write(const MarketUpdate& u);
+    void     finish();
+    uint64_t bytesWritten() const noexcept { return bytes_written_; }
+
+private:
+    void flushBlock();
+
+    std::ostream&             out_;
+    std::streamoff            header_pos_;
+    uint32_t                  block_records_;
+    uint64_t                  num_records_   = 0;
+    uint64_t                  bytes_written_ = 0;
+    std::vector<MarketUpdate> pending_;
+    std::vector<uint64_t>     cols_[COMPACT_NUM_COLUMNS];
+    std::vector<uint8_t>      payload_;
+};
+
+// ---------------------------------------------------------------------------
+// CompactBlockDecoder — decodes one block into a caller array of
+// MarketUpdates. Column unpacking uses AVX2 when the CPU has it (selected at
+// run time), scalar code otherwise.
+// ---------------------------------------------------------------------------
+class CompactBlockDecoder {
+public:
+    // allow_simd = false forces the scalar path (tests, A/B benchmarks).
+    explicit CompactBlockDecoder(bool allow_simd = true);
+
+    bool simd() const noexcept { return simd_; }
+    static bool cpuHasAvx2() noexcept;
+
+    // Decodes the block at `p`. Returns the number of records written to
+    // `out` (at most `capacity`) and sets `consumed` to the block's size in
+    // bytes; returns 0 on a truncated/invalid block or if it does not fit.
+    size_t decode(const uint8_t* p, const uint8_t* end,
+                  MarketUpdate* out, size_t capacity, size_t& consumed);
+
+    // Byte size of the block at `p` (header + payload), 0 if truncated.
+    static size_t blockSize(const uint8_t* p, const uint8_t* end) noexcept;
+
+private:
+    bool                  simd_;
+    std::vector<uint64_t> cols_[COMPACT_NUM_COLUMNS];
+};
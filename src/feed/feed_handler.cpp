@@ -2,17 +2,116 @@
 #include <iostream>
 
 FeedHandler::FeedHandler(MdQueue& q)
-    : queue_(q) {
+    : queues_{&q} {
+}
+
+FeedHandler::FeedHandler(MdQueue* const* queues, std::size_t num_queues)
+    : queues_(queues, queues + num_queues) {
+}
+
+FeedHandler::FeedHandler(MdFanInQueue& q)
+    : fan_in_(&q) {
+}
+
+FeedHandler::FeedHandler(MdBroadcast& ring)
+    : broadcast_(&ring) {
+}
+
+FeedHandler::FeedHandler(ShmRing& ring)
+    : shm_(&ring) {
 }
 
 bool FeedHandler::onUpdate(const MarketUpdate& u) {
-    return queue_.push(u);
+    if (shm_) {
+        return shm_->push(u);
+    }
+    if (broadcast_) {
+        return broadcast_->push(u);
+    }
+    if (fan_in_) {
+        return fan_in_->push(u);
+    }
+    if (queues_.size() == 1) {
+        return queues_[0]->push(u);
+    }
+    return queues_[shardOf(u.symbol_id, queues_.size())]->push(u);
+}
+
+// While a ring is full the producer spins briefly, then yields, so a
+// consumer that shares its core (oversubscribed or unpinned runs) gets to
+// drain it.
+static WaitStrategy full_ring_wait() {
+    WaitStrategy::Options o;
+    o.kind = WaitStrategy::Kind::SpinYield;
+    return WaitStrategy(o);
+}
+
+template <typename Queue>
+static void push_all(Queue& q, const MarketUpdate* p, std::size_t n) {
+    WaitStrategy wait = full_ring_wait();
+    while (n != 0) {
+        const std::size_t pushed = q.push_bulk(p, n);   // 0 while full
+        if (pushed == 0) { wait.idle(); continue; }
+        wait.reset();
+        p += pushed;
+        n -= pushed;
+    }
 }
 
-template <typename It>
-void FeedHandler::onBatch(It begin, It end) {
-    for (auto it = begin; it != end; ++it) {
-        const MarketUpdate& u = *it;
-        while (!queue_.push(u)) {}
+void FeedHandler::onBatch(std::span<const MarketUpdate> batch) {
+    const MarketUpdate* p   = batch.data();
+    const MarketUpdate* end = p + batch.size();
+    if (fan_in_) {
+        push_all(*fan_in_, p, batch.size());
+        return;
+    }
+    if (broadcast_) {
+        push_all(*broadcast_, p, batch.size());
+        return;
+    }
+    if (shm_) {
+        push_all(*shm_, p, batch.size());
+        return;
     }
+    if (queues_.size() == 1) {
+        push_all(*queues_[0], p, batch.size());
+        return;
+    }
+    const std::size_t shards = queues_.size();
+    while (p != end) {
+        const std::size_t shard = shardOf(p->symbol_id, shards);
+        const MarketUpdate* run = p + 1;
+        while (run != end && shardOf(run->symbol_id, shards) == shard) ++run;
+        push_all(*queues_[shard], p, static_cast<std::size_t>(run - p));
+        p = run;
+    }
+}
+
+template <typename Ring>
+static std::span<MarketUpdate> claim_all(Ring& ring, std::size_t n) {
+    if (ring.claim_limit() < n) return {};
+    WaitStrategy wait = full_ring_wait();
+    while (true) {
+        const std::span<MarketUpdate> slots = ring.claim(n);   // short while full
+        if (slots.size() == n) return slots;
+        wait.idle();
+    }
+}
+
+std::span<MarketUpdate> FeedHandler::claim(std::size_t n) {
+    if (broadcast_) return claim_all(*broadcast_, n);
+    if (shm_)       return claim_all(*shm_, n);
+    if (fan_in_ || queues_.size() != 1) return {};
+    return claim_all(*queues_[0], n);
+}
+
+void FeedHandler::commit(std::size_t n) {
+    if      (broadcast_) broadcast_->commit(n);
+    else if (shm_)       shm_->commit(n);
+    else                 queues_[0]->commit(n);
+}
+
+void FeedHandler::endOfStream() {
+    if (shm_) shm_->close();
+    for (MdQueue* q : queues_) q->close();
 }
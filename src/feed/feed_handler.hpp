@@ -1,23 +1,72 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "../core/broadcast_ring.hpp"
+#include "../core/mpsc_ring.hpp"
 #include "../core/order_book.hpp"
 #include "../core/ring_buffer.hpp"
+#include "../core/shm_ring.hpp"
 
-using MdQueue = SpscRing<MarketUpdate>;
+using MdQueue      = SpscRing<MarketUpdate>;
+using MdFanInQueue = MpscRing<MarketUpdate>;
+using MdBroadcast  = BroadcastRing<MarketUpdate>;
 
 class FeedHandler {
 public:
     explicit FeedHandler(MdQueue& queue);
 
+    // Multi-instrument: routes each update to queues[shardOf(symbol_id)].
+    FeedHandler(MdQueue* const* queues, std::size_t num_queues);
+
+    // Fan-in: one of several handlers, each on its own decoder thread,
+    // publishing into a queue shared with the others.
+    explicit FeedHandler(MdFanInQueue& queue);
+
+    // Fan-out: every reader of `ring` sees every update.
+    explicit FeedHandler(MdBroadcast& ring);
+
+    // Cross-process: the producer side of a shared-memory ring
+    // (ShmRing::create).
+    explicit FeedHandler(ShmRing& ring);
+
+    // Stable symbol -> shard mapping shared by producers and consumers.
+    // Fibonacci hash scaled into [0, num_shards) without a division.
+    static std::size_t shardOf(std::uint16_t symbol_id, std::size_t num_shards) noexcept {
+        const std::uint32_t h = static_cast<std::uint32_t>(symbol_id) * 0x9E3779B1u;
+        return static_cast<std::size_t>((std::uint64_t{h} * num_shards) >> 32);
+    }
+
     // Called by replay or network code for each decoded update.
     // Returns false if the queue is full (caller decides what to do).
     bool onUpdate(const MarketUpdate& u);
 
-    // Optional: batch helper for replay
-    template <typename It>
-    void onBatch(It begin, It end);
+    // Publishes every update in `batch`, in order, spinning while a queue is
+    // full. Runs of updates bound for the same queue go in with one
+    // push_bulk (a single head update) instead of one push each.
+    void onBatch(std::span<const MarketUpdate> batch);
+
+    // Lets a decoder write straight into the ring instead of a buffer that
+    // onBatch() then copies. Returns `n` contiguous ring slots, spinning
+    // while the consumer frees them, and commit(k) publishes the first k.
+    // Returns an empty span, meaning "decode elsewhere and use onBatch",
+    // if the handler feeds several queues (records must be routed after
+    // decoding), feeds a fan-in queue, or fewer than `n` slots are left
+    // before the ring wraps.
+    std::span<MarketUpdate> claim(std::size_t n);
+    void commit(std::size_t n);
+
+    // End of stream: closes the SPSC queue(s) or shared-memory ring after
+    // the last update, so consumers running concurrently with the replay
+    // (EventLoop::run_streaming) know when to stop. Fan-in and broadcast
+    // consumers are stopped by their dispatcher's finish() instead.
+    void endOfStream();
 
 private:
-    MdQueue& queue_;
+    std::vector<MdQueue*> queues_;
+    MdFanInQueue*         fan_in_    = nullptr;
+    MdBroadcast*          broadcast_ = nullptr;
+    ShmRing*              shm_       = nullptr;
 };
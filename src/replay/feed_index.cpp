@@ -0,0 +1,356 @@
+#include "feed_index.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "mapped_file.hpp"
+#include "../feed/binary_parser.hpp"
+#include "../feed/compact_codec.hpp"
+#include "../feed/feed_handler.hpp"
+
+namespace {
+
+constexpr std::size_t BATCH_RECORDS = 1024;
+
+// ---------------------------------------------------------------------------
+// FeedCursor — walks a mapped raw or compact feed in runs of records and
+// can report the FeedPosition of each record it hands out.
+// ---------------------------------------------------------------------------
+class FeedCursor {
+public:
+    FeedCursor(const uint8_t* begin, const uint8_t* end)
+        : begin_(begin), end_(end), data_(begin), ptr_(begin) {
+        if (begin_ != end_ && is_compact_feed(begin_, end_)) {
+            CompactFileHeader hdr;
+            std::memcpy(&hdr, begin_, sizeof(hdr));
+            if (hdr.version != COMPACT_VERSION) {
+                std::cerr << "Unsupported compact feed version " << hdr.version << "\n";
+                ok_ = false;
+                return;
+            }
+            compact_ = true;
+            block_.resize(hdr.block_records);
+            data_ = ptr_ = begin_ + sizeof(hdr);
+        }
+    }
+
+    bool ok() const noexcept { return ok_; }
+    uint64_t offset() const noexcept { return static_cast<uint64_t>(ptr_ - begin_); }
+
+    // Positions the cursor so that next() starts with the record at `pos`.
+    bool seek(const FeedPosition& pos) {
+        if (pos.offset == 0) {
+            ptr_ = data_;
+            record_ = 0;
+            pending_skip_ = 0;
+            return true;
+        }
+        if (pos.offset > static_cast<uint64_t>(end_ - begin_) || begin_ + pos.offset < data_) return false;
+        if (!compact_ && pos.offset % sizeof(MarketUpdate) != 0) return false;
+        ptr_          = begin_ + pos.offset;
+        record_       = pos.record;
+        pending_skip_ = pos.skip;
+        return true;
+    }
+
+    // Next run of records; empty at the end of the feed (or a truncated or
+    // malformed tail).
+    std::span<const MarketUpdate> next() {
+        if (ptr_ >= end_) return {};
+        span_offset_ = offset();
+        span_record_ = record_;
+        if (!compact_) {
+            const auto span = parser_.parseBatch(ptr_, end_, BATCH_RECORDS);
+            ptr_    += span.size_bytes();
+            record_ += span.size();
+            span_skip_ = 0;
+            return span;
+        }
+        std::size_t consumed = 0;
+        const std::size_t n = decoder_.decode(ptr_, end_, block_.data(), block_.size(), consumed);
+        if (n == 0) {
+            ptr_ = end_;
+            return {};
+        }
+        ptr_ += consumed;
+        const std::size_t skip = std::min<std::size_t>(pending_skip_, n);
+        pending_skip_ = 0;
+        span_skip_    = static_cast<uint32_t>(skip);
+        record_      += n - skip;
+        return {block_.data() + skip, n - skip};
+    }
+
+    // Position of record `i` of the run last returned by next().
+    FeedPosition positionOf(std::size_t i) const noexcept {
+        if (compact_) return {span_offset_, span_skip_ + static_cast<uint32_t>(i), span_record_ + i};
+        return {span_offset_ + i * sizeof(MarketUpdate), 0, span_record_ + i};
+    }
+
+    // Position just past the last record handed out.
+    FeedPosition endPosition() const noexcept {
+        return {static_cast<uint64_t>(end_ - begin_), 0, record_};
+    }
+
+    // Position of the record next() would start with.
+    FeedPosition resumePosition() const noexcept {
+        return {offset(), pending_skip_, record_};
+    }
+
+private:
+    const uint8_t*            begin_;
+    const uint8_t*            end_;
+    const uint8_t*            data_;           // first record or block
+    const uint8_t*            ptr_;
+    bool                      ok_      = true;
+    bool                      compact_ = false;
+    uint64_t                  record_       = 0;
+    uint32_t                  pending_skip_ = 0;
+    uint64_t                  span_offset_  = 0;
+    uint32_t                  span_skip_    = 0;
+    uint64_t                  span_record_  = 0;
+    BinaryParser              parser_;
+    CompactBlockDecoder       decoder_;
+    std::vector<MarketUpdate> block_;
+};
+
+// Restores the checkpoint `pick` selects from a usable index into `book`
+// and applies records until `stop(record, position)` holds.
+template <typename Pick, typename Stop>
+bool seek_to(const char* feed, const FeedIndex* index, OrderBook& book, FeedPosition& pos,
+             Pick pick, Stop stop) {
+    MappedFile file(feed, MmapReplayOptions{});
+    if (!file.ok()) return false;
+    FeedCursor cursor(file.data(), file.data() + file.size());
+    if (!cursor.ok()) return false;
+
+    FeedPosition from{};
+    if (index && index->ok()) {
+        if (index->header().feed_bytes != file.size()) {
+            std::cerr << "Feed index does not match " << feed << ", ignoring it\n";
+        } else if (const FeedIndexEntry* e = pick(*index)) {
+            if (index->restore(*e, book)) from = {e->offset, e->skip, e->record};
+            else std::cerr << "Book does not match the index checkpoints, replaying from the start\n";
+        }
+    }
+    if (!cursor.seek(from)) return false;
+
+    for (auto run = cursor.next(); !run.empty(); run = cursor.next()) {
+        for (std::size_t i = 0; i < run.size(); ++i) {
+            const FeedPosition here = cursor.positionOf(i);
+            if (stop(run[i], here)) {
+                pos = here;
+                return true;
+            }
+            book.applyUpdate(run[i]);
+        }
+    }
+    pos = cursor.endPosition();
+    return true;
+}
+
+MmapReplayOptions random_access() {
+    MmapReplayOptions opts;
+    opts.sequential = false;
+    return opts;
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// Building
+// ---------------------------------------------------------------------------
+bool build_feed_index(const char* feed, const char* index_path, const FeedIndexOptions& opts) {
+    MappedFile file(feed, MmapReplayOptions{});
+    if (!file.ok()) return false;
+    FeedCursor cursor(file.data(), file.data() + file.size());
+    if (!cursor.ok()) return false;
+
+    std::ofstream out(index_path, std::ios::binary);
+    if (!out) {
+        std::cerr << "Failed to open index file: " << index_path << "\n";
+        return false;
+    }
+
+    FeedIndexHeader hdr{};
+    std::memcpy(hdr.magic, FEED_INDEX_MAGIC, sizeof(hdr.magic));
+    hdr.version          = FEED_INDEX_VERSION;
+    hdr.checkpoint_every = std::max<uint32_t>(opts.checkpoint_every, 1);
+    hdr.interval_ns      = std::max<uint64_t>(opts.interval_ns, 1);
+    hdr.feed_bytes       = file.size();
+    hdr.min_price        = opts.book.min_price;
+    hdr.max_price        = opts.book.max_price;
+    hdr.max_orders       = opts.book.max_orders;
+    hdr.id_index         = static_cast<uint8_t>(opts.book.id_index);
+    out.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+
+    OrderBook book(opts.book.min_price, opts.book.max_price,
+                   static_cast<size_t>(opts.book.max_orders), opts.book.id_index);
+    std::vector<FeedIndexEntry> entries;
+    std::vector<BookOrder>      orders;
+    uint64_t next_ts = 0;
+    // Previous checkpoint: entry number, feed offset and bytes written.
+    uint64_t cp_entry = 0, cp_offset = 0, cp_bytes = 0;
+
+    for (auto run = cursor.next(); !run.empty(); run = cursor.next()) {
+        for (std::size_t i = 0; i < run.size(); ++i) {
+            const MarketUpdate& u = run[i];
+            if (hdr.num_records == 0 || u.ts >= next_ts) {
+                const FeedPosition pos = cursor.positionOf(i);
+                FeedIndexEntry e{u.ts, pos.record, pos.offset, pos.skip, 0, 0};
+                if (!entries.empty() && entries.size() - cp_entry >= hdr.checkpoint_every
+                    && pos.offset - cp_offset >= std::max(opts.checkpoint_min_bytes, cp_bytes)) {
+                    // The book holds everything before this record.
+                    orders.clear();
+                    book.snapshotOrders(orders);
+                    const uint64_t n = orders.size();
+                    e.checkpoint = static_cast<uint64_t>(out.tellp());
+                    out.write(reinterpret_cast<const char*>(&n), sizeof(n));
+                    out.write(reinterpret_cast<const char*>(orders.data()),
+                              static_cast<std::streamsize>(n * sizeof(BookOrder)));
+                    cp_entry  = entries.size();
+                    cp_offset = pos.offset;
+                    cp_bytes  = sizeof(n) + n * sizeof(BookOrder);
+                }
+                entries.push_back(e);
+                next_ts = (u.ts / hdr.interval_ns + 1) * hdr.interval_ns;
+                if (hdr.num_records == 0) hdr.first_ts = u.ts;
+            }
+            book.applyUpdate(u);
+            hdr.last_ts = u.ts;
+            ++hdr.num_records;
+        }
+    }
+
+    hdr.entries_offset = static_cast<uint64_t>(out.tellp());
+    hdr.num_entries    = entries.size();
+    out.write(reinterpret_cast<const char*>(entries.data()),
+              static_cast<std::streamsize>(entries.size() * sizeof(FeedIndexEntry)));
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+    return static_cast<bool>(out);
+}
+
+// ---------------------------------------------------------------------------
+// Reading
+// ---------------------------------------------------------------------------
+FeedIndex::FeedIndex(const char* index_path)
+    : file_(std::make_unique<MappedFile>(index_path, random_access())) {
+    if (!file_->ok() || file_->size() < sizeof(FeedIndexHeader)) return;
+    const auto* hdr = reinterpret_cast<const FeedIndexHeader*>(file_->data());
+    if (std::memcmp(hdr->magic, FEED_INDEX_MAGIC, sizeof(hdr->magic)) != 0
+        || hdr->version != FEED_INDEX_VERSION
+        || hdr->entries_offset > file_->size()
+        || hdr->num_entries > (file_->size() - hdr->entries_offset) / sizeof(FeedIndexEntry)) {
+        std::cerr << "Not a valid feed index: " << index_path << "\n";
+        return;
+    }
+    header_  = hdr;
+    entries_ = {reinterpret_cast<const FeedIndexEntry*>(file_->data() + hdr->entries_offset),
+                static_cast<std::size_t>(hdr->num_entries)};
+}
+
+FeedIndex::~FeedIndex() = default;
+
+const FeedIndexEntry* FeedIndex::checkpointBefore(uint64_t ts) const noexcept {
+    auto it = std::lower_bound(entries_.begin(), entries_.end(), ts,
+                               [](const FeedIndexEntry& e, uint64_t t) { return e.ts < t; });
+    while (it != entries_.begin()) {
+        --it;
+        if (it->checkpoint != 0) return &*it;
+    }
+    return nullptr;
+}
+
+const FeedIndexEntry* FeedIndex::checkpointAtRecord(uint64_t record) const noexcept {
+    auto it = std::upper_bound(entries_.begin(), entries_.end(), record,
+                               [](uint64_t r, const FeedIndexEntry& e) { return r < e.record; });
+    while (it != entries_.begin()) {
+        --it;
+        if (it->checkpoint != 0) return &*it;
+    }
+    return nullptr;
+}
+
+bool FeedIndex::restore(const FeedIndexEntry& e, OrderBook& book) const {
+    if (!ok() || e.checkpoint == 0) return false;
+    const FeedIndexHeader& h = *header_;
+    if (book.minPrice() != h.min_price || book.maxPrice() != h.max_price
+        || book.maxOrders() != h.max_orders
+        || static_cast<uint8_t>(book.idIndex()) != h.id_index) {
+        return false;
+    }
+    if (e.checkpoint + sizeof(uint64_t) > file_->size()) return false;
+    uint64_t n = 0;
+    std::memcpy(&n, file_->data() + e.checkpoint, sizeof(n));
+    if (n > (file_->size() - e.checkpoint - sizeof(n)) / sizeof(BookOrder)) return false;
+    book.restoreOrders(reinterpret_cast<const BookOrder*>(file_->data() + e.checkpoint + sizeof(n)),
+                       static_cast<size_t>(n));
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Seeking and windowed replay
+// ---------------------------------------------------------------------------
+bool seek_feed(const char* feed, const FeedIndex* index, uint64_t start_ts,
+               OrderBook& book, FeedPosition& pos) {
+    return seek_to(feed, index, book, pos,
+                   [start_ts](const FeedIndex& idx) { return idx.checkpointBefore(start_ts); },
+                   [start_ts](const MarketUpdate& u, const FeedPosition&) { return u.ts >= start_ts; });
+}
+
+bool seek_feed_record(const char* feed, const FeedIndex* index, uint64_t record,
+                      OrderBook& book, FeedPosition& pos) {
+    return seek_to(feed, index, book, pos,
+                   [record](const FeedIndex& idx) { return idx.checkpointAtRecord(record); },
+                   [record](const MarketUpdate&, const FeedPosition& p) { return p.record >= record; });
+}
+
+std::uint64_t replay_feed_records(const char* feed, const FeedPosition& from, uint64_t count,
+                                  const std::function<bool(std::span<const MarketUpdate>)>& sink,
+                                  FeedPosition* next, const MmapReplayOptions& opts) {
+    if (next) *next = from;
+    if (count == 0) return 0;
+    MappedFile file(feed, opts);
+    if (!file.ok() || file.size() == 0) return 0;
+    FeedCursor cursor(file.data(), file.data() + file.size());
+    if (!cursor.ok() || !cursor.seek(from)) return 0;
+    ReadAhead ra(file, opts.readahead_bytes);
+
+    std::uint64_t done = 0;
+    for (auto run = cursor.next(); !run.empty(); run = cursor.next()) {
+        const auto n = static_cast<std::size_t>(std::min<std::uint64_t>(run.size(), count - done));
+        const bool more = sink(run.first(n));
+        done += n;
+        if (done == count || !more) {
+            if (next) *next = n < run.size() ? cursor.positionOf(n) : cursor.resumePosition();
+            return done;
+        }
+        ra.advance(static_cast<std::size_t>(cursor.offset()));
+    }
+    if (next) *next = cursor.endPosition();
+    return done;
+}
+
+std::uint64_t run_mmap_replay_range(FeedHandler& fh, const char* feed, const FeedPosition& from,
+                                    uint64_t end_ts, const MmapReplayOptions& opts) {
+    MappedFile file(feed, opts);
+    if (!file.ok() || file.size() == 0) return 0;
+    FeedCursor cursor(file.data(), file.data() + file.size());
+    if (!cursor.ok() || !cursor.seek(from)) return 0;
+    ReadAhead ra(file, opts.readahead_bytes);
+
+    std::uint64_t count = 0;
+    for (auto run = cursor.next(); !run.empty(); run = cursor.next()) {
+        const auto stop = std::find_if(run.begin(), run.end(),
+                                       [end_ts](const MarketUpdate& u) { return u.ts >= end_ts; });
+        const auto n = static_cast<std::size_t>(stop - run.begin());
+        fh.onBatch(run.first(n));
+        count += n;
+        if (stop != run.end()) break;
+        ra.advance(static_cast<std::size_t>(cursor.offset()));
+    }
+    return count;
+}
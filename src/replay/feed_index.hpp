@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <span>
+
+#include "mmap_replay.hpp"
+#include "../core/order_book.hpp"
+
+class FeedHandler;
+class MappedFile;
+
+// ---------------------------------------------------------------------------
+// Feed index sidecar (<feed>.idx)
+//
+// Maps coarse timestamps to positions in a raw or compact feed file, plus
+// an occasional OrderBook checkpoint: the resting orders just before that
+// position. Replaying a time window then costs one checkpoint restore and
+// a bounded catch-up, not a replay from byte 0. A checkpoint is due every
+// `checkpoint_every` entries, but waits until the feed has moved on by
+// `checkpoint_min_bytes` and by the size of the previous checkpoint, so
+// checkpoints never take more space than the feed they cover.
+//
+// Layout (little-endian):
+//   FeedIndexHeader
+//   { uint64 num_orders, BookOrder[num_orders] } *   checkpoints
+//   FeedIndexEntry[num_entries]                      at entries_offset
+//
+// Checkpoints are only valid for a book built like `book` in the header.
+// The defaults match run_backtest and generate_feed.
+// ---------------------------------------------------------------------------
+
+inline constexpr char     FEED_INDEX_MAGIC[8] = {'M', 'D', 'I', 'N', 'D', 'E', 'X', '1'};
+inline constexpr uint32_t FEED_INDEX_VERSION  = 1;
+
+struct IndexBookConfig {
+    int64_t      min_price  = 9900;
+    int64_t      max_price  = 10100;
+    uint64_t     max_orders = 2'000'000;
+    OrderIdIndex id_index   = OrderIdIndex::Dense;
+};
+
+struct FeedIndexHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t checkpoint_every;   // minimum entries between checkpoints
+    uint64_t interval_ns;        // one entry per ts interval that has records
+    uint64_t num_entries;
+    uint64_t entries_offset;
+    uint64_t num_records;
+    uint64_t feed_bytes;         // size of the indexed feed file
+    uint64_t first_ts;
+    uint64_t last_ts;
+    int64_t  min_price;          // IndexBookConfig the checkpoints were taken with
+    int64_t  max_price;
+    uint64_t max_orders;
+    uint8_t  id_index;
+    uint8_t  _pad[7];
+};
+static_assert(sizeof(FeedIndexHeader) == 104);
+
+// Where a record lives: raw feeds use byte offset alone (skip = 0); compact
+// feeds use the offset of its block and its index inside the block.
+struct FeedPosition {
+    uint64_t offset = 0;   // 0: start of the feed
+    uint32_t skip   = 0;
+    uint64_t record = 0;   // records before this one
+};
+
+struct FeedIndexEntry {
+    uint64_t ts;           // ts of the first record at or after the interval start
+    uint64_t record;
+    uint64_t offset;
+    uint32_t skip;
+    uint32_t _pad;
+    uint64_t checkpoint;   // offset of a checkpoint in the index file, 0 if none
+};
+static_assert(sizeof(FeedIndexEntry) == 40);
+
+struct FeedIndexOptions {
+    uint64_t        interval_ns      = 100'000'000;   // 100 ms
+    uint32_t        checkpoint_every = 600;           // one per minute at 100 ms
+    uint64_t        checkpoint_min_bytes = 0;         // of feed between checkpoints
+    IndexBookConfig book;
+};
+
+// Scans `feed` once and writes its index to `index_path`. Returns false if
+// either file cannot be opened.
+bool build_feed_index(const char* feed, const char* index_path,
+                      const FeedIndexOptions& opts = {});
+
+// ---------------------------------------------------------------------------
+// FeedIndex — read-only view of an index file.
+// ---------------------------------------------------------------------------
+class FeedIndex {
+public:
+    explicit FeedIndex(const char* index_path);
+    ~FeedIndex();
+
+    FeedIndex(const FeedIndex&)            = delete;
+    FeedIndex& operator=(const FeedIndex&) = delete;
+
+    bool ok() const noexcept { return header_ != nullptr; }
+    const FeedIndexHeader&          header()  const noexcept { return *header_; }
+    std::span<const FeedIndexEntry> entries() const noexcept { return entries_; }
+
+    // Latest entry with a checkpoint whose ts is strictly before `ts`, or
+    // nullptr if there is none (replay from the start of the feed).
+    const FeedIndexEntry* checkpointBefore(uint64_t ts) const noexcept;
+
+    // Latest entry with a checkpoint at or before record number `record`.
+    const FeedIndexEntry* checkpointAtRecord(uint64_t record) const noexcept;
+
+    // Restores the entry's checkpoint into an empty `book`. Returns false if
+    // the entry has no checkpoint or the book is not configured like the
+    // index's IndexBookConfig.
+    bool restore(const FeedIndexEntry& e, OrderBook& book) const;
+
+private:
+    std::unique_ptr<MappedFile>     file_;
+    const FeedIndexHeader*          header_ = nullptr;
+    std::span<const FeedIndexEntry> entries_;
+};
+
+// Brings an empty `book` to its state just before the first record with
+// ts >= start_ts, and returns that record's position in `pos`. The book is
+// restored from the index's latest earlier checkpoint and then caught up
+// from the feed. With no index (nullptr) or no usable checkpoint, it
+// catches up from the start of the feed. Returns false if the feed cannot
+// be read.
+bool seek_feed(const char* feed, const FeedIndex* index, uint64_t start_ts,
+               OrderBook& book, FeedPosition& pos);
+
+// Like seek_feed, but stops just before record number `record` (0-based)
+// instead of a timestamp, so it also works on feeds whose timestamps are not
+// monotonic. `pos` is the feed end if the feed has fewer records.
+bool seek_feed_record(const char* feed, const FeedIndex* index, uint64_t record,
+                      OrderBook& book, FeedPosition& pos);
+
+// Hands up to `count` records from `from` to `sink` in runs of at most
+// 1024, in feed order, until `sink` returns false. Runs point into the
+// mapping or a decode buffer and are only valid during the call. If `next`
+// is set it receives the position of the first record not handed out.
+// Returns the number handed out.
+std::uint64_t replay_feed_records(const char* feed, const FeedPosition& from, uint64_t count,
+                                  const std::function<bool(std::span<const MarketUpdate>)>& sink,
+                                  FeedPosition* next = nullptr,
+                                  const MmapReplayOptions& opts = {});
+
+// Replays records from `from` up to, but not including, the first record
+// with ts >= end_ts. Returns the number of messages published.
+std::uint64_t run_mmap_replay_range(FeedHandler& fh, const char* feed,
+                                    const FeedPosition& from,
+                                    uint64_t end_ts = std::numeric_limits<uint64_t>::max(),
+                                    const MmapReplayOptions& opts = {});
@@ -0,0 +1,102 @@
+#include "mapped_file.hpp"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <iostream>
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const char* filename, const MmapReplayOptions&) {
+    file_ = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_ == INVALID_HANDLE_VALUE) {
+        std::cerr << "Failed to open file: " << filename << "\n";
+        return;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file_, &fileSize)) {
+        std::cerr << "GetFileSizeEx failed\n";
+        return;
+    }
+    opened_ = true;
+    size_   = static_cast<std::size_t>(fileSize.QuadPart);
+    if (size_ == 0) return;   // CreateFileMapping rejects empty files
+
+    map_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!map_) {
+        std::cerr << "CreateFileMapping failed\n";
+        return;
+    }
+
+    data_ = static_cast<const uint8_t*>(MapViewOfFile(map_, FILE_MAP_READ, 0, 0, 0));
+    if (!data_) std::cerr << "MapViewOfFile failed\n";
+}
+
+MappedFile::~MappedFile() {
+    if (data_) UnmapViewOfFile(data_);
+    if (map_)  CloseHandle(map_);
+    if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+}
+
+void MappedFile::willNeed(std::size_t, std::size_t) const noexcept {}
+
+#else  // POSIX
+
+MappedFile::MappedFile(const char* filename, const MmapReplayOptions& opts) {
+    fd_ = ::open(filename, O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0) {
+        std::cerr << "Failed to open file: " << filename << "\n";
+        return;
+    }
+
+    struct stat st;
+    if (::fstat(fd_, &st) != 0) {
+        std::cerr << "fstat failed\n";
+        return;
+    }
+    opened_ = true;
+    size_   = static_cast<std::size_t>(st.st_size);
+    if (size_ == 0) return;   // mmap rejects zero-length mappings
+
+    int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+    if (opts.populate) flags |= MAP_POPULATE;
+#endif
+    void* p = ::mmap(nullptr, size_, PROT_READ, flags, fd_, 0);
+    if (p == MAP_FAILED) {
+        std::cerr << "mmap failed\n";
+        return;
+    }
+    data_ = static_cast<const uint8_t*>(p);
+
+    // Advice is best effort: a kernel without THP for page-cache files
+    // rejects MADV_HUGEPAGE, which only costs us the TLB savings.
+    if (opts.sequential) {
+        ::madvise(p, size_, MADV_SEQUENTIAL);
+        ::posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+#ifdef MADV_HUGEPAGE
+    if (opts.huge_pages) ::madvise(p, size_, MADV_HUGEPAGE);
+#endif
+}
+
+MappedFile::~MappedFile() {
+    if (data_) ::munmap(const_cast<uint8_t*>(data_), size_);
+    if (fd_ >= 0) ::close(fd_);
+}
+
+void MappedFile::willNeed(std::size_t offset, std::size_t len) const noexcept {
+    if (!data_ || offset >= size_) return;
+    static const std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    const std::size_t begin = offset & ~(page - 1);
+    const std::size_t end   = std::min(size_, offset + len);
+    ::madvise(const_cast<uint8_t*>(data_) + begin, end - begin, MADV_WILLNEED);
+}
+
+#endif
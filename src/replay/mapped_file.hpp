@@ -0,0 +1,63 @@
+#pragma once
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "mmap_replay.hpp"
+
+// ---------------------------------------------------------------------------
+// MappedFile — read-only view of a whole file. Shared by the single-file and
+// merging mmap replay sources; not part of the public replay API.
+// ---------------------------------------------------------------------------
+class MappedFile {
+public:
+    MappedFile(const char* filename, const MmapReplayOptions& opts);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&)            = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool           ok()    const noexcept { return data_ != nullptr || (opened_ && size_ == 0); }
+    const uint8_t* data()  const noexcept { return data_; }
+    std::size_t    size()  const noexcept { return size_; }
+
+    // Hint that [offset, offset + len) will be read soon.
+    void willNeed(std::size_t offset, std::size_t len) const noexcept;
+
+private:
+    const uint8_t* data_   = nullptr;
+    std::size_t    size_   = 0;
+    bool           opened_ = false;
+#ifdef _WIN32
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE map_  = nullptr;
+#else
+    int    fd_   = -1;
+#endif
+};
+
+// Re-issues WILLNEED for the next `readahead_bytes` every time the parser
+// has consumed half of the previous window.
+class ReadAhead {
+public:
+    ReadAhead(const MappedFile& file, std::size_t window)
+        : file_(file), window_(window), step_(std::max<std::size_t>(window / 2, 1)) {}
+
+    void advance(std::size_t offset) noexcept {
+        if (window_ != 0 && offset >= next_) {
+            file_.willNeed(offset, window_);
+            next_ = offset + step_;
+        }
+    }
+
+private:
+    const MappedFile& file_;
+    std::size_t       window_;
+    std::size_t       step_;
+    std::size_t       next_ = 0;
+};
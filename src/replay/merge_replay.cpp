@@ -0,0 +1,250 @@
+#include "merge_replay.hpp"
+
+#include <bit>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "mapped_file.hpp"
+#include "../feed/binary_parser.hpp"
+#include "../feed/compact_codec.hpp"
+#include "../feed/feed_handler.hpp"
+
+namespace {
+
+constexpr std::size_t CHUNK_RECORDS = 1024;   // raw records windowed per refill
+constexpr std::size_t BATCH_RECORDS = 1024;   // merged records per FeedHandler::onBatch
+
+// Records of one input that are ready to merge: [cur, lim).
+struct Head {
+    const MarketUpdate* cur = nullptr;
+    const MarketUpdate* lim = nullptr;
+};
+
+// ---------------------------------------------------------------------------
+// MergeInput — one mapped feed file. Raw files are windowed in place over
+// the mapping; compact files are decoded a block at a time.
+// ---------------------------------------------------------------------------
+class MergeInput {
+public:
+    MergeInput(const char* filename, const MmapReplayOptions& opts)
+        : file_(filename, opts), ra_(file_, opts.readahead_bytes) {}
+
+    bool open() {
+        if (!file_.ok()) return false;
+        base_ = file_.data();
+        ptr_  = base_;
+        end_  = base_ + file_.size();
+        if (file_.size() != 0 && is_compact_feed(ptr_, end_)) {
+            CompactFileHeader hdr;
+            std::memcpy(&hdr, ptr_, sizeof(hdr));
+            if (hdr.version != COMPACT_VERSION) {
+                std::cerr << "Unsupported compact feed version " << hdr.version << "\n";
+                return false;
+            }
+            compact_ = true;
+            block_.resize(hdr.block_records);
+            ptr_ += sizeof(hdr);
+        }
+        return true;
+    }
+
+    // Points `h` at the next records; false once the file is exhausted.
+    bool refill(Head& h) {
+        if (ptr_ >= end_) return false;
+        ra_.advance(static_cast<std::size_t>(ptr_ - base_));
+        if (compact_) {
+            std::size_t consumed = 0;
+            const std::size_t n = decoder_.decode(ptr_, end_, block_.data(), block_.size(), consumed);
+            if (n == 0) return false;   // malformed or truncated
+            ptr_ += consumed;
+            h = {block_.data(), block_.data() + n};
+        } else {
+            const auto span = parser_.parseBatch(ptr_, end_, CHUNK_RECORDS);
+            if (span.empty()) return false;   // truncated tail
+            ptr_ += span.size_bytes();
+            h = {span.data(), span.data() + span.size()};
+        }
+        return true;
+    }
+
+private:
+    MappedFile                file_;
+    ReadAhead                 ra_;
+    const uint8_t*            base_    = nullptr;
+    const uint8_t*            ptr_     = nullptr;
+    const uint8_t*            end_     = nullptr;
+    bool                      compact_ = false;
+    BinaryParser              parser_;
+    CompactBlockDecoder       decoder_;
+    std::vector<MarketUpdate> block_;
+};
+
+// ---------------------------------------------------------------------------
+// LoserTree — tournament over N keys. Each internal node keeps the loser of
+// the match played there; the overall winner is kept separately. Changing
+// the winner's key replays only its leaf-to-root path: log2(N) compares.
+//
+// Nodes hold the loser's key next to its rank, so a replay walks one small
+// array. The match result is selected without branches: interleaved inputs
+// make it a coin flip, and a mispredict at every level is most of the cost.
+// Ties go to the lower input index; retired inputs lose to everything.
+// ---------------------------------------------------------------------------
+class LoserTree {
+public:
+    explicit LoserTree(std::size_t n)
+        : leaves_(std::bit_ceil(n == 0 ? std::size_t{1} : n)),
+          tree_(leaves_),
+          live_(n) {
+        leaf_.resize(leaves_);
+        for (std::size_t i = 0; i < leaves_; ++i) {
+            leaf_[i] = {std::numeric_limits<std::uint64_t>::max(),
+                        static_cast<std::uint64_t>(i < n ? i : i + leaves_)};   // padding: retired
+        }
+    }
+
+    void setKey(std::size_t i, std::uint64_t key) noexcept { leaf_[i].key = key; }
+
+    // Plays every match once; call after the initial setKey/retireLeaf calls.
+    void build() {
+        std::vector<Entry> win(2 * leaves_);
+        for (std::size_t i = 0; i < leaves_; ++i) win[leaves_ + i] = leaf_[i];
+        for (std::size_t node = leaves_ - 1; node >= 1; --node) {
+            const Entry a = win[2 * node];
+            const Entry b = win[2 * node + 1];
+            const bool a_wins = beats(a, b);
+            win[node]   = a_wins ? a : b;
+            tree_[node] = a_wins ? b : a;
+        }
+        winner_ = win[1];
+    }
+
+    std::size_t winner() const noexcept { return static_cast<std::size_t>(winner_.rank & (leaves_ - 1)); }
+    std::size_t live()   const noexcept { return live_; }
+
+    // Best of the losers on the winner's path, i.e. the runner-up. While the
+    // winner's next key beats it the winner stays on top, so a run of
+    // records can be taken from one input before the tree is replayed.
+    void findRunnerUp() noexcept {
+        Entry best{std::numeric_limits<std::uint64_t>::max(), ~std::uint64_t{0}};
+        for (std::size_t node = (winner() + leaves_) >> 1; node != 0; node >>= 1) {
+            const Entry c = tree_[node];
+            const std::uint64_t m = std::uint64_t{0} - static_cast<std::uint64_t>(beats(c, best));
+            best = {best.key ^ ((c.key ^ best.key) & m), best.rank ^ ((c.rank ^ best.rank) & m)};
+        }
+        runner_up_ = best;
+    }
+
+    bool stillWins(std::uint64_t key) const noexcept {
+        return beats({key, winner_.rank}, runner_up_);
+    }
+
+    // The winner's key moved on (its input advanced).
+    void update(std::uint64_t key) noexcept {
+        winner_.key = key;
+        replay();
+    }
+
+    // The winner's input is exhausted.
+    void retire() noexcept {
+        winner_ = {std::numeric_limits<std::uint64_t>::max(), winner_.rank | leaves_};
+        --live_;
+        replay();
+    }
+
+    // Before build(): input `i` is empty from the start.
+    void retireLeaf(std::size_t i) noexcept {
+        leaf_[i] = {std::numeric_limits<std::uint64_t>::max(), i + leaves_};
+        --live_;
+    }
+
+private:
+    struct Entry {
+        std::uint64_t key;
+        std::uint64_t rank;   // input index, +leaves_ once retired
+    };
+
+    static bool beats(const Entry& a, const Entry& b) noexcept {
+        // Bitwise, not short-circuit: keeps the compare free of branches.
+        return (a.key < b.key) | ((a.key == b.key) & (a.rank < b.rank));
+    }
+
+    void replay() noexcept {
+        Entry w = winner_;
+        for (std::size_t node = (winner() + leaves_) >> 1; node != 0; node >>= 1) {
+            const Entry c = tree_[node];
+            // All-ones if the stored loser wins this time; the swap is done
+            // with masks because compilers turn a struct ?: into a branch.
+            const std::uint64_t m  = std::uint64_t{0} - static_cast<std::uint64_t>(beats(c, w));
+            const std::uint64_t dk = (c.key ^ w.key) & m;
+            const std::uint64_t dr = (c.rank ^ w.rank) & m;
+            tree_[node] = {c.key ^ dk, c.rank ^ dr};
+            w           = {w.key ^ dk, w.rank ^ dr};
+        }
+        winner_ = w;
+    }
+
+    std::size_t        leaves_;
+    std::vector<Entry> tree_;   // [1, leaves_): loser at each internal node
+    std::vector<Entry> leaf_;   // initial keys, used by build()
+    Entry              winner_{};
+    Entry              runner_up_{};
+    std::size_t        live_;
+};
+
+} // namespace
+
+std::uint64_t run_merge_replay(FeedHandler& fh, std::span<const char* const> files,
+                               const MmapReplayOptions& opts) {
+    if (files.empty()) return 0;
+    if (files.size() == 1) return run_mmap_replay(fh, files[0], opts);
+
+    const std::size_t n = files.size();
+    std::vector<std::unique_ptr<MergeInput>> inputs;
+    inputs.reserve(n);
+    for (const char* f : files) {
+        inputs.push_back(std::make_unique<MergeInput>(f, opts));
+        if (!inputs.back()->open()) return 0;
+    }
+
+    std::vector<Head> heads(n);
+    LoserTree tree(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        if (inputs[i]->refill(heads[i])) tree.setKey(i, heads[i].cur->ts);
+        else                             tree.retireLeaf(i);
+    }
+    tree.build();
+
+    // Merged records are not contiguous in any one mapping, so they are
+    // gathered into a batch and published with one onBatch per batch.
+    std::vector<MarketUpdate> batch(BATCH_RECORDS);
+    std::size_t   pending = 0;
+    std::uint64_t count   = 0;
+
+    while (tree.live() != 0) {
+        const std::size_t w = tree.winner();
+        Head& h = heads[w];
+        tree.findRunnerUp();
+        bool more = true;
+        do {
+            batch[pending++] = *h.cur;
+            if (pending == batch.size()) {
+                fh.onBatch(batch);
+                count  += pending;
+                pending = 0;
+            }
+            if (++h.cur == h.lim && !inputs[w]->refill(h)) {
+                more = false;
+                break;
+            }
+        } while (tree.stillWins(h.cur->ts));
+
+        if (more) tree.update(h.cur->ts);
+        else      tree.retire();
+    }
+    fh.onBatch({batch.data(), pending});
+    return count + pending;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+#include "mmap_replay.hpp"
+
+class FeedHandler;
+
+// Replays several feed files (raw or compact, in any mix) as one stream
+// ordered by MarketUpdate::ts, e.g. one capture file per venue/channel.
+// Each file must itself be in ts order. A loser tree picks the next record
+// in O(log N) per message. Equal timestamps come out in argument order
+// (files[0] first), so the merged stream is the same on every run.
+//
+// Every file is mapped with `opts`. Returns the number of messages
+// published, or 0 without publishing anything if any file cannot be
+// opened. A single file is replayed by run_mmap_replay.
+std::uint64_t run_merge_replay(FeedHandler& fh, std::span<const char* const> files,
+                               const MmapReplayOptions& opts = {});
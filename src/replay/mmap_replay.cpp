@@ -1,83 +1,119 @@
-#include <windows.h>
+#include "mmap_replay.hpp"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 #include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <vector>
 
+#include "mapped_file.hpp"
 #include "../feed/feed_handler.hpp"
 #include "../feed/binary_parser.hpp"
+#include "../feed/compact_codec.hpp"
 
-std::uint64_t run_mmap_replay(FeedHandler& fh, const char* filename) {
-    HANDLE hFile = CreateFileA(
-        filename,
-        GENERIC_READ,
-        FILE_SHARE_READ,
-        nullptr,
-        OPEN_EXISTING,
-        FILE_ATTRIBUTE_NORMAL,
-        nullptr
-    );
-
-    if (hFile == INVALID_HANDLE_VALUE) {
-        std::cerr << "Failed to open file: " << filename << "\n";
-        return 0;
-    }
+namespace {
 
-    LARGE_INTEGER fileSize;
-    if (!GetFileSizeEx(hFile, &fileSize)) {
-        std::cerr << "GetFileSizeEx failed\n";
-        CloseHandle(hFile);
-        return 0;
-    }
+// Records handed to FeedHandler::onBatch at a time: large enough to
+// amortise the ring's head update, small enough to keep read-ahead moving.
+constexpr std::size_t BATCH_RECORDS = 1024;
 
-    HANDLE hMap = CreateFileMappingA(
-        hFile,
-        nullptr,
-        PAGE_READONLY,
-        0,
-        0,
-        nullptr
-    );
-
-    if (!hMap) {
-        std::cerr << "CreateFileMapping failed\n";
-        CloseHandle(hFile);
-        return 0;
-    }
+std::uint64_t replay_raw(FeedHandler& fh, const uint8_t* begin, const uint8_t* end,
+                         ReadAhead& ra) {
+    const uint8_t* ptr = begin;
+    BinaryParser parser;
+    std::uint64_t count = 0;
 
-    const uint8_t* ptr = static_cast<const uint8_t*>(
-        MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0)
-    );
+    while (ptr < end) {
+        ra.advance(static_cast<std::size_t>(ptr - begin));
 
-    if (!ptr) {
-        std::cerr << "MapViewOfFile failed\n";
-        CloseHandle(hMap);
-        CloseHandle(hFile);
+        // The mapping is page-aligned, so records are viewed in place.
+        const auto batch = parser.parseBatch(ptr, end, BATCH_RECORDS);
+        if (batch.empty()) {
+            break; // truncated tail
+        }
+        fh.onBatch(batch);
+        ptr   += batch.size_bytes();
+        count += batch.size();
+    }
+    return count;
+}
+
+std::uint64_t replay_compact(FeedHandler& fh, const uint8_t* begin, const uint8_t* end,
+                             ReadAhead& ra, bool in_place) {
+    CompactFileHeader fh_hdr;
+    std::memcpy(&fh_hdr, begin, sizeof(fh_hdr));
+    if (fh_hdr.version != COMPACT_VERSION) {
+        std::cerr << "Unsupported compact feed version " << fh_hdr.version << "\n";
         return 0;
     }
 
-    const uint8_t* end = ptr + fileSize.QuadPart;
-
-    BinaryParser parser;
+    std::vector<MarketUpdate> batch(fh_hdr.block_records);
+    CompactBlockDecoder decoder;
+    const uint8_t* ptr = begin + sizeof(CompactFileHeader);
     std::uint64_t count = 0;
 
     while (ptr < end) {
-        MarketUpdate u{};
-        std::size_t consumed = parser.parse(ptr, end, u);
-        if (consumed == 0) {
+        ra.advance(static_cast<std::size_t>(ptr - begin));
+
+        std::size_t consumed = 0;
+        // Decode straight into the ring when a whole block fits before it
+        // wraps; otherwise decode into `batch` and copy it in.
+        const std::span<MarketUpdate> slots =
+            in_place ? fh.claim(batch.size()) : std::span<MarketUpdate>{};
+        if (!slots.empty()) {
+            const std::size_t n = decoder.decode(ptr, end, slots.data(), slots.size(), consumed);
+            fh.commit(n);
+            if (n == 0) {
+                break; // malformed or truncated
+            }
+            ptr   += consumed;
+            count += n;
+            continue;
+        }
+        const std::size_t n = decoder.decode(ptr, end, batch.data(), batch.size(), consumed);
+        if (n == 0) {
             break; // malformed or truncated
         }
         ptr += consumed;
 
-
-        while (!fh.onUpdate(u)) {
-            std::cout << "FULL\n";
-        }
-
-        ++count;
+        fh.onBatch({batch.data(), n});
+        count += n;
     }
+    return count;
+}
 
-    UnmapViewOfFile(ptr);
-    CloseHandle(hMap);
-    CloseHandle(hFile);
+} // namespace
 
-    return count;
-}
\ No newline at end of file
+std::uint64_t run_mmap_replay(FeedHandler& fh, const char* filename) {
+    return run_mmap_replay(fh, filename, MmapReplayOptions{});
+}
+
+std::uint64_t run_mmap_replay(FeedHandler& fh, const char* filename,
+                              const MmapReplayOptions& opts) {
+    MappedFile file(filename, opts);
+    if (!file.ok() || file.size() == 0) return 0;
+
+    const uint8_t* const begin = file.data();
+    const uint8_t* const end   = begin + file.size();
+    ReadAhead ra(file, opts.readahead_bytes);
+
+    return is_compact_feed(begin, end) ? replay_compact(fh, begin, end, ra, opts.decode_in_place)
+                                       : replay_raw(fh, begin, end, ra);
+}
+
+bool evict_page_cache(const char* filename) {
+#if defined(_WIN32)
+    (void)filename;
+    return false;
+#else
+    const int fd = ::open(filename, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    const bool ok = ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+    ::close(fd);
+    return ok;
+#endif
+}
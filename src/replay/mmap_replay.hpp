@@ -1,7 +1,25 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
 class FeedHandler;
 
+// How the replay file is mapped. The POSIX backend honours all of these;
+// on Windows they are ignored and the view is mapped read-only as before.
+struct MmapReplayOptions {
+    bool        populate        = false;  // MAP_POPULATE: fault the whole file in at mmap time
+    bool        sequential      = true;   // madvise(MADV_SEQUENTIAL): aggressive read-ahead, early reclaim
+    bool        huge_pages      = false;  // madvise(MADV_HUGEPAGE) on the mapping (best effort)
+    std::size_t readahead_bytes = 0;      // >0: keep MADV_WILLNEED issued this far ahead of the parser
+    bool        decode_in_place = true;   // compact feeds: decode into ring slots (FeedHandler::claim)
+};
+
 std::uint64_t run_mmap_replay(FeedHandler& fh, const char* filename);
+std::uint64_t run_mmap_replay(FeedHandler& fh, const char* filename,
+                              const MmapReplayOptions& opts);
+
+// Drops the file's pages from the OS page cache so the next replay reads from
+// disk (posix_fadvise(POSIX_FADV_DONTNEED)). Returns false if unsupported or
+// the file cannot be opened. Dirty or mapped pages may stay resident.
+bool evict_page_cache(const char* filename);
@@ -0,0 +1,477 @@
+#include "uring_replay.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <vector>
+
+#include "../feed/feed_handler.hpp"
+#include "../feed/binary_parser.hpp"
+#include "../feed/compact_codec.hpp"
+#include "mmap_replay.hpp"
+
+#ifdef __linux__
+
+#include <atomic>
+#include <cerrno>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+// O_DIRECT needs buffer, offset and length aligned to the logical block
+// size; 4 KiB covers every device we run on.
+constexpr std::size_t IO_ALIGN = 4096;
+
+// ---------------------------------------------------------------------------
+// IoUring — minimal submission/completion ring over the raw syscalls.
+// Single-threaded use only: this thread is the only SQ producer and the only
+// CQ consumer, so only the indices shared with the kernel need atomics.
+// ---------------------------------------------------------------------------
+class IoUring {
+public:
+    explicit IoUring(unsigned entries);
+    ~IoUring();
+
+    IoUring(const IoUring&)            = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    bool ok() const noexcept { return fd_ >= 0; }
+
+    // Queues an IORING_OP_READ. Returns false if the SQ is full.
+    bool prepRead(int fd, void* buf, unsigned len, std::uint64_t offset,
+                  std::uint64_t user_data) noexcept;
+
+    // Queues an IORING_OP_ASYNC_CANCEL for the request tagged `user_data`.
+    // Both complete; the cancel's own CQE carries CANCEL_TAG.
+    bool prepCancel(std::uint64_t user_data) noexcept;
+    static constexpr std::uint64_t CANCEL_TAG = ~std::uint64_t{0};
+
+    // Submits queued SQEs; with `wait`, blocks until one completion is posted.
+    // Returns false on a syscall error.
+    bool submit(bool wait) noexcept;
+
+    // Reaps, without submitting, until every submitted request has
+    // completed, so none can still write into its buffer. Returns false if
+    // the kernel cannot be waited on.
+    bool drain() noexcept;
+
+    // Calls on_cqe(user_data, res) for every posted completion.
+    template <typename F>
+    void reap(F&& on_cqe) noexcept {
+        unsigned head = *cq_head_;
+        const unsigned tail = std::atomic_ref<unsigned>(*cq_tail_).load(std::memory_order_acquire);
+        for (; head != tail; ++head) {
+            const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+            --inflight_;
+            on_cqe(cqe.user_data, cqe.res);
+        }
+        std::atomic_ref<unsigned>(*cq_head_).store(head, std::memory_order_release);
+    }
+
+private:
+    void close() noexcept;
+    io_uring_sqe* nextSqe() noexcept;   // zeroed SQE at the tail, null if the SQ is full
+    void          pushSqe() noexcept;   // publishes it
+    bool enter(unsigned to_submit, bool wait) noexcept;
+
+    int           fd_       = -1;
+    unsigned      pending_  = 0;    // prepared but not yet submitted
+    unsigned      inflight_ = 0;    // submitted, completion not yet reaped
+
+    void*         sq_ring_  = nullptr;
+    void*         cq_ring_  = nullptr;
+    std::size_t   sq_bytes_ = 0;
+    std::size_t   cq_bytes_ = 0;
+    io_uring_sqe* sqes_     = nullptr;
+    std::size_t   sqe_bytes_ = 0;
+
+    unsigned*     sq_head_  = nullptr;
+    unsigned*     sq_tail_  = nullptr;
+    unsigned*     sq_array_ = nullptr;
+    unsigned      sq_mask_  = 0;
+    unsigned      sq_entries_ = 0;
+
+    unsigned*     cq_head_  = nullptr;
+    unsigned*     cq_tail_  = nullptr;
+    io_uring_cqe* cqes_     = nullptr;
+    unsigned      cq_mask_  = 0;
+};
+
+IoUring::IoUring(unsigned entries) {
+    io_uring_params p{};
+    fd_ = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &p));
+    if (fd_ < 0) return;
+
+    sq_bytes_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cq_bytes_ = p.cq_off.cqes  + p.cq_entries * sizeof(io_uring_cqe);
+    const bool single_mmap = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) sq_bytes_ = cq_bytes_ = std::max(sq_bytes_, cq_bytes_);
+
+    sq_ring_ = ::mmap(nullptr, sq_bytes_, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+    if (sq_ring_ == MAP_FAILED) { sq_ring_ = nullptr; close(); return; }
+
+    if (single_mmap) {
+        cq_ring_ = sq_ring_;
+    } else {
+        cq_ring_ = ::mmap(nullptr, cq_bytes_, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_CQ_RING);
+        if (cq_ring_ == MAP_FAILED) { cq_ring_ = nullptr; close(); return; }
+    }
+
+    sqe_bytes_ = p.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = ::mmap(nullptr, sqe_bytes_, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) { close(); return; }
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    auto* sq = static_cast<std::uint8_t*>(sq_ring_);
+    sq_head_    = reinterpret_cast<unsigned*>(sq + p.sq_off.head);
+    sq_tail_    = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+    sq_array_   = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+    sq_mask_    = *reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+    sq_entries_ = p.sq_entries;
+
+    auto* cq = static_cast<std::uint8_t*>(cq_ring_);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+    cqes_    = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+    cq_mask_ = *reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+}
+
+IoUring::~IoUring() { close(); }
+
+void IoUring::close() noexcept {
+    if (sqes_)    ::munmap(sqes_, sqe_bytes_);
+    if (cq_ring_ && cq_ring_ != sq_ring_) ::munmap(cq_ring_, cq_bytes_);
+    if (sq_ring_) ::munmap(sq_ring_, sq_bytes_);
+    if (fd_ >= 0) ::close(fd_);
+    sqes_    = nullptr;
+    cq_ring_ = sq_ring_ = nullptr;
+    fd_      = -1;
+}
+
+io_uring_sqe* IoUring::nextSqe() noexcept {
+    const unsigned tail = *sq_tail_;
+    const unsigned head = std::atomic_ref<unsigned>(*sq_head_).load(std::memory_order_acquire);
+    if (tail - head >= sq_entries_) return nullptr;
+
+    const unsigned idx = tail & sq_mask_;
+    io_uring_sqe* sqe = &sqes_[idx];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sq_array_[idx] = idx;
+    return sqe;
+}
+
+void IoUring::pushSqe() noexcept {
+    std::atomic_ref<unsigned>(*sq_tail_).store(*sq_tail_ + 1, std::memory_order_release);
+    ++pending_;
+}
+
+bool IoUring::prepRead(int fd, void* buf, unsigned len, std::uint64_t offset,
+                       std::uint64_t user_data) noexcept {
+    io_uring_sqe* sqe = nextSqe();
+    if (!sqe) return false;
+    sqe->opcode    = IORING_OP_READ;
+    sqe->fd        = fd;
+    sqe->addr      = reinterpret_cast<std::uint64_t>(buf);
+    sqe->len       = len;
+    sqe->off       = offset;
+    sqe->user_data = user_data;
+    pushSqe();
+    return true;
+}
+
+bool IoUring::prepCancel(std::uint64_t user_data) noexcept {
+    io_uring_sqe* sqe = nextSqe();
+    if (!sqe) return false;
+    sqe->opcode    = IORING_OP_ASYNC_CANCEL;
+    sqe->fd        = -1;
+    sqe->addr      = user_data;
+    sqe->user_data = CANCEL_TAG;
+    pushSqe();
+    return true;
+}
+
+bool IoUring::enter(unsigned to_submit, bool wait) noexcept {
+    for (;;) {
+        const long ret = ::syscall(__NR_io_uring_enter, fd_, to_submit, wait ? 1u : 0u,
+                                   wait ? IORING_ENTER_GETEVENTS : 0u, nullptr, 0);
+        if (ret >= 0) {
+            pending_  -= static_cast<unsigned>(ret);
+            inflight_ += static_cast<unsigned>(ret);
+            return true;
+        }
+        if (errno != EINTR && errno != EAGAIN) return false;
+    }
+}
+
+bool IoUring::submit(bool wait) noexcept {
+    if (pending_ == 0 && !wait) return true;
+    return enter(pending_, wait);
+}
+
+bool IoUring::drain() noexcept {
+    // SQEs still pending were never seen by the kernel and touch nothing.
+    for (;;) {
+        reap([](std::uint64_t, int) {});
+        if (inflight_ == 0) return true;
+        if (!enter(0, true)) return false;
+    }
+}
+
+constexpr std::size_t BATCH_RECORDS = 1024;   // records per FeedHandler::onBatch
+
+// ---------------------------------------------------------------------------
+// BlockParser — feeds consecutive file blocks to BinaryParser. A record that
+// straddles two blocks is reassembled in a small stash.
+// ---------------------------------------------------------------------------
+class BlockParser {
+public:
+    explicit BlockParser(FeedHandler& fh) : fh_(fh) {}
+
+    // Returns false once the stream is malformed (stop replaying).
+    bool consume(const std::uint8_t* p, std::size_t n) {
+        const std::uint8_t*       ptr = p;
+        const std::uint8_t* const end = p + n;
+
+        if (stash_len_ != 0) {
+            const std::size_t take = std::min(n, sizeof(stash_) - stash_len_);
+            std::memcpy(stash_ + stash_len_, p, take);
+            MarketUpdate u{};
+            const std::size_t c = parser_.parse(stash_, stash_ + stash_len_ + take, u);
+            if (c == 0) {
+                if (stash_len_ + take == sizeof(stash_)) return false;
+                stash_len_ += take;   // block smaller than a record
+                return true;
+            }
+            publish(u);
+            ptr += c - stash_len_;
+            stash_len_ = 0;
+        }
+
+        while (ptr < end) {
+            // Records are viewed in place inside the I/O buffer; parse()
+            // copies only if a block size ever leaves them misaligned.
+            const auto batch = parser_.parseBatch(ptr, end, BATCH_RECORDS);
+            if (!batch.empty()) {
+                fh_.onBatch(batch);
+                count_ += batch.size();
+                ptr    += batch.size_bytes();
+                continue;
+            }
+            MarketUpdate u{};
+            const std::size_t c = parser_.parse(ptr, end, u);
+            if (c == 0) break;
+            ptr += c;
+            publish(u);
+        }
+
+        const std::size_t rest = static_cast<std::size_t>(end - ptr);
+        if (rest > sizeof(stash_)) return false;
+        std::memcpy(stash_, ptr, rest);
+        stash_len_ = rest;
+        return true;
+    }
+
+    std::uint64_t count() const noexcept { return count_; }
+
+private:
+    void publish(const MarketUpdate& u) {
+        while (!fh_.onUpdate(u)) {
+            // queue full: spin until the consumer catches up
+        }
+        ++count_;
+    }
+
+    FeedHandler&  fh_;
+    BinaryParser  parser_;
+    std::uint8_t  stash_[2 * sizeof(MarketUpdate)];
+    std::size_t   stash_len_ = 0;
+    std::uint64_t count_     = 0;
+};
+
+struct AlignedBuffer {
+    explicit AlignedBuffer(std::size_t n)
+        : data(static_cast<std::uint8_t*>(::operator new(n, std::align_val_t(IO_ALIGN)))) {}
+    ~AlignedBuffer() { ::operator delete(data, std::align_val_t(IO_ALIGN)); }
+    AlignedBuffer(const AlignedBuffer&)            = delete;
+    AlignedBuffer& operator=(const AlignedBuffer&) = delete;
+    std::uint8_t* data;
+};
+
+// One ring slot: block `seq` of the file lives in buffer seq % queue_depth.
+struct Slot {
+    std::uint8_t* buf;
+    std::uint64_t offset;   // file offset of the block
+    std::size_t   want;     // bytes of file in this block
+    std::size_t   filled;   // bytes read so far
+    bool          ready;
+    bool          failed;
+};
+
+std::uint64_t replay_pread(int fd, std::uint64_t file_size, std::uint8_t* buf,
+                           std::size_t block, bool direct, BlockParser& bp) {
+    for (std::uint64_t off = 0; off < file_size; off += block) {
+        const std::size_t want = (std::size_t)std::min<std::uint64_t>(block, file_size - off);
+        std::size_t filled = 0;
+        while (filled < want) {
+            const std::size_t len = direct
+                ? (want - filled + IO_ALIGN - 1) & ~(IO_ALIGN - 1)
+                : want - filled;
+            const ssize_t r = ::pread(fd, buf + filled, len, (off_t)(off + filled));
+            if (r < 0 && errno == EINTR) continue;
+            if (r <= 0) {
+                std::cerr << "pread failed at offset " << off + filled << "\n";
+                return bp.count();
+            }
+            filled += (std::size_t)r;
+        }
+        if (!bp.consume(buf, want)) break;
+    }
+    return bp.count();
+}
+
+} // namespace
+
+std::uint64_t run_uring_replay(FeedHandler& fh, const char* filename,
+                               const UringReplayOptions& opts) {
+    const std::size_t block = std::max<std::size_t>(
+        (opts.block_bytes + IO_ALIGN - 1) & ~(IO_ALIGN - 1), IO_ALIGN);
+    const unsigned    qd    = std::max(opts.queue_depth, 1u);
+
+    bool direct = opts.direct;
+    int  fd     = ::open(filename, O_RDONLY | O_CLOEXEC | (direct ? O_DIRECT : 0));
+    if (fd < 0 && direct && errno == EINVAL) {
+        std::cerr << "O_DIRECT not supported for " << filename << ", using buffered reads\n";
+        direct = false;
+        fd = ::open(filename, O_RDONLY | O_CLOEXEC);
+    }
+    if (fd < 0) {
+        std::cerr << "Failed to open file: " << filename << "\n";
+        return 0;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        std::cerr << "fstat failed\n";
+        ::close(fd);
+        return 0;
+    }
+    const std::uint64_t file_size = static_cast<std::uint64_t>(st.st_size);
+
+    // The streaming loop parses fixed-size records; compact feeds are
+    // block-structured and go through the mmap path instead.
+    {
+        uint8_t head[sizeof(CompactFileHeader)];
+        std::ifstream probe(filename, std::ios::binary);
+        if (probe.read(reinterpret_cast<char*>(head), sizeof(head))
+            && is_compact_feed(head, head + sizeof(head))) {
+            ::close(fd);
+            std::cerr << "compact feed: using mmap replay\n";
+            return run_mmap_replay(fh, filename);
+        }
+    }
+
+    if (!direct) ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    AlignedBuffer buffers(block * qd);
+    BlockParser   bp(fh);
+
+    IoUring ring(qd);
+    if (!ring.ok()) {
+        std::cerr << "io_uring unavailable, falling back to pread\n";
+        const std::uint64_t n = replay_pread(fd, file_size, buffers.data, block, direct, bp);
+        ::close(fd);
+        return n;
+    }
+
+    std::vector<Slot> slots(qd);
+    const std::uint64_t num_blocks = (file_size + block - 1) / block;
+
+    auto queue_read = [&](std::size_t i) {
+        Slot& s = slots[i];
+        std::size_t len = s.want - s.filled;
+        if (direct) len = (len + IO_ALIGN - 1) & ~(IO_ALIGN - 1);
+        return ring.prepRead(fd, s.buf + s.filled, (unsigned)len, s.offset + s.filled, i);
+    };
+    auto issue = [&](std::uint64_t seq) {
+        const std::size_t i = (std::size_t)(seq % qd);
+        const std::uint64_t off = seq * block;
+        slots[i] = Slot{buffers.data + i * block, off,
+                        (std::size_t)std::min<std::uint64_t>(block, file_size - off),
+                        0, false, false};
+        queue_read(i);
+    };
+    auto on_cqe = [&](std::uint64_t i, int res) {
+        Slot& s = slots[i];
+        if (res <= 0) {             // error, or EOF before the expected size
+            s.failed = true;
+            s.ready  = true;
+            return;
+        }
+        s.filled += (std::size_t)res;
+        if (s.filled >= s.want) s.ready = true;
+        else                    queue_read((std::size_t)i);   // short read: fetch the rest
+    };
+
+    // Prime the ring: queue_depth reads in flight before the first parse.
+    std::uint64_t next_issue = 0;
+    for (; next_issue < std::min<std::uint64_t>(qd, num_blocks); ++next_issue) issue(next_issue);
+    bool io_ok = ring.submit(false);
+
+    for (std::uint64_t seq = 0; io_ok && seq < num_blocks; ++seq) {
+        Slot& s = slots[seq % qd];
+        ring.reap(on_cqe);
+        while (!s.ready && io_ok) {
+            io_ok = ring.submit(true);   // only block when the parser caught up with the disk
+            ring.reap(on_cqe);
+        }
+        if (!io_ok || s.failed) {
+            std::cerr << "read failed at offset " << s.offset + s.filled << "\n";
+            break;
+        }
+        if (!bp.consume(s.buf, s.want)) break;
+
+        // Buffer is free again: refill it with the next block past the window.
+        if (next_issue < num_blocks) {
+            issue(next_issue++);
+            io_ok = ring.submit(false);
+        }
+    }
+
+    // Reads can still be in flight after a parse stop, a failed read or a
+    // failed submit. Cancel them and wait for every completion before the
+    // buffers go away, whatever io_ok says.
+    for (std::size_t i = 0; i < slots.size(); ++i) {
+        if (slots[i].buf && !slots[i].ready) ring.prepCancel(i);
+    }
+    ring.submit(false);
+    if (!ring.drain()) {
+        // Cannot tell whether the kernel is done with them: leak rather
+        // than let a late read land in freed memory.
+        std::cerr << "io_uring drain failed, leaking " << block * qd << " bytes of read buffers\n";
+        buffers.data = nullptr;
+    }
+
+    ::close(fd);
+    return bp.count();
+}
+
+#else  // !__linux__
+
+std::uint64_t run_uring_replay(FeedHandler& fh, const char* filename,
+                               const UringReplayOptions&) {
+    std::cerr << "io_uring replay is Linux-only, using mmap replay\n";
+    return run_mmap_replay(fh, filename);
+}
+
+#endif
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+class FeedHandler;
+
+// Streaming replay for feed files that do not fit in memory: the file is read
+// block by block into a small ring of aligned buffers, with up to
+// `queue_depth` reads in flight ahead of the parser. Only
+// queue_depth * block_bytes of memory is used regardless of file size.
+//
+// Uses io_uring (raw syscalls, no liburing) on Linux. If io_uring is not
+// available it falls back to blocking pread() into the same buffers.
+struct UringReplayOptions {
+    std::size_t block_bytes = 1u << 20;  // bytes per read; rounded up to 4 KiB
+    unsigned    queue_depth = 8;         // buffers in the ring = max reads in flight
+    bool        direct      = false;     // O_DIRECT: bypass the page cache
+};
+
+std::uint64_t run_uring_replay(FeedHandler& fh, const char* filename,
+                               const UringReplayOptions& opts = UringReplayOptions{});
@@ -0,0 +1,98 @@
+#include "core/market_data.hpp"
+#include "feed/compact_codec.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// convert_feed — raw MarketUpdate feed <-> compact block feed.
+//
+//   convert_feed <in> <out> [block_records]   raw -> compact
+//   convert_feed <in> <out> --to-raw          compact -> raw
+// ---------------------------------------------------------------------------
+
+static int to_compact(std::ifstream& in, std::ofstream& out, uint32_t block_records) {
+    CompactFeedWriter writer(out, block_records);
+    std::vector<MarketUpdate> chunk(1u << 16);
+    uint64_t n = 0;
+    for (;;) {
+        in.read(reinterpret_cast<char*>(chunk.data()),
+                static_cast<std::streamsize>(chunk.size() * sizeof(MarketUpdate)));
+        const size_t got = static_cast<size_t>(in.gcount()) / sizeof(MarketUpdate);
+        for (size_t i = 0; i < got; ++i) writer.write(chunk[i]);
+        n += got;
+        if (got < chunk.size()) break;
+    }
+    writer.finish();
+
+    const uint64_t raw_bytes = n * sizeof(MarketUpdate);
+    std::cout << "Converted " << n << " messages: " << raw_bytes << " -> "
+              << writer.bytesWritten() << " bytes";
+    if (writer.bytesWritten() > 0)
+        std::cout << " (" << (double)raw_bytes / (double)writer.bytesWritten() << "x)";
+    std::cout << "\n";
+    return 0;
+}
+
+static int to_raw(std::ifstream& in, std::ofstream& out) {
+    CompactFileHeader fh;
+    if (!in.read(reinterpret_cast<char*>(&fh), sizeof(fh))
+        || !is_compact_feed(reinterpret_cast<const uint8_t*>(&fh),
+                            reinterpret_cast<const uint8_t*>(&fh) + sizeof(fh))) {
+        std::cerr << "Input is not a compact feed\n";
+        return 1;
+    }
+
+    CompactBlockDecoder       decoder;
+    std::vector<uint8_t>      block;
+    std::vector<MarketUpdate> batch(fh.block_records);
+    uint64_t n = 0;
+    CompactBlockHeader h;
+    while (in.read(reinterpret_cast<char*>(&h), sizeof(h))) {
+        block.resize(sizeof(h) + h.payload_bytes);
+        std::memcpy(block.data(), &h, sizeof(h));
+        if (!in.read(reinterpret_cast<char*>(block.data() + sizeof(h)), h.payload_bytes)) break;
+
+        size_t consumed = 0;
+        const size_t got = decoder.decode(block.data(), block.data() + block.size(),
+                                          batch.data(), batch.size(), consumed);
+        if (got == 0) {
+            std::cerr << "Malformed block after " << n << " messages\n";
+            return 1;
+        }
+        out.write(reinterpret_cast<const char*>(batch.data()),
+                  static_cast<std::streamsize>(got * sizeof(MarketUpdate)));
+        n += got;
+    }
+    std::cout << "Decoded " << n << " messages\n";
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cout << "Usage: convert_feed <in> <out> [block_records]   raw -> compact\n"
+                  << "       convert_feed <in> <out> --to-raw          compact -> raw\n";
+        return 1;
+    }
+
+    std::ifstream in(argv[1], std::ios::binary);
+    if (!in) {
+        std::cerr << "Failed to open input file\n";
+        return 1;
+    }
+    std::ofstream out(argv[2], std::ios::binary);
+    if (!out) {
+        std::cerr << "Failed to open output file\n";
+        return 1;
+    }
+
+    if (argc >= 4 && std::strcmp(argv[3], "--to-raw") == 0) return to_raw(in, out);
+
+    const uint32_t block_records = (argc >= 4)
+        ? (uint32_t)std::strtoul(argv[3], nullptr, 10) : COMPACT_BLOCK_RECORDS;
+    return to_compact(in, out, block_records);
+}
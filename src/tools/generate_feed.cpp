@@ -1,20 +1,42 @@
 #include "core/market_data.hpp"
+#include "feed/compact_codec.hpp"
+#include "replay/feed_index.hpp"
 
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <optional>
 #include <random>
+#include <string>
+#include <vector>
 #include <chrono>
 
 int main(int argc, char** argv) {
-    if (argc < 3) {
-        std::cout << "Usage: generate_feed <output_file> <num_messages>\n";
+    // --compact: write the block-compressed format (feed/compact_codec.hpp)
+    // --index:   also write the <output_file>.idx seek index (replay/feed_index.hpp)
+    bool compact = false;
+    bool index   = false;
+    std::vector<const char*> args;
+    for (int i = 1; i < argc; ++i) {
+        if      (std::strcmp(argv[i], "--compact") == 0) compact = true;
+        else if (std::strcmp(argv[i], "--index") == 0)   index   = true;
+        else args.push_back(argv[i]);
+    }
+    if (args.size() < 2) {
+        std::cout << "Usage: generate_feed <output_file> <num_messages> [num_symbols] "
+                     "[--compact] [--index]\n";
         return 1;
     }
 
-    const char* filename = argv[1];
-    uint64_t num = std::strtoull(argv[2], nullptr, 10);
+    const char* filename = args[0];
+    uint64_t num = std::strtoull(args[1], nullptr, 10);
+    uint32_t num_symbols = (args.size() >= 3) ? (uint32_t)std::strtoul(args[2], nullptr, 10) : 1;
+    if (num_symbols == 0 || num_symbols > 65536) {
+        std::cerr << "num_symbols must be in [1, 65536]\n";
+        return 1;
+    }
 
     std::ofstream out(filename, std::ios::binary);
     if (!out) {
@@ -27,6 +49,10 @@ int main(int argc, char** argv) {
     std::uniform_int_distribution<int> side_dist(0, 1);
     std::uniform_int_distribution<int> price_dist(-50, 50);
     std::uniform_int_distribution<int> qty_dist(1, 100);
+    std::uniform_int_distribution<uint32_t> symbol_dist(0, num_symbols - 1);
+
+    std::optional<CompactFeedWriter> writer;
+    if (compact) writer.emplace(out);
 
     for (uint64_t i = 0; i < num; ++i) {
         MarketUpdate mu{};
@@ -37,10 +63,29 @@ int main(int argc, char** argv) {
         mu.order_id = i + 1;
         mu.price    = 10000 + price_dist(rng);
         mu.qty      = qty_dist(rng);
+        mu.symbol_id = static_cast<uint16_t>(symbol_dist(rng));
 
-        out.write(reinterpret_cast<const char*>(&mu), sizeof(mu));
+        if (writer) writer->write(mu);
+        else        out.write(reinterpret_cast<const char*>(&mu), sizeof(mu));
     }
+    if (writer) writer->finish();
+    out.close();
+
+    std::cout << "Generated " << num << " messages (" << num_symbols
+              << " symbols" << (compact ? ", compact" : "") << ") into " << filename << "\n";
 
-    std::cout << "Generated " << num << " messages into " << filename << "\n";
+    if (index) {
+        // Generated feeds span ~0.2 s per million messages, so index them
+        // at a finer grain than the 100 ms / 1 min defaults. Their orders
+        // are never cancelled and every checkpoint is larger than the last,
+        // so space them by feed size rather than time.
+        FeedIndexOptions opts;
+        opts.interval_ns          = 1'000'000;    // 1 ms
+        opts.checkpoint_every     = 20;
+        opts.checkpoint_min_bytes = 32u << 20;    // 32 MiB of feed
+        const std::string idx = std::string(filename) + ".idx";
+        if (!build_feed_index(filename, idx.c_str(), opts)) return 1;
+        std::cout << "Indexed into " << idx << "\n";
+    }
     return 0;
 }
\ No newline at end of file
@@ -1,56 +1,246 @@
+#include <algorithm>
 #include <iostream>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "core/order_book.hpp"
 #include "core/ring_buffer.hpp"
 #include "engine/event_loop.hpp"
 #include "engine/imbalance_strategy.hpp"
+#include "engine/segmented_backtest.hpp"
 #include "feed/feed_handler.hpp"
+#include "replay/feed_index.hpp"
 #include "replay/mmap_replay.hpp"
 #include "risk/risk_manager.hpp"
+#include "util/cpu_affinity.hpp"
 #include "util/timer.hpp"
 
+static void print_result(const char* label, const BacktestResult& r, double elapsed) {
+    const ImbalanceStrategy::State& st = r.state;
+    std::cout << label << ": " << r.updates << " updates in " << elapsed << " s";
+    if (elapsed > 0.0) std::cout << " (" << r.updates / elapsed << " updates/sec)";
+    std::cout << "\n[ImbalanceStrategy]"
+              << "  ticks="        << st.ticks
+              << "  signals="      << st.signals_emitted
+              << "  round_trips="  << st.round_trips
+              << "  realized_pnl=" << st.realized_pnl
+              << "  total_pnl="    << r.total_pnl
+              << "  ema="          << st.ema
+              << "\n";
+}
+
+static int run_segmented(const char* filename, double ema_alpha, double threshold,
+                         std::size_t segments, std::uint64_t warmup, bool verify) {
+    const std::string idx_path = std::string(filename) + ".idx";
+    FeedIndex index(idx_path.c_str());
+    if (!index.ok()) {
+        std::cerr << "--segments needs " << idx_path << " (run index_feed first)\n";
+        return 1;
+    }
+    // Every range pays for its own book, checkpoint seed and warmup; that
+    // only pays off when the ranges really run side by side.
+    const unsigned hw = std::thread::hardware_concurrency();
+    if (hw != 0 && segments > hw) {
+        std::cerr << "Warning: " << segments << " segments on " << hw
+                  << " hardware threads; expect it to be slower than the serial run\n";
+    }
+    BacktestOptions opts;
+    opts.ema_alpha      = ema_alpha;
+    opts.threshold      = threshold;
+    opts.segments       = segments;
+    opts.warmup_records = warmup;
+    RiskManager risk(/*max_price*/ 20000, /*max_qty*/ 10);
+
+    const std::uint64_t t0 = get_monotonic_ns();
+    const BacktestResult r = run_segmented_backtest(filename, index, risk, opts);
+    const std::uint64_t t1 = get_monotonic_ns();
+    std::cout << "Segments : " << r.segments << " (warmup " << warmup << " records, "
+              << r.reruns << " replayed again for " << r.rerun_records << " records)\n\n";
+    print_result("Segmented", r, (t1 - t0) / 1e9);
+    if (!verify) return 0;
+
+    IndexBookConfig book;
+    book.min_price  = index.header().min_price;
+    book.max_price  = index.header().max_price;
+    book.max_orders = index.header().max_orders;
+    book.id_index   = static_cast<OrderIdIndex>(index.header().id_index);
+    const std::uint64_t t2 = get_monotonic_ns();
+    const BacktestResult s = run_serial_backtest(filename, book, risk, opts);
+    const std::uint64_t t3 = get_monotonic_ns();
+    print_result("Serial   ", s, (t3 - t2) / 1e9);
+
+    const bool same = r.state == s.state && r.total_pnl == s.total_pnl
+                   && r.signals.size() == s.signals.size()
+                   && std::equal(r.signals.begin(), r.signals.end(), s.signals.begin(),
+                                 [](const StrategySignal& a, const StrategySignal& b) {
+                                     return a.price == b.price && a.qty == b.qty;
+                                 });
+    std::cout << (same ? "Match    : segmented == serial\n" : "MISMATCH : segmented != serial\n");
+    return same ? 0 : 1;
+}
+
+struct StreamResult {
+    std::uint64_t msgs    = 0;
+    std::uint64_t updates = 0;
+    double        seconds = 0.0;
+};
+
+// Replay on this thread, `loop` on its own; endOfStream() closes the queue
+// after the last update and the loop returns once it is drained.
+template <typename Loop>
+static StreamResult stream_backtest(Loop& loop, FeedHandler& fh, const char* filename,
+                                    bool windowed, const FeedPosition& pos, std::uint64_t end_ts,
+                                    const std::vector<std::uint32_t>& cores,
+                                    const WaitStrategy::Options& wait_opts) {
+    loop.set_wait_strategy(wait_opts);
+    const bool pin = cores.size() >= 2;
+    const std::uint64_t t0 = get_monotonic_ns();
+    std::thread consumer([&] {
+        if (pin) pin_thread_to_core(cores[1]);
+        loop.run_streaming();
+    });
+    if (pin) pin_thread_to_core(cores[0]);
+    StreamResult r;
+    r.msgs = windowed ? run_mmap_replay_range(fh, filename, pos, end_ts)
+                      : run_mmap_replay(fh, filename);
+    fh.endOfStream();
+    consumer.join();
+    r.seconds = (get_monotonic_ns() - t0) / 1e9;
+    r.updates = loop.updates_processed();
+    return r;
+}
+
 int main(int argc, char** argv) {
-    if (argc < 2) {
-        std::cerr << "Usage: run_backtest <feed_file> [ema_alpha] [threshold]\n";
+    // --from / --to <seconds>: replay only that window, measured from the
+    // feed's first timestamp. Needs <feed_file>.idx (index_feed).
+    // --segments <k>: split the whole feed into k record ranges replayed in
+    // parallel (engine/segmented_backtest.hpp); also needs the index.
+    // --warmup <n> sets the records each segment replays before its start,
+    // --verify also runs the serial reference and compares.
+    // Otherwise replay and EventLoop run concurrently: --cores <producer>
+    // <consumer> pins the two threads, --wait spin|yield|park sets what the
+    // loop does while the queue is empty (spin-then-yield by default: close
+    // to busy-spin on a dedicated core, and it does not starve the replay
+    // when both threads share one). --dispatch virtual runs the loop through
+    // the Strategy interface instead of BasicEventLoop<ImbalanceStrategy>.
+    double from_s = -1.0, to_s = -1.0;
+    std::size_t segments = 0;
+    std::uint64_t warmup = BacktestOptions{}.warmup_records;
+    bool verify = false;
+    bool virtual_dispatch = false;
+    std::vector<std::uint32_t> cores;
+    WaitStrategy::Options wait_opts;
+    wait_opts.kind = WaitStrategy::Kind::SpinYield;
+    std::vector<const char*> args;
+    for (int i = 1; i < argc; ++i) {
+        if      (std::strcmp(argv[i], "--from") == 0 && i + 1 < argc) from_s = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--cores") == 0 && i + 2 < argc) {
+            cores.push_back((std::uint32_t)std::strtoul(argv[++i], nullptr, 10));
+            cores.push_back((std::uint32_t)std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (std::strcmp(argv[i], "--wait") == 0 && i + 1 < argc) {
+            ++i;
+            if      (std::strcmp(argv[i], "yield") == 0) wait_opts.kind = WaitStrategy::Kind::SpinYield;
+            else if (std::strcmp(argv[i], "park") == 0)  wait_opts.kind = WaitStrategy::Kind::Park;
+            else                                         wait_opts.kind = WaitStrategy::Kind::BusySpin;
+        }
+        else if (std::strcmp(argv[i], "--dispatch") == 0 && i + 1 < argc)
+            virtual_dispatch = std::strcmp(argv[++i], "virtual") == 0;
+        else if (std::strcmp(argv[i], "--to") == 0 && i + 1 < argc)   to_s   = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--segments") == 0 && i + 1 < argc)
+            segments = std::strtoull(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+            warmup = std::strtoull(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--verify") == 0) verify = true;
+        else args.push_back(argv[i]);
+    }
+    if (args.empty()) {
+        std::cerr << "Usage: run_backtest <feed_file> [ema_alpha] [threshold] "
+                     "[--from <s>] [--to <s>] [--segments <k> [--warmup <n>] [--verify]] "
+                     "[--cores <producer> <consumer>] [--wait spin|yield|park] "
+                     "[--dispatch static|virtual]\n";
         return 1;
     }
-    const char* filename  = argv[1];
-    double      ema_alpha = (argc >= 3) ? std::atof(argv[2]) : 0.1;
-    double      threshold = (argc >= 4) ? std::atof(argv[3]) : 0.3;
+    const char* filename  = args[0];
+    double      ema_alpha = (args.size() >= 2) ? std::atof(args[1]) : 0.1;
+    double      threshold = (args.size() >= 3) ? std::atof(args[2]) : 0.3;
+    const bool  windowed  = from_s >= 0.0 || to_s >= 0.0;
 
     std::cout << "=== Backtest: ImbalanceStrategy ===\n";
     std::cout << "Feed     : " << filename  << "\n";
     std::cout << "EMA α    : " << ema_alpha << "\n";
     std::cout << "Threshold: " << threshold << "\n\n";
 
-    constexpr std::size_t QUEUE_CAP = 1u << 20;
+    if (segments > 0) {
+        if (windowed) {
+            std::cerr << "--segments replays the whole feed; drop --from/--to\n";
+            return 1;
+        }
+        return run_segmented(filename, ema_alpha, threshold, segments, warmup, verify);
+    }
 
-    SpscRing<MarketUpdate>   md_queue(QUEUE_CAP);
-    SpscRing<StrategySignal> out_queue(QUEUE_CAP);
+    // The loop consumes while the replay produces, so the market-data ring
+    // only absorbs bursts: 4096 updates (192 KiB) stay in L2.
+    constexpr std::size_t MD_QUEUE_CAP  = 1u << 12;
+    constexpr std::size_t OUT_QUEUE_CAP = 1u << 20;
+
+    SpscRing<MarketUpdate>   md_queue(MD_QUEUE_CAP);
+    SpscRing<StrategySignal> out_queue(OUT_QUEUE_CAP);
 
     // Price range must match generate_feed: price = 10000 ± 50
     OrderBook           ob(9900, 10100, 2'000'000);
+    ob.enableFeatures(5);
     RiskManager         risk(/*max_price*/ 20000, /*max_qty*/ 10);
     ImbalanceStrategy   strategy(ob, ema_alpha, threshold);
     FeedHandler         fh(md_queue);
-    EventLoop           loop(md_queue, out_queue, ob, strategy, risk,
-                             /*timer_interval_ns*/ UINT64_MAX);  // disable periodic timer
 
-    std::uint64_t num_msgs = run_mmap_replay(fh, filename);
+    FeedPosition  pos;
+    std::uint64_t end_ts = UINT64_MAX;
+    if (windowed) {
+        const std::string idx_path = std::string(filename) + ".idx";
+        FeedIndex index(idx_path.c_str());
+        if (!index.ok()) {
+            std::cerr << "--from/--to need " << idx_path << " (run index_feed first)\n";
+            return 1;
+        }
+        const std::uint64_t first    = index.header().first_ts;
+        const std::uint64_t start_ts = first + (std::uint64_t)(std::max(from_s, 0.0) * 1e9);
+        if (to_s >= 0.0) end_ts = first + (std::uint64_t)(to_s * 1e9);
 
-    const std::uint64_t t0 = get_monotonic_ns();
-    loop.run();
-    const std::uint64_t t1 = get_monotonic_ns();
+        // Book state at the window start comes from the nearest checkpoint,
+        // restored before the loop thread starts touching the book.
+        const std::uint64_t s0 = get_monotonic_ns();
+        if (!seek_feed(filename, &index, start_ts, ob, pos)) return 1;
+        const std::uint64_t s1 = get_monotonic_ns();
+        std::cout << "Window   : [" << std::max(from_s, 0.0) << " s, ";
+        if (to_s >= 0.0) std::cout << to_s << " s)"; else std::cout << "end)";
+        std::cout << " from record " << pos.record << ", seek " << (s1 - s0) / 1e6 << " ms\n\n";
+    }
 
-    double elapsed = (t1 - t0) / 1e9;
+    // Timer disabled; feed-time clock, so the loop reads no clock at all.
+    constexpr std::uint64_t NO_TIMER = UINT64_MAX;
+    StreamResult r;
+    if (virtual_dispatch) {
+        EventLoop loop(md_queue, out_queue, ob, strategy, risk, NO_TIMER, LoopClock::Event);
+        r = stream_backtest(loop, fh, filename, windowed, pos, end_ts, cores, wait_opts);
+    } else {
+        BasicEventLoop<ImbalanceStrategy> loop(md_queue, out_queue, ob, strategy, risk,
+                                               NO_TIMER, LoopClock::Event);
+        r = stream_backtest(loop, fh, filename, windowed, pos, end_ts, cores, wait_opts);
+    }
 
     std::cout << "=== Results ===\n";
-    std::cout << "Messages  : " << num_msgs             << "\n";
-    std::cout << "Updates   : " << loop.updates_processed() << "\n";
-    std::cout << "Elapsed   : " << elapsed              << " s\n";
-    if (elapsed > 0.0)
-        std::cout << "Throughput: " << loop.updates_processed() / elapsed
+    std::cout << "Dispatch  : " << (virtual_dispatch ? "virtual (EventLoop)"
+                                                     : "static (BasicEventLoop<ImbalanceStrategy>)") << "\n";
+    std::cout << "Messages  : " << r.msgs    << "\n";
+    std::cout << "Updates   : " << r.updates << "\n";
+    std::cout << "Elapsed   : " << r.seconds << " s\n";
+    if (r.seconds > 0.0)
+        std::cout << "Throughput: " << r.updates / r.seconds
                   << " updates/sec\n";
     std::cout << "\n";
     strategy.print_summary();
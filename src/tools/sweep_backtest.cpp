@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "engine/param_sweep.hpp"
+#include "engine/segmented_backtest.hpp"
+#include "risk/risk_manager.hpp"
+#include "util/timer.hpp"
+
+// ---------------------------------------------------------------------------
+// sweep_backtest — ImbalanceStrategy over a grid of (ema_alpha, threshold).
+//
+//   sweep_backtest <feed> [--alpha lo hi n] [--threshold lo hi n]
+//                  [--threads n] [--block k] [--cores c...] [--out file.csv]
+//                  [--top n] [--isa avx512|avx2|scalar] [--per-config] [--verify]
+//
+// The feed is replayed once into a top-of-book stream, then every
+// configuration runs over it on a work-stealing pool
+// (engine/param_sweep.hpp), a block at a time as one
+// BatchImbalanceStrategy. --isa caps its instruction set; --per-config
+// runs one ImbalanceStrategy per configuration instead. Prints the best
+// `--top` rows by total PnL and writes the full table to `--out`. --verify
+// compares every row against a --per-config sweep, then re-runs the first,
+// middle and last configuration as a normal serial backtest and compares.
+// ---------------------------------------------------------------------------
+
+static std::vector<double> axis(double lo, double hi, std::size_t n) {
+    std::vector<double> v;
+    for (std::size_t i = 0; i < n; ++i) {
+        v.push_back(n == 1 ? lo : lo + (hi - lo) * (double)i / (double)(n - 1));
+    }
+    return v;
+}
+
+int main(int argc, char** argv) {
+    double      alpha_lo = 0.01, alpha_hi = 0.5, thr_lo = 0.05, thr_hi = 0.8;
+    std::size_t alpha_n = 32, thr_n = 32, top = 10;
+    const char* out = nullptr;
+    bool        verify = false;
+    SweepOptions opts;
+    std::vector<const char*> args;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--alpha") == 0 && i + 3 < argc) {
+            alpha_lo = std::atof(argv[++i]);
+            alpha_hi = std::atof(argv[++i]);
+            alpha_n  = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--threshold") == 0 && i + 3 < argc) {
+            thr_lo = std::atof(argv[++i]);
+            thr_hi = std::atof(argv[++i]);
+            thr_n  = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) opts.threads = std::strtoul(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--block") == 0 && i + 1 < argc)   opts.block = std::strtoul(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc)     out = argv[++i];
+        else if (std::strcmp(argv[i], "--top") == 0 && i + 1 < argc)     top = std::strtoul(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--verify") == 0)                  verify = true;
+        else if (std::strcmp(argv[i], "--per-config") == 0)              opts.batched = false;
+        else if (std::strcmp(argv[i], "--isa") == 0 && i + 1 < argc) {
+            const char* isa = argv[++i];
+            if (std::strcmp(isa, "avx2") == 0)        opts.max_isa = BatchImbalanceStrategy::Isa::Avx2;
+            else if (std::strcmp(isa, "scalar") == 0) opts.max_isa = BatchImbalanceStrategy::Isa::Scalar;
+            else                                      opts.max_isa = BatchImbalanceStrategy::Isa::Avx512;
+        }
+        else if (std::strcmp(argv[i], "--cores") == 0) {
+            while (i + 1 < argc && std::strspn(argv[i + 1], "0123456789") == std::strlen(argv[i + 1])) {
+                opts.cores.push_back((std::uint32_t)std::strtoul(argv[++i], nullptr, 10));
+            }
+        }
+        else args.push_back(argv[i]);
+    }
+    if (args.size() != 1 || alpha_n == 0 || thr_n == 0) {
+        std::cerr << "Usage: sweep_backtest <feed> [--alpha lo hi n] [--threshold lo hi n] "
+                     "[--threads n] [--block k] [--cores c...] [--out file.csv] [--top n] "
+                     "[--isa avx512|avx2|scalar] [--per-config] [--verify]\n";
+        return 1;
+    }
+    const char* feed = args[0];
+    const std::vector<SweepParams> grid = make_sweep_grid(axis(alpha_lo, alpha_hi, alpha_n),
+                                                          axis(thr_lo, thr_hi, thr_n));
+
+    // Book as in run_backtest: 9900..10100, 2M orders, 5 feature levels.
+    const IndexBookConfig book;
+    constexpr std::size_t DEPTH_LEVELS = 5;
+
+    const std::uint64_t t0 = get_monotonic_ns();
+    TopOfBookStream stream;
+    if (!build_top_of_book_stream(feed, book, DEPTH_LEVELS, stream)) {
+        std::cerr << "Cannot read " << feed << "\n";
+        return 1;
+    }
+    const std::uint64_t t1 = get_monotonic_ns();
+    SweepStats stats;
+    const SweepResults res = run_param_sweep(stream, grid, opts, &stats);
+    const std::uint64_t t2 = get_monotonic_ns();
+
+    const double build_s = (t1 - t0) / 1e9;
+    const double sweep_s = (t2 - t1) / 1e9;
+    std::cout << "=== Sweep: ImbalanceStrategy ===\n"
+              << "Feed          : " << feed << " (" << stream.updates << " updates)\n"
+              << "Top-of-book   : " << stream.runs.size() << " runs ("
+              << stream.runs.size() * sizeof(TopRun) / 1e6 << " MB), built in " << build_s << " s\n"
+              << "Grid          : " << alpha_n << " alpha x " << thr_n << " threshold = "
+              << grid.size() << " configurations\n"
+              << "Workers       : " << stats.threads << " (" << stats.tasks << " tasks of "
+              << std::max<std::size_t>(opts.block, 1) << ", " << stats.steals << " stolen)\n"
+              << "Strategy      : "
+              << (opts.batched ? std::string("batched, ") + BatchImbalanceStrategy::isaName(stats.isa)
+                               : std::string("one ImbalanceStrategy per configuration")) << "\n"
+              << "Sweep         : " << sweep_s << " s";
+    if (sweep_s > 0.0) {
+        std::cout << " (" << grid.size() / sweep_s << " configs/s, "
+                  << (double)grid.size() * stream.updates / sweep_s / 1e6 << " M strategy-updates/s)";
+    }
+    std::cout << "\n\n";
+
+    std::vector<std::size_t> order(res.rows());
+    std::iota(order.begin(), order.end(), 0);
+    top = std::min(top, order.size());
+    std::partial_sort(order.begin(), order.begin() + top, order.end(),
+                      [&](std::size_t a, std::size_t b) { return res.total_pnl[a] > res.total_pnl[b]; });
+    std::cout << "   alpha  threshold   signals  round_trips  realized_pnl   total_pnl\n";
+    for (std::size_t k = 0; k < top; ++k) {
+        const std::size_t i = order[k];
+        std::cout << std::fixed << std::setprecision(4)
+                  << std::setw(8) << res.ema_alpha[i] << std::setw(11) << res.threshold[i]
+                  << std::setw(10) << res.signals[i] << std::setw(13) << res.round_trips[i]
+                  << std::setprecision(1)
+                  << std::setw(14) << res.realized_pnl[i] << std::setw(12) << res.total_pnl[i] << "\n";
+    }
+    std::cout.unsetf(std::ios::floatfield);
+
+    if (out) {
+        if (!res.writeCsv(out)) {
+            std::cerr << "Cannot write " << out << "\n";
+            return 1;
+        }
+        std::cout << "\nWrote " << res.rows() << " rows to " << out << "\n";
+    }
+
+    if (verify) {
+        bool all_same = true;
+        if (opts.batched) {
+            SweepOptions po = opts;
+            po.batched = false;
+            const SweepResults ref = run_param_sweep(stream, grid, po);
+            std::size_t differ = 0;
+            for (std::size_t i = 0; i < grid.size(); ++i) {
+                differ += !(ref.ticks[i] == res.ticks[i]
+                            && ref.signals[i] == res.signals[i]
+                            && ref.round_trips[i] == res.round_trips[i]
+                            && ref.realized_pnl[i] == res.realized_pnl[i]
+                            && ref.total_pnl[i] == res.total_pnl[i]
+                            && ref.ema[i] == res.ema[i]);
+            }
+            all_same &= differ == 0;
+            if (differ == 0) std::cout << "Match    : all " << grid.size() << " rows == per-config sweep\n";
+            else             std::cout << "MISMATCH : " << differ << " rows differ from per-config sweep\n";
+        }
+        RiskManager risk(/*max_price*/ 20000, /*max_qty*/ 10);
+        for (std::size_t i : {std::size_t{0}, grid.size() / 2, grid.size() - 1}) {
+            BacktestOptions bo;
+            bo.ema_alpha    = grid[i].ema_alpha;
+            bo.threshold    = grid[i].threshold;
+            bo.depth_levels = DEPTH_LEVELS;
+            const BacktestResult s = run_serial_backtest(feed, book, risk, bo);
+            const bool same = s.state.ticks == res.ticks[i]
+                           && s.state.signals_emitted == res.signals[i]
+                           && s.state.round_trips == res.round_trips[i]
+                           && s.state.realized_pnl == res.realized_pnl[i]
+                           && s.total_pnl == res.total_pnl[i]
+                           && s.state.ema == res.ema[i];
+            all_same &= same;
+            std::cout << (same ? "Match    : row " : "MISMATCH : row ") << i << " == serial backtest\n";
+        }
+        return all_same ? 0 : 1;
+    }
+    return 0;
+}
@@ -1,11 +1,28 @@
 #pragma once
-#include <windows.h>
 #include <cstdint>
 
+#ifdef _WIN32
+#include <windows.h>
+
 // Pin the current thread to a specific CPU core on Windows.
 // core_id = 0, 1, 2, ...
 inline void pin_thread_to_core(std::uint32_t core_id) {
     DWORD_PTR mask = (1ull << core_id);
     HANDLE thread = GetCurrentThread();
     SetThreadAffinityMask(thread, mask);
-}
\ No newline at end of file
+}
+
+#else
+#include <pthread.h>
+#include <sched.h>
+
+// Pin the current thread to a specific CPU core (Linux).
+// core_id = 0, 1, 2, ...
+inline void pin_thread_to_core(std::uint32_t core_id) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core_id, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+#endif
@@ -1,6 +1,58 @@
 #pragma once
 #include <chrono>
+#include <cstdint>
 
 static inline std::uint64_t get_monotonic_ns() {
     return std::chrono::steady_clock::now().time_since_epoch().count();
-}
\ No newline at end of file
+}
+
+// Simulated clock for backtests, driven by the feed's timestamps
+// (MarketUpdate::ts) instead of the machine's clock, so timers fire at the
+// same feed times on every run and at any replay speed.
+//
+// Timer boundaries are the multiples of `interval_ns`. advance(ts, fire)
+// calls fire(t) for every boundary t <= ts not fired yet, in order and
+// with the exact boundary time, however many fall between two updates.
+// The first boundary is the first multiple after the first ts seen, so a
+// windowed replay fires on the same grid as a full one.
+class SimClock {
+public:
+    // 0 or UINT64_MAX: no timer; now() still follows the feed.
+    explicit SimClock(std::uint64_t interval_ns = 0) noexcept
+        : interval_ns_(interval_ns)
+        , next_ns_(interval_ns == 0 || interval_ns == UINT64_MAX ? UINT64_MAX : 0)
+    {}
+
+    template <typename Fire>
+    void advance(std::uint64_t ts_ns, Fire&& fire) {
+        if (ts_ns > now_ns_) now_ns_ = ts_ns;
+        if (ts_ns >= next_ns_) [[unlikely]] fire_until(ts_ns, fire);
+    }
+
+    // Latest feed time seen.
+    std::uint64_t now() const noexcept { return now_ns_; }
+
+    // Next boundary (UINT64_MAX if none; 0 before the first ts).
+    std::uint64_t nextTimer() const noexcept { return next_ns_; }
+
+private:
+    template <typename Fire>
+    void fire_until(std::uint64_t ts_ns, Fire& fire) {
+        if (next_ns_ == UINT64_MAX) return;   // no timer, or past the last boundary
+        if (next_ns_ == 0) next_ns_ = boundary_after(ts_ns);
+        while (next_ns_ <= ts_ns) {
+            const std::uint64_t t = next_ns_;
+            next_ns_ = (UINT64_MAX - t < interval_ns_) ? UINT64_MAX : t + interval_ns_;
+            fire(t);
+        }
+    }
+
+    std::uint64_t boundary_after(std::uint64_t ts_ns) const noexcept {
+        const std::uint64_t k = ts_ns / interval_ns_ + 1;
+        return (k > UINT64_MAX / interval_ns_) ? UINT64_MAX : k * interval_ns_;
+    }
+
+    std::uint64_t interval_ns_;
+    std::uint64_t next_ns_;      // 0: not anchored to the feed yet
+    std::uint64_t now_ns_ = 0;
+};
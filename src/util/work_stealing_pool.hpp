@@ -0,0 +1,103 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "cpu_affinity.hpp"
+
+// ---------------------------------------------------------------------------
+// WorkStealingPool — runs a fixed set of independent tasks on N threads.
+//
+// run(num_tasks, fn) deals the task indices out in contiguous blocks, one
+// deque per worker, then starts the workers. A worker takes tasks from the
+// back of its own deque and, once that is empty, steals from the front of
+// the others' (the tasks least likely to be next for their owner). run()
+// returns when every task has run; tasks never spawn more work, so a worker
+// that finds all deques empty is done.
+//
+// Meant for coarse tasks (milliseconds each, e.g. one backtest block): each
+// deque is a mutex and a std::deque, so taking a task costs one
+// uncontended lock.
+// ---------------------------------------------------------------------------
+class WorkStealingPool {
+public:
+    // If `cores` is non-empty, worker i is pinned to cores[i % cores.size()].
+    explicit WorkStealingPool(std::size_t num_workers, std::vector<std::uint32_t> cores = {})
+        : cores_(std::move(cores))
+    {
+        num_workers = std::max<std::size_t>(num_workers, 1);
+        for (std::size_t i = 0; i < num_workers; ++i) queues_.push_back(std::make_unique<Queue>());
+    }
+
+    std::size_t size() const noexcept { return queues_.size(); }
+
+    // Calls fn(task, worker) once for every task in [0, num_tasks), worker
+    // in [0, size()). Blocks until all have returned.
+    template <typename Fn>
+    void run(std::size_t num_tasks, Fn&& fn) {
+        const std::size_t n = queues_.size();
+        for (std::size_t w = 0; w < n; ++w) {
+            Queue& q = *queues_[w];
+            q.tasks.clear();
+            for (std::size_t t = num_tasks * w / n; t < num_tasks * (w + 1) / n; ++t) {
+                q.tasks.push_back(t);
+            }
+        }
+        steals_.store(0, std::memory_order_relaxed);
+
+        std::vector<std::thread> threads;
+        threads.reserve(n);
+        for (std::size_t w = 0; w < n; ++w) {
+            threads.emplace_back([this, w, &fn] {
+                if (!cores_.empty()) pin_thread_to_core(cores_[w % cores_.size()]);
+                std::size_t task;
+                while (take(w, task)) fn(task, w);
+            });
+        }
+        for (auto& t : threads) t.join();
+    }
+
+    // Tasks that ran on a worker other than the one they were dealt to,
+    // during the last run().
+    std::uint64_t steals() const noexcept { return steals_.load(std::memory_order_relaxed); }
+
+private:
+    struct alignas(64) Queue {
+        std::mutex              mutex;
+        std::deque<std::size_t> tasks;
+    };
+
+    bool take(std::size_t self, std::size_t& task) {
+        {
+            Queue& own = *queues_[self];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty()) {
+                task = own.tasks.back();
+                own.tasks.pop_back();
+                return true;
+            }
+        }
+        for (std::size_t i = 1; i < queues_.size(); ++i) {
+            Queue& victim = *queues_[(self + i) % queues_.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                task = victim.tasks.front();
+                victim.tasks.pop_front();
+                steals_.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::uint32_t>          cores_;
+    std::atomic<std::uint64_t>          steals_{0};
+};
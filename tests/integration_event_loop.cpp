@@ -2,6 +2,7 @@
 #include "core/ring_buffer.hpp"
 #include "core/order_book.hpp"
 #include "engine/event_loop.hpp"
+#include "engine/imbalance_strategy.hpp"
 #include "risk/risk_manager.hpp"
 #include "engine/strategy_interface.hpp"
 #include "engine/strategy_example.cpp"
@@ -9,32 +10,80 @@
 #include "feed/feed_handler.hpp"
 #include "util/timer.hpp"
 
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
 #include <thread>
 #include <iostream>
+#include <memory>
+#include <utility>
+#include <vector>
 
-int main() {
+// Synthetic feed, several times larger than the ring the loop reads from.
+static std::string write_feed(std::size_t n) {
+    const std::string path =
+        (std::filesystem::temp_directory_path() / "integration_event_loop.bin").string();
+    FILE* f = std::fopen(path.c_str(), "wb");
+    assert(f);
+    for (std::size_t i = 0; i < n; ++i) {
+        MarketUpdate u{};
+        u.ts       = 1'000 + i;
+        u.type     = UpdateType::Add;
+        u.order_id = i + 1;
+        u.price    = 10'000 + (std::int64_t)(i % 41) - 20;
+        u.qty      = 1 + (std::int64_t)(i % 7);
+        u.side     = (u.price < 10'000) ? OrderSide::Bid : OrderSide::Ask;
+        std::fwrite(&u, sizeof(u), 1, f);
+    }
+    std::fclose(f);
+    return path;
+}
+
+// Records when on_timer fires relative to the updates around it.
+class TimerLog : public Strategy {
+public:
+    void on_market_update(const MarketUpdate&) override { ++updates; }
+    void on_timer(std::uint64_t ts) override { fired.push_back({ts, updates}); }
+
+    std::uint64_t updates = 0;
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> fired;   // (time, updates seen)
+};
+
+int main(int argc, char** argv) {
     std::cout << "integration_event_loop main starting\n";
 
-    pin_thread_to_core(2);
-    std::cout << "after pin_thread_to_core\n";
+    constexpr std::size_t NUM_MSGS = 200'000;
+    const std::string feed = (argc > 1) ? argv[1] : write_feed(NUM_MSGS);
 
-    SpscRing<MarketUpdate>   md_queue(1 << 20);
+    // Streaming: replay on this thread, EventLoop on its own, through a
+    // ring much smaller than the feed.
+    SpscRing<MarketUpdate>   md_queue(1 << 10);
     SpscRing<StrategySignal> out_queue(1 << 20);
     OrderBook order_book(9900, 10100, 2'000'000);
     RiskManager risk(1'000'000, 10);
     DummyStrategy strategy(out_queue, 10);
     EventLoop loop(md_queue, out_queue, order_book, strategy, risk,
-                   /*timer_interval_ns*/ 100'000);
+                   /*timer_interval_ns*/ 100'000'000);
     FeedHandler feed_handler(md_queue);
 
-    run_mmap_replay(feed_handler, "sample_feed.bin");
-
     const std::uint64_t start_ns = get_monotonic_ns();
-    loop.run();
+    std::thread consumer([&] { loop.run_streaming(); });
+    const std::uint64_t msgs = run_mmap_replay(feed_handler, feed.c_str());
+    feed_handler.endOfStream();
+    consumer.join();
     const std::uint64_t end_ns = get_monotonic_ns();
 
     const double seconds = (end_ns - start_ns) / 1e9;
     const std::uint64_t updates = loop.updates_processed();
+    assert(updates == msgs);
+    if (argc <= 1) {
+        assert(msgs == NUM_MSGS);
+        std::vector<BookOrder> resting;   // every Add reached the book
+        order_book.snapshotOrders(resting);
+        assert(resting.size() == NUM_MSGS);
+    }
 
     std::cout << "=== EventLoop Stats ===\n";
     std::cout << "Updates processed: " << updates << "\n";
@@ -47,6 +96,91 @@ int main() {
         std::cout << "Throughput: n/a (elapsed time = 0)\n";
     }
 
+    // Shutdown: a parked loop on a queue that is never closed returns
+    // after stop().
+    {
+        SpscRing<MarketUpdate> q(1 << 6);
+        OrderBook ob(9900, 10100, 1'000);
+        DummyStrategy s(out_queue, 10);
+        EventLoop idle(q, out_queue, ob, s, risk, /*timer_interval_ns*/ UINT64_MAX);
+        WaitStrategy::Options park;
+        park.kind         = WaitStrategy::Kind::Park;
+        park.spin_limit   = 0;
+        park.park_timeout = std::chrono::seconds(10);
+        idle.set_wait_strategy(park);
+        std::thread t([&] { idle.run_streaming(); });
+        MarketUpdate u{};
+        u.type = UpdateType::Add; u.order_id = 1; u.price = 10'000; u.qty = 1;
+        bool ok = q.push(u);
+        assert(ok);
+        while (!q.empty()) std::this_thread::yield();
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        idle.stop();
+        t.join();
+        assert(idle.updates_processed() == 1);
+    }
+
+    // Event-time timers: every 1000 ns boundary fires once, at its exact
+    // time and before the first update at or past it, including the four
+    // that fall between ts 1500 and 5200.
+    {
+        SpscRing<MarketUpdate> q(1 << 6);
+        OrderBook ob(9900, 10100, 1'000);
+        TimerLog log;
+        EventLoop sim(q, out_queue, ob, log, risk, /*timer_interval_ns*/ 1'000,
+                      EventLoop::Clock::Event);
+        std::uint64_t id = 1;
+        for (std::uint64_t ts : {1'000, 1'500, 5'200, 5'300, 6'000}) {
+            MarketUpdate u{};
+            u.ts = ts; u.type = UpdateType::Add; u.order_id = id++; u.price = 10'000; u.qty = 1;
+            bool ok = q.push(u);
+            assert(ok);
+        }
+        sim.run();
+        const std::vector<std::pair<std::uint64_t, std::uint64_t>> expected = {
+            {2'000, 2}, {3'000, 2}, {4'000, 2}, {5'000, 2}, {6'000, 4}};
+        assert(log.fired == expected);
+        assert(sim.sim_clock().now() == 6'000);
+    }
+
+    // Static dispatch: BasicEventLoop<ImbalanceStrategy> ends in the same
+    // state as the virtual EventLoop on the same updates.
+    {
+        std::vector<MarketUpdate> msgs;
+        for (std::uint64_t i = 0; i < 20'000; ++i) {
+            MarketUpdate u{};
+            u.ts       = 1'000 + i;
+            u.type     = (i % 4 == 3) ? UpdateType::Cancel : UpdateType::Add;
+            u.order_id = (i % 4 == 3) ? i - 2 : i + 1;
+            u.side     = (i % 3 == 0) ? OrderSide::Ask : OrderSide::Bid;
+            u.price    = (u.side == OrderSide::Bid ? 9'990 : 10'010) - (std::int64_t)(i % 5);
+            u.qty      = 1 + (std::int64_t)(i % 9);
+            msgs.push_back(u);
+        }
+        auto backtest = [&](auto make_loop) {
+            SpscRing<MarketUpdate> q(1 << 15);
+            OrderBook ob(9900, 10100, 100'000);
+            ob.enableFeatures(5);
+            ImbalanceStrategy strat(ob, 0.2, 0.1);
+            const size_t pushed = q.push_bulk(msgs.data(), msgs.size());
+            assert(pushed == msgs.size());
+            auto loop = make_loop(q, ob, strat);
+            loop->run();
+            assert(loop->updates_processed() == msgs.size());
+            return strat.state();
+        };
+        const ImbalanceStrategy::State virt = backtest([&](auto& q, auto& ob, auto& strat) {
+            return std::make_unique<EventLoop>(q, out_queue, ob, strat, risk, UINT64_MAX);
+        });
+        const ImbalanceStrategy::State stat = backtest([&](auto& q, auto& ob, auto& strat) {
+            return std::make_unique<BasicEventLoop<ImbalanceStrategy>>(q, out_queue, ob, strat, risk,
+                                                                       UINT64_MAX);
+        });
+        assert(virt.signals_emitted > 0);
+        assert(virt == stat);
+    }
+
+    if (argc <= 1) std::filesystem::remove(feed);
     std::cout << "main returning\n";
     return 0;
-}
\ No newline at end of file
+}
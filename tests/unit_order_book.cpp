@@ -1,6 +1,8 @@
 #include "../src/core/order_book.hpp"
+#include "../src/core/book_manager.hpp"
 #include <cassert>
 #include <iostream>
+#include <vector>
 
 // ---------------------------------------------------------------------------
 // helpers
@@ -276,6 +278,364 @@ void test_cancel_nonexistent_order() {
     std::cout << "test_cancel_nonexistent_order passed\n";
 }
 
+// ---------------------------------------------------------------------------
+// Wide ladder — next best level found across bitmap word/summary boundaries
+// ---------------------------------------------------------------------------
+void test_cancel_best_wide_ladder() {
+    OrderBook ob(0, 300'000, 1000);
+    ob.applyUpdate(add(1,      10, 4, OrderSide::Bid));
+    ob.applyUpdate(add(2,  70'000, 5, OrderSide::Bid));
+    ob.applyUpdate(add(3, 299'999, 6, OrderSide::Bid));
+    ob.applyUpdate(add(4, 300'000, 7, OrderSide::Ask));
+    ob.applyUpdate(add(5,  70'001, 8, OrderSide::Ask));
+
+    PriceLevel pl;
+    ob.applyUpdate(cancel(3));
+    assert(ob.getBestBid(pl) && pl.price == 70'000 && pl.total_qty == 5);
+    ob.applyUpdate(cancel(2));
+    assert(ob.getBestBid(pl) && pl.price == 10 && pl.total_qty == 4);
+    ob.applyUpdate(cancel(1));
+    assert(!ob.getBestBid(pl));
+
+    ob.applyUpdate(cancel(5));
+    assert(ob.getBestAsk(pl) && pl.price == 300'000 && pl.total_qty == 7);
+    ob.applyUpdate(cancel(4));
+    assert(!ob.getBestAsk(pl));
+
+    // Refill after the side went empty
+    ob.applyUpdate(add(6, 0, 1, OrderSide::Bid));
+    assert(ob.getBestBid(pl) && pl.price == 0);
+    std::cout << "test_cancel_best_wide_ladder passed\n";
+}
+
+void test_modify_price_best_ask_emptied() {
+    OrderBook ob(90, 110, 1000);
+    ob.applyUpdate(add(1, 101, 10, OrderSide::Ask));
+    ob.applyUpdate(add(2, 104,  5, OrderSide::Ask));
+    ob.applyUpdate(modify(1, 106, 10, OrderSide::Ask));  // 101 is now empty
+
+    PriceLevel pl;
+    assert(ob.getBestAsk(pl));
+    assert(pl.price == 104);
+    assert(pl.total_qty == 5);
+    std::cout << "test_modify_price_best_ask_emptied passed\n";
+}
+
+// ---------------------------------------------------------------------------
+// Sliding-window ladder
+// ---------------------------------------------------------------------------
+void test_sliding_window_recenters_on_drift() {
+    // Window [95, 104]; mid drifts up to 107 via the bid side.
+    OrderBook ob(SlidingWindow{100, 10}, 1000);
+    assert(ob.minPrice() == 95 && ob.maxPrice() == 104);
+    ob.applyUpdate(add(1,  96, 3, OrderSide::Bid));
+    ob.applyUpdate(add(2, 104, 4, OrderSide::Ask));
+    ob.applyUpdate(add(3, 102, 5, OrderSide::Bid));
+
+    // 106 is outside the window but within width/2 of the mid (103):
+    // the window slides to [98, 107] and the bid at 96 is evicted.
+    ob.applyUpdate(add(4, 106, 6, OrderSide::Ask));
+    assert(ob.minPrice() == 98 && ob.maxPrice() == 107);
+    assert(ob.evictedOrders() == 1);
+
+    PriceLevel pl;
+    assert(ob.getBestBid(pl) && pl.price == 102 && pl.total_qty == 5);
+    assert(ob.getBestAsk(pl) && pl.price == 104 && pl.total_qty == 4);
+
+    // Cancelling the evicted order is a no-op; the rest of the book works
+    // across the wrapped ring slots.
+    ob.applyUpdate(cancel(1));
+    ob.applyUpdate(cancel(2));
+    assert(ob.getBestAsk(pl) && pl.price == 106 && pl.total_qty == 6);
+    ob.applyUpdate(cancel(3));
+    assert(!ob.getBestBid(pl));
+    std::cout << "test_sliding_window_recenters_on_drift passed\n";
+}
+
+void test_sliding_window_drops_far_outlier() {
+    OrderBook ob(SlidingWindow{100, 10}, 1000);
+    ob.applyUpdate(add(1,  99, 3, OrderSide::Bid));
+    ob.applyUpdate(add(2, 101, 4, OrderSide::Ask));
+    ob.applyUpdate(add(3, 500, 5, OrderSide::Ask));   // > width/2 from the mid
+
+    PriceLevel pl;
+    assert(ob.minPrice() == 95);
+    assert(ob.getBestAsk(pl) && pl.price == 101 && pl.total_qty == 4);
+    assert(ob.evictedOrders() == 0);
+    std::cout << "test_sliding_window_drops_far_outlier passed\n";
+}
+
+void test_sliding_window_empty_book_jumps() {
+    // With no resting orders the window simply re-centres on the new price.
+    OrderBook ob(SlidingWindow{100, 10}, 1000);
+    ob.applyUpdate(add(1, 1'000, 2, OrderSide::Bid));
+
+    PriceLevel pl;
+    assert(ob.minPrice() == 995 && ob.maxPrice() == 1'004);
+    assert(ob.getBestBid(pl) && pl.price == 1'000 && pl.total_qty == 2);
+    std::cout << "test_sliding_window_empty_book_jumps passed\n";
+}
+
+// ---------------------------------------------------------------------------
+// Hashed order-ID index — sparse 64-bit exchange IDs
+// ---------------------------------------------------------------------------
+void test_hashed_ids_sparse() {
+    OrderBook ob(90, 110, 4, OrderIdIndex::Hashed);
+    const uint64_t a = 0x8000'0000'0000'0001ull;
+    const uint64_t b = 0x0001'2345'6789'abcdull;
+    const uint64_t c = 0x7fff'ffff'ffff'fff0ull;
+
+    ob.applyUpdate(add(a, 100, 10, OrderSide::Bid));
+    ob.applyUpdate(add(b,  99,  5, OrderSide::Bid));
+    ob.applyUpdate(add(c, 105,  7, OrderSide::Ask));
+
+    PriceLevel pl;
+    ob.applyUpdate(modify(b, 99, 8, OrderSide::Bid));
+    ob.applyUpdate(cancel(a));
+    assert(ob.getBestBid(pl) && pl.price == 99 && pl.total_qty == 8);
+    assert(ob.getBestAsk(pl) && pl.price == 105 && pl.total_qty == 7);
+
+    // Node and map slots are reused after cancel.
+    ob.applyUpdate(cancel(b));
+    ob.applyUpdate(cancel(c));
+    ob.applyUpdate(add(a + 1, 101, 3, OrderSide::Bid));
+    assert(ob.getBestBid(pl) && pl.price == 101 && pl.total_qty == 3);
+    ob.applyUpdate(cancel(a));                     // already gone: no-op
+    assert(ob.getBestBid(pl) && pl.total_qty == 3);
+
+    // The map's reserved key is rejected, not left in the book uncancellable.
+    ob.applyUpdate(add(UINT64_MAX, 109, 4, OrderSide::Bid));
+    assert(ob.getBestBid(pl) && pl.price == 101 && pl.total_qty == 3);
+    ob.applyUpdate(cancel(a + 1));
+    assert(!ob.getBestBid(pl));
+    std::cout << "test_hashed_ids_sparse passed\n";
+}
+
+// ---------------------------------------------------------------------------
+// getDepth — top-N levels, best first
+// ---------------------------------------------------------------------------
+void test_get_depth() {
+    OrderBook ob(90, 110, 1000);
+    ob.applyUpdate(add(1, 100, 10, OrderSide::Bid));
+    ob.applyUpdate(add(2,  97,  5, OrderSide::Bid));
+    ob.applyUpdate(add(3, 100,  2, OrderSide::Bid));
+    ob.applyUpdate(add(4,  90,  1, OrderSide::Bid));
+    ob.applyUpdate(add(5, 103,  7, OrderSide::Ask));
+    ob.applyUpdate(add(6, 110,  9, OrderSide::Ask));
+
+    int64_t px[4], qty[4];
+    assert(ob.getDepth(OrderSide::Bid, 4, px, qty) == 3);
+    assert(px[0] == 100 && qty[0] == 12);
+    assert(px[1] ==  97 && qty[1] ==  5);
+    assert(px[2] ==  90 && qty[2] ==  1);
+
+    assert(ob.getDepth(OrderSide::Bid, 2, px, qty) == 2);
+    assert(px[1] == 97);
+
+    assert(ob.getDepth(OrderSide::Ask, 4, px, qty) == 2);
+    assert(px[0] == 103 && qty[0] == 7);
+    assert(px[1] == 110 && qty[1] == 9);
+    std::cout << "test_get_depth passed\n";
+}
+
+void test_get_depth_wrapped_window() {
+    // After a slide the window's ladder slots wrap around the ring.
+    OrderBook ob(SlidingWindow{100, 8}, 1000);   // [96, 103]
+    ob.applyUpdate(add(1, 101, 1, OrderSide::Bid));
+    ob.applyUpdate(add(2, 103, 1, OrderSide::Ask));
+    ob.applyUpdate(add(3, 105, 2, OrderSide::Ask));  // slides to [98, 105]
+    ob.applyUpdate(add(4,  99, 3, OrderSide::Bid));
+    ob.applyUpdate(add(5, 104, 4, OrderSide::Ask));
+
+    int64_t px[4], qty[4];
+    assert(ob.getDepth(OrderSide::Ask, 4, px, qty) == 3);
+    assert(px[0] == 103 && px[1] == 104 && px[2] == 105);
+    assert(qty[2] == 2);
+    assert(ob.getDepth(OrderSide::Bid, 4, px, qty) == 2);
+    assert(px[0] == 101 && px[1] == 99 && qty[1] == 3);
+    std::cout << "test_get_depth_wrapped_window passed\n";
+}
+
+// ---------------------------------------------------------------------------
+// BookFeatures — incrementally maintained on applyUpdate
+// ---------------------------------------------------------------------------
+void test_features_bbo_and_microprice() {
+    OrderBook ob(90, 110, 1000);
+    ob.enableFeatures(3);
+    ob.applyUpdate(add(1, 100, 30, OrderSide::Bid));
+    const BookFeatures& f = ob.features();
+    assert(f.has_bid && !f.has_ask && f.top_changed);
+
+    ob.applyUpdate(add(2, 102, 10, OrderSide::Ask));
+    assert(f.has_bid && f.has_ask && f.top_changed);
+    assert(f.bid_price == 100 && f.bid_qty == 30);
+    assert(f.ask_price == 102 && f.ask_qty == 10);
+    assert(f.spread == 2);
+    // (100 * 10 + 102 * 30) / 40
+    assert(f.microprice == 101.5);
+
+    ob.applyUpdate(cancel(2));
+    assert(!f.has_ask && f.top_changed);
+    std::cout << "test_features_bbo_and_microprice passed\n";
+}
+
+void test_features_depth_imbalance() {
+    OrderBook ob(90, 110, 1000);
+    ob.enableFeatures(2);
+    ob.applyUpdate(add(1, 100, 10, OrderSide::Bid));
+    ob.applyUpdate(add(2,  99,  5, OrderSide::Bid));
+    ob.applyUpdate(add(3,  98, 40, OrderSide::Bid));   // third level, outside depth 2
+    ob.applyUpdate(add(4, 101,  5, OrderSide::Ask));
+    const BookFeatures& f = ob.features();
+    assert(f.depth_bid_qty == 15 && f.depth_ask_qty == 5);
+    assert(f.depth_imbalance == 0.5);
+
+    ob.applyUpdate(cancel(2));                         // 98 moves into the window
+    assert(f.depth_bid_qty == 50);
+    assert(!f.top_changed);
+
+    ob.applyUpdate(modify(4, 101, 15, OrderSide::Ask));
+    assert(f.depth_ask_qty == 15 && f.ask_qty == 15 && f.top_changed);
+    std::cout << "test_features_depth_imbalance passed\n";
+}
+
+void test_features_deep_update_leaves_top() {
+    OrderBook ob(90, 110, 1000);
+    ob.enableFeatures(1);
+    ob.applyUpdate(add(1, 100, 10, OrderSide::Bid));
+    ob.applyUpdate(add(2, 105, 10, OrderSide::Ask));
+    ob.applyUpdate(add(3,  95,  7, OrderSide::Bid));
+    const BookFeatures& f = ob.features();
+    assert(!f.top_changed);
+    assert(f.depth_bid_qty == 10);
+
+    ob.applyUpdate(modify(3, 96, 8, OrderSide::Bid));
+    assert(!f.top_changed);
+    ob.applyUpdate(add(4, 100, 1, OrderSide::Bid));    // joins the best level
+    assert(f.top_changed && f.bid_qty == 11 && f.depth_bid_qty == 11);
+    std::cout << "test_features_deep_update_leaves_top passed\n";
+}
+
+// ---------------------------------------------------------------------------
+// Snapshot / restore
+// ---------------------------------------------------------------------------
+void test_snapshot_restore_orders() {
+    OrderBook ob(90, 110, 1000);
+    ob.enableFeatures(2);
+    ob.applyUpdate(add(1, 100, 10, OrderSide::Bid));
+    ob.applyUpdate(add(2, 100,  4, OrderSide::Bid));
+    ob.applyUpdate(add(3,  98,  7, OrderSide::Bid));
+    ob.applyUpdate(add(4, 103,  5, OrderSide::Ask));
+    ob.applyUpdate(add(5, 101,  6, OrderSide::Ask));
+    ob.applyUpdate(modify(1, 100, 9, OrderSide::Bid));
+    ob.applyUpdate(modify(3, 100, 2, OrderSide::Bid));  // moves behind order 2
+
+    std::vector<BookOrder> orders;
+    ob.snapshotOrders(orders);
+    assert(orders.size() == 5);
+    // bids best-first in queue order, then asks best-first
+    assert(orders[0].order_id == 1 && orders[0].qty == 9);
+    assert(orders[1].order_id == 2 && orders[2].order_id == 3 && orders[2].price == 100);
+    assert(orders[3].order_id == 5 && orders[4].order_id == 4);
+
+    OrderBook copy(90, 110, 1000);
+    copy.enableFeatures(2);
+    copy.restoreOrders(orders.data(), orders.size());
+    const BookFeatures& a = ob.features();
+    const BookFeatures& b = copy.features();
+    assert(a.bid_price == b.bid_price && a.bid_qty == b.bid_qty && b.bid_qty == 15);
+    assert(a.ask_price == b.ask_price && a.depth_ask_qty == b.depth_ask_qty);
+
+    // Same queues: cancelling the head leaves the same next order in both.
+    ob.applyUpdate(cancel(1));
+    copy.applyUpdate(cancel(1));
+    std::vector<BookOrder> x, y;
+    ob.snapshotOrders(x);
+    copy.snapshotOrders(y);
+    assert(x.size() == y.size());
+    for (size_t i = 0; i < x.size(); ++i) {
+        assert(x[i].order_id == y[i].order_id && x[i].qty == y[i].qty && x[i].price == y[i].price);
+    }
+    std::cout << "test_snapshot_restore_orders passed\n";
+}
+
+void test_copy_state() {
+    for (OrderIdIndex ids : {OrderIdIndex::Dense, OrderIdIndex::Hashed}) {
+        // A sliding window exercises the rotated origin and evictions too.
+        OrderBook ob(SlidingWindow{100, 16}, 1000, ids);
+        ob.enableFeatures(2);
+        ob.applyUpdate(add(1, 100, 10, OrderSide::Bid));
+        ob.applyUpdate(add(2,  99,  4, OrderSide::Bid));
+        ob.applyUpdate(add(3, 102,  7, OrderSide::Ask));
+        ob.applyUpdate(add(4, 110,  5, OrderSide::Ask));   // re-centres
+        ob.applyUpdate(cancel(2));
+
+        OrderBook copy(SlidingWindow{100, 16}, 1000, ids);
+        bool ok = copy.copyStateFrom(ob);
+        assert(ok);
+        assert(copy.minPrice() == ob.minPrice() && copy.maxPrice() == ob.maxPrice());
+        assert(copy.evictedOrders() == ob.evictedOrders());
+
+        // Both evolve identically from here, down to node reuse.
+        for (OrderBook* b : {&ob, &copy}) {
+            b->applyUpdate(add(5, 101, 3, OrderSide::Bid));
+            b->applyUpdate(modify(1, 101, 8, OrderSide::Bid));
+            b->applyUpdate(cancel(3));
+        }
+        std::vector<BookOrder> x, y;
+        ob.snapshotOrders(x);
+        copy.snapshotOrders(y);
+        assert(x.size() == y.size() && !x.empty());
+        for (size_t i = 0; i < x.size(); ++i) {
+            assert(x[i].order_id == y[i].order_id && x[i].qty == y[i].qty && x[i].price == y[i].price);
+        }
+        assert(ob.features().bid_qty == copy.features().bid_qty);
+        assert(ob.features().ask_price == copy.features().ask_price);
+    }
+
+    // Differently sized books cannot be copied.
+    OrderBook a(90, 110, 1000), b(90, 110, 500), c(90, 120, 1000);
+    a.applyUpdate(add(1, 100, 10, OrderSide::Bid));
+    bool ok = b.copyStateFrom(a);
+    assert(!ok);
+    ok = c.copyStateFrom(a);
+    assert(!ok);
+    PriceLevel pl;
+    assert(!b.getBestBid(pl));
+    std::cout << "test_copy_state passed\n";
+}
+
+// ---------------------------------------------------------------------------
+// BookManager — per-symbol routing
+// ---------------------------------------------------------------------------
+void test_book_manager_routes_by_symbol() {
+    BookManager books;
+    books.addBook(3,   90, 110, 1000);
+    books.addBook(700, 9900, 10100, 1000, OrderIdIndex::Hashed);
+    assert(books.size() == 2);
+
+    MarketUpdate a = add(1, 100, 10, OrderSide::Bid);
+    a.symbol_id = 3;
+    MarketUpdate b = add(1, 10050, 4, OrderSide::Ask);   // same order_id, other book
+    b.symbol_id = 700;
+    MarketUpdate c = add(2, 100, 1, OrderSide::Bid);
+    c.symbol_id = 4;                                    // no book registered
+
+    bool routed = books.applyUpdate(a);
+    assert(routed);
+    routed = books.applyUpdate(b);
+    assert(routed);
+    routed = books.applyUpdate(c);
+    assert(!routed);
+
+    PriceLevel pl;
+    assert(books.find(3)->getBestBid(pl) && pl.price == 100 && pl.total_qty == 10);
+    assert(!books.find(3)->getBestAsk(pl));
+    assert(books.find(700)->getBestAsk(pl) && pl.price == 10050 && pl.total_qty == 4);
+    assert(books.find(4) == nullptr);
+    std::cout << "test_book_manager_routes_by_symbol passed\n";
+}
+
 // ---------------------------------------------------------------------------
 int main() {
     test_basic_insert();
@@ -303,6 +663,27 @@ int main() {
     test_out_of_range_price_ignored();
     test_cancel_nonexistent_order();
 
+    test_cancel_best_wide_ladder();
+    test_modify_price_best_ask_emptied();
+
+    test_sliding_window_recenters_on_drift();
+    test_sliding_window_drops_far_outlier();
+    test_sliding_window_empty_book_jumps();
+
+    test_hashed_ids_sparse();
+
+    test_get_depth();
+    test_get_depth_wrapped_window();
+
+    test_features_bbo_and_microprice();
+    test_features_depth_imbalance();
+    test_features_deep_update_leaves_top();
+
+    test_snapshot_restore_orders();
+    test_copy_state();
+
+    test_book_manager_routes_by_symbol();
+
     std::cout << "\nAll order book tests passed\n";
     return 0;
 }
@@ -0,0 +1,756 @@
+#include "../src/core/ring_buffer.hpp"
+#include "../src/engine/batch_imbalance_strategy.hpp"
+#include "../src/engine/param_sweep.hpp"
+#include "../src/engine/segmented_backtest.hpp"
+#include "../src/feed/binary_parser.hpp"
+#include "../src/feed/compact_codec.hpp"
+#include "../src/feed/feed_handler.hpp"
+#include "../src/replay/feed_index.hpp"
+#include "../src/replay/merge_replay.hpp"
+#include "../src/replay/mmap_replay.hpp"
+#include "../src/replay/uring_replay.hpp"
+#include "../src/util/work_stealing_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// helpers
+// ---------------------------------------------------------------------------
+static constexpr size_t NUM_MSGS = 20'000;
+
+static std::string write_feed(const char* name, size_t trailing_bytes) {
+    const std::string path = (std::filesystem::temp_directory_path() / name).string();
+    FILE* f = std::fopen(path.c_str(), "wb");
+    assert(f);
+    for (size_t i = 0; i < NUM_MSGS; ++i) {
+        MarketUpdate u{};
+        u.ts        = 1'000 + i;
+        u.type      = (i % 3 == 0) ? UpdateType::Add : UpdateType::Modify;
+        u.order_id  = i * 7;
+        u.price     = 10'000 + (int64_t)(i % 101) - 50;
+        u.qty       = 1 + (int32_t)(i % 13);
+        u.side      = (i & 1) ? OrderSide::Ask : OrderSide::Bid;
+        u.symbol_id = (uint16_t)(i % 5);
+        std::fwrite(&u, sizeof(u), 1, f);
+    }
+    const uint8_t junk[sizeof(MarketUpdate)] = {0xAB};
+    std::fwrite(junk, 1, trailing_bytes, f);   // truncated record: must be ignored
+    std::fclose(f);
+    return path;
+}
+
+template <typename Replay>
+static std::vector<MarketUpdate> collect(Replay&& replay) {
+    MdQueue     queue(1u << 15);   // holds the whole file: single-threaded test
+    FeedHandler fh(queue);
+    const uint64_t n = replay(fh);
+    std::vector<MarketUpdate> out;
+    MarketUpdate u;
+    while (queue.pop(u)) out.push_back(u);
+    assert(out.size() == n);
+    return out;
+}
+
+static bool same(const std::vector<MarketUpdate>& a, const std::vector<MarketUpdate>& b) {
+    return a.size() == b.size()
+        && std::memcmp(a.data(), b.data(), a.size() * sizeof(MarketUpdate)) == 0;
+}
+
+// ---------------------------------------------------------------------------
+// mmap replay
+// ---------------------------------------------------------------------------
+void test_mmap_replay_reads_all_records() {
+    const std::string path = write_feed("unit_replay_a.bin", 0);
+    auto msgs = collect([&](FeedHandler& fh) { return run_mmap_replay(fh, path.c_str()); });
+    assert(msgs.size() == NUM_MSGS);
+    assert(msgs.front().ts == 1'000 && msgs.back().ts == 1'000 + NUM_MSGS - 1);
+    assert(msgs[9].symbol_id == 4 && msgs[9].side == OrderSide::Ask);
+
+    MmapReplayOptions opts;
+    opts.populate        = true;
+    opts.readahead_bytes = 64 * 1024;
+    auto tuned = collect([&](FeedHandler& fh) { return run_mmap_replay(fh, path.c_str(), opts); });
+    assert(same(msgs, tuned));
+    std::remove(path.c_str());
+    std::cout << "test_mmap_replay_reads_all_records passed\n";
+}
+
+// ---------------------------------------------------------------------------
+// io_uring streaming replay — must match mmap replay exactly
+// ---------------------------------------------------------------------------
+void test_uring_replay_matches_mmap() {
+    const std::string path = write_feed("unit_replay_b.bin", 17);
+    auto ref = collect([&](FeedHandler& fh) { return run_mmap_replay(fh, path.c_str()); });
+    assert(ref.size() == NUM_MSGS);
+
+    // 4 KiB blocks are not a multiple of the record size, so records
+    // straddle block boundaries; queue depth 3 wraps the buffer ring often.
+    UringReplayOptions opts;
+    opts.block_bytes = 4096;
+    opts.queue_depth = 3;
+    auto small = collect([&](FeedHandler& fh) { return run_uring_replay(fh, path.c_str(), opts); });
+    assert(same(ref, small));
+
+    auto dflt = collect([&](FeedHandler& fh) { return run_uring_replay(fh, path.c_str()); });
+    assert(same(ref, dflt));
+
+    opts.direct = true;   // falls back to buffered reads where O_DIRECT is unsupported
+    auto direct = collect([&](FeedHandler& fh) { return run_uring_replay(fh, path.c_str(), opts); });
+    assert(same(ref, direct));
+    std::remove(path.c_str());
+    std::cout << "test_uring_replay_matches_mmap passed\n";
+}
+
+void test_replay_missing_file() {
+    auto a = collect([](FeedHandler& fh) { return run_mmap_replay(fh, "/nonexistent/feed.bin"); });
+    auto b = collect([](FeedHandler& fh) { return run_uring_replay(fh, "/nonexistent/feed.bin"); });
+    assert(a.empty() && b.empty());
+    std::cout << "test_replay_missing_file passed\n";
+}
+
+// ---------------------------------------------------------------------------
+// Batch path: in-place parsing and FeedHandler::onBatch
+// ---------------------------------------------------------------------------
+void test_parse_batch_in_place() {
+    std::vector<MarketUpdate> recs(10);
+    for (size_t i = 0; i < recs.size(); ++i) recs[i].order_id = i;
+    const uint8_t* p   = reinterpret_cast<const uint8_t*>(recs.data());
+    const uint8_t* end = p + recs.size() * sizeof(MarketUpdate) - 1;   // last record cut short
+
+    BinaryParser parser;
+    auto all = parser.parseBatch(p, end, 100);
+    assert(all.size() == 9 && all.data() == recs.data());   // a view, not a copy
+    assert(parser.parseBatch(p, end, 4).size() == 4);
+    assert(parser.parseBatch(p + 1, end, 100).empty());     // misaligned
+    std::cout << "test_parse_batch_in_place passed\n";
+}
+
+void test_on_batch_routes_like_on_update() {
+    constexpr size_t SHARDS = 3;
+    std::vector<MarketUpdate> msgs(5'000);
+    std::mt19937_64 rng(11);
+    for (size_t i = 0; i < msgs.size(); ++i) {
+        msgs[i].order_id  = i;
+        // runs of one symbol exercise bulk pushes, random switches the split
+        msgs[i].symbol_id = (i / 64) % 2 ? (uint16_t)(rng() % 8) : (uint16_t)(i / 64 % 8);
+    }
+
+    MdQueue  ref_q[SHARDS] = {MdQueue(1u << 13), MdQueue(1u << 13), MdQueue(1u << 13)};
+    MdQueue  bat_q[SHARDS] = {MdQueue(1u << 13), MdQueue(1u << 13), MdQueue(1u << 13)};
+    MdQueue* ref_ptrs[SHARDS] = {&ref_q[0], &ref_q[1], &ref_q[2]};
+    MdQueue* bat_ptrs[SHARDS] = {&bat_q[0], &bat_q[1], &bat_q[2]};
+    FeedHandler ref(ref_ptrs, SHARDS), bat(bat_ptrs, SHARDS);
+
+    for (const MarketUpdate& u : msgs) {
+        bool ok = ref.onUpdate(u);
+        assert(ok);
+    }
+    bat.onBatch({msgs.data(), 1'000});
+    bat.onBatch({msgs.data() + 1'000, msgs.size() - 1'000});
+
+    for (size_t s = 0; s < SHARDS; ++s) {
+        MarketUpdate a, b;
+        while (ref_q[s].pop(a)) {
+            bool ok = bat_q[s].pop(b);
+            assert(ok && a.order_id == b.order_id);
+        }
+        assert(bat_q[s].empty());
+    }
+    std::cout << "test_on_batch_routes_like_on_update passed\n";
+}
+
+// ---------------------------------------------------------------------------
+// Compact block format
+// ---------------------------------------------------------------------------
+static std::vector<MarketUpdate> decode_all(const std::string& bytes, bool simd) {
+    const uint8_t* p   = reinterpret_cast<const uint8_t*>(bytes.data());
+    const uint8_t* end = p + bytes.size();
+    assert(is_compact_feed(p, end));
+    CompactFileHeader fh;
+    std::memcpy(&fh, p, sizeof(fh));
+    p += sizeof(fh);
+
+    CompactBlockDecoder dec(simd);
+    std::vector<MarketUpdate> out, batch(fh.block_records);
+    while (p < end) {
+        size_t consumed = 0;
+        const size_t n = dec.decode(p, end, batch.data(), batch.size(), consumed);
+        assert(n > 0);
+        out.insert(out.end(), batch.begin(), batch.begin() + n);
+        p += consumed;
+    }
+    assert(out.size() == fh.num_records);
+    return out;
+}
+
+void test_compact_round_trip() {
+    // Mix of small steps and extreme jumps so every column width (0/1/2/4/8)
+    // and negative deltas show up; 1000 records per block leaves a ragged
+    // tail for the 4-wide SIMD loops.
+    std::mt19937_64 rng(3);
+    std::vector<MarketUpdate> in;
+    uint64_t ts = 1'000'000;
+    for (size_t i = 0; i < 5'000; ++i) {
+        MarketUpdate u{};
+        ts += (i % 700 == 0) ? (1ull << 40) : rng() % 300;
+        u.ts        = ts;
+        u.type      = static_cast<UpdateType>(rng() % 3);
+        u.order_id  = (i < 2'000) ? i + 1 : rng();
+        u.price     = (i % 997 == 0) ? INT64_MIN + (int64_t)i : 10'000 + (int64_t)(rng() % 101) - 50;
+        u.qty       = (i % 13 == 0) ? -(int64_t)(rng() % 70'000) : (int64_t)(rng() % 100);
+        u.side      = static_cast<OrderSide>(rng() & 1);
+        u.symbol_id = (i < 3'000) ? 7 : (uint16_t)rng();
+        in.push_back(u);
+    }
+
+    std::ostringstream os;
+    CompactFeedWriter w(os, 1'000);
+    for (const MarketUpdate& u : in) w.write(u);
+    w.finish();
+    const std::string bytes = os.str();
+    assert(bytes.size() == w.bytesWritten());
+    assert(bytes.size() < in.size() * sizeof(MarketUpdate));
+
+    const auto scalar = decode_all(bytes, false);
+    assert(same(in, scalar));
+    if (CompactBlockDecoder::cpuHasAvx2()) {
+        assert(CompactBlockDecoder(true).simd());
+        const auto simd = decode_all(bytes, true);
+        assert(same(in, simd));
+    }
+    std::cout << "test_compact_round_trip passed\n";
+}
+
+void test_compact_replay_matches_raw() {
+    const std::string raw_path = write_feed("unit_replay_c.bin", 0);
+    const std::string cmp_path = raw_path + ".mdc";
+    auto ref = collect([&](FeedHandler& fh) { return run_mmap_replay(fh, raw_path.c_str()); });
+    {
+        std::ofstream out(cmp_path, std::ios::binary);
+        CompactFeedWriter w(out);
+        for (const MarketUpdate& u : ref) w.write(u);
+        w.finish();
+    }
+    assert(std::filesystem::file_size(cmp_path) * 4 < std::filesystem::file_size(raw_path));
+
+    auto mmap = collect([&](FeedHandler& fh) { return run_mmap_replay(fh, cmp_path.c_str()); });
+    assert(same(ref, mmap));
+    auto uring = collect([&](FeedHandler& fh) { return run_uring_replay(fh, cmp_path.c_str()); });
+    assert(same(ref, uring));
+    std::remove(raw_path.c_str());
+    std::remove(cmp_path.c_str());
+    std::cout << "test_compact_replay_matches_raw passed\n";
+}
+
+void test_compact_decode_in_place() {
+    const std::string raw_path = write_feed("unit_replay_ip.bin", 0);
+    const std::string cmp_path = raw_path + ".mdc";
+    auto ref = collect([&](FeedHandler& fh) { return run_mmap_replay(fh, raw_path.c_str()); });
+    {
+        std::ofstream out(cmp_path, std::ios::binary);
+        CompactFeedWriter w(out, 1000);
+        for (const MarketUpdate& u : ref) w.write(u);
+        w.finish();
+    }
+
+    // The ring's write position starts 2500 slots before its end: two
+    // blocks decode in place, the third is copied across the wrap, the rest
+    // decode in place again. Read back with peek/release.
+    for (bool in_place : {true, false}) {
+        MdQueue queue(1u << 15);
+        MarketUpdate u{};
+        for (size_t i = 0; i < (1u << 15) - 2'500; ++i) {
+            bool ok = queue.push(u) && queue.pop(u);
+            assert(ok);
+        }
+        FeedHandler       fh(queue);
+        MmapReplayOptions opts;
+        opts.decode_in_place = in_place;
+        const uint64_t n = run_mmap_replay(fh, cmp_path.c_str(), opts);
+        assert(n == ref.size());
+
+        std::vector<MarketUpdate> got;
+        for (auto span = queue.peek(4'096); !span.empty(); span = queue.peek(4'096)) {
+            got.insert(got.end(), span.begin(), span.end());
+            queue.release(span.size());
+        }
+        assert(same(ref, got));
+    }
+
+    // Several queues: records are routed after decoding, nothing to claim.
+    MdQueue      a(1u << 15), b(1u << 15);
+    MdQueue*     qs[] = {&a, &b};
+    FeedHandler  multi(qs, 2);
+    const auto claimed = multi.claim(1'000);
+    assert(claimed.empty());
+    std::remove(raw_path.c_str());
+    std::remove(cmp_path.c_str());
+    std::cout << "test_compact_decode_in_place passed\n";
+}
+
+// ---------------------------------------------------------------------------
+// K-way merge across files
+// ---------------------------------------------------------------------------
+void test_merge_replay_orders_by_ts() {
+    // Three venues with overlapping, tied and bursty timestamps; venue 1 is
+    // compact, venue 2 has a truncated tail record.
+    std::mt19937_64 rng(5);
+    std::vector<std::vector<MarketUpdate>> venues(3);
+    for (size_t v = 0; v < venues.size(); ++v) {
+        uint64_t ts = 100;
+        const size_t n = 3'000 + v * 1'700;
+        for (size_t i = 0; i < n; ++i) {
+            MarketUpdate u{};
+            ts += (rng() % 4 == 0) ? 0 : rng() % (v == 2 ? 50 : 9);   // many equal ts
+            u.ts        = ts;
+            u.order_id  = (v << 32) | i;
+            u.symbol_id = (uint16_t)v;
+            venues[v].push_back(u);
+        }
+    }
+
+    const auto tmp = std::filesystem::temp_directory_path();
+    const std::string paths[3] = {(tmp / "unit_merge_0.bin").string(),
+                                  (tmp / "unit_merge_1.mdc").string(),
+                                  (tmp / "unit_merge_2.bin").string()};
+    {
+        std::ofstream out(paths[0], std::ios::binary);
+        out.write(reinterpret_cast<const char*>(venues[0].data()),
+                  (std::streamsize)(venues[0].size() * sizeof(MarketUpdate)));
+    }
+    {
+        std::ofstream out(paths[1], std::ios::binary);
+        CompactFeedWriter w(out, 500);
+        for (const MarketUpdate& u : venues[1]) w.write(u);
+        w.finish();
+    }
+    {
+        std::ofstream out(paths[2], std::ios::binary);
+        out.write(reinterpret_cast<const char*>(venues[2].data()),
+                  (std::streamsize)(venues[2].size() * sizeof(MarketUpdate)));
+        out.write("junk", 4);
+    }
+
+    // Reference: stable sort of the concatenation == ties in file order.
+    std::vector<MarketUpdate> ref;
+    for (const auto& v : venues) ref.insert(ref.end(), v.begin(), v.end());
+    std::stable_sort(ref.begin(), ref.end(),
+                     [](const MarketUpdate& a, const MarketUpdate& b) { return a.ts < b.ts; });
+
+    const char* files[3] = {paths[0].c_str(), paths[1].c_str(), paths[2].c_str()};
+    MdQueue     queue(1u << 15);
+    FeedHandler fh(queue);
+    uint64_t n = run_merge_replay(fh, files);
+    assert(n == ref.size());
+    MarketUpdate u;
+    for (const MarketUpdate& r : ref) {
+        bool ok = queue.pop(u);
+        assert(ok && u.order_id == r.order_id && u.ts == r.ts);
+    }
+    assert(queue.empty());
+
+    // One missing input: nothing is published.
+    const char* bad[2] = {paths[0].c_str(), "/nonexistent/feed.bin"};
+    n = run_merge_replay(fh, bad);
+    assert(n == 0 && queue.empty());
+
+    for (const std::string& p : paths) std::remove(p.c_str());
+    std::cout << "test_merge_replay_orders_by_ts passed\n";
+}
+
+// ---------------------------------------------------------------------------
+// Timestamp index: seek + windowed replay must match a replay from byte 0
+// ---------------------------------------------------------------------------
+static std::vector<MarketUpdate> make_live_book_feed(size_t n) {
+    // Adds, re-prices and cancels of live orders, so the book at any point
+    // depends on the whole history.
+    std::mt19937_64 rng(9);
+    std::vector<MarketUpdate> out;
+    std::vector<uint64_t> live;
+    uint64_t ts = 1'000'000, next_id = 1;
+    for (size_t i = 0; i < n; ++i) {
+        MarketUpdate u{};
+        ts += rng() % 2'000;
+        u.ts   = ts;
+        u.side = (rng() & 1) ? OrderSide::Ask : OrderSide::Bid;
+        u.price = (u.side == OrderSide::Bid ? 9'990 : 10'010) + (int64_t)(rng() % 21) - 10;
+        u.qty   = 1 + (int64_t)(rng() % 50);
+        const unsigned r = (unsigned)(rng() % 10);
+        if (live.size() < 50 || r < 4) {
+            u.type = UpdateType::Add;
+            u.order_id = next_id++;
+            live.push_back(u.order_id);
+        } else {
+            const size_t k = rng() % live.size();
+            u.order_id = live[k];
+            if (r < 7) {
+                u.type = UpdateType::Modify;
+            } else {
+                u.type = UpdateType::Cancel;
+                live[k] = live.back();
+                live.pop_back();
+            }
+        }
+        out.push_back(u);
+    }
+    return out;
+}
+
+static void check_same_book(const OrderBook& a, const OrderBook& b) {
+    std::vector<BookOrder> x, y;
+    a.snapshotOrders(x);
+    b.snapshotOrders(y);
+    assert(x.size() == y.size());
+    for (size_t i = 0; i < x.size(); ++i) {
+        assert(x[i].order_id == y[i].order_id && x[i].price == y[i].price
+               && x[i].qty == y[i].qty && x[i].side == y[i].side);
+    }
+}
+
+static void check_index_seek(const std::string& feed, const std::vector<MarketUpdate>& msgs) {
+    const std::string idx = feed + ".idx";
+    FeedIndexOptions opts;
+    opts.interval_ns      = 200'000;   // ~200 records per entry
+    opts.checkpoint_every = 5;
+    opts.book             = {9'900, 10'100, 100'000, OrderIdIndex::Dense};
+    bool ok = build_feed_index(feed.c_str(), idx.c_str(), opts);
+    assert(ok);
+
+    FeedIndex index(idx.c_str());
+    assert(index.ok());
+    assert(index.header().num_records == msgs.size());
+    assert(index.header().first_ts == msgs.front().ts && index.header().last_ts == msgs.back().ts);
+    assert(index.entries().size() > 20);
+    assert(index.checkpointBefore(msgs.front().ts) == nullptr);
+
+    const uint64_t span = msgs.back().ts - msgs.front().ts;
+    for (uint64_t start : {msgs.front().ts, msgs.front().ts + span / 3, msgs.front().ts + span * 4 / 5,
+                           msgs[7'777].ts, msgs.back().ts + 1}) {
+        const uint64_t end = start + span / 10;
+
+        OrderBook ref(9'900, 10'100, 100'000);
+        size_t first = 0;
+        while (first < msgs.size() && msgs[first].ts < start) ref.applyUpdate(msgs[first++]);
+        size_t last = first;
+        while (last < msgs.size() && msgs[last].ts < end) ++last;
+
+        OrderBook    book(9'900, 10'100, 100'000);
+        FeedPosition pos;
+        ok = seek_feed(feed.c_str(), &index, start, book, pos);
+        assert(ok && pos.record == first);
+        check_same_book(ref, book);
+
+        auto window = collect([&](FeedHandler& fh) {
+            return run_mmap_replay_range(fh, feed.c_str(), pos, end);
+        });
+        assert(window.size() == last - first);
+        for (size_t i = 0; i < window.size(); ++i) assert(window[i].order_id == msgs[first + i].order_id
+                                                          && window[i].ts == msgs[first + i].ts);
+    }
+
+    // Record-number seeks, including onto a checkpoint entry itself.
+    for (uint64_t rec : {uint64_t{0}, uint64_t{1}, index.entries()[5].record, uint64_t{6'001},
+                         uint64_t(msgs.size())}) {
+        OrderBook ref(9'900, 10'100, 100'000);
+        for (uint64_t i = 0; i < rec; ++i) ref.applyUpdate(msgs[i]);
+        OrderBook    book(9'900, 10'100, 100'000);
+        FeedPosition pos;
+        ok = seek_feed_record(feed.c_str(), &index, rec, book, pos);
+        assert(ok && pos.record == rec);
+        check_same_book(ref, book);
+
+        std::vector<MarketUpdate> got;
+        FeedPosition next;
+        const uint64_t n = replay_feed_records(feed.c_str(), pos, 1'500,
+            [&](std::span<const MarketUpdate> run) {
+                got.insert(got.end(), run.begin(), run.end());
+                return true;
+            },
+            &next);
+        assert(n == got.size() && n == std::min<uint64_t>(1'500, msgs.size() - rec));
+        assert(next.record == rec + n);
+        for (size_t i = 0; i < got.size(); ++i) assert(got[i].order_id == msgs[rec + i].order_id);
+        if (rec + n < msgs.size()) {
+            got.clear();
+            replay_feed_records(feed.c_str(), next, 1,
+                [&](std::span<const MarketUpdate> run) {
+                    got.assign(run.begin(), run.end());
+                    return true;
+                });
+            assert(got.size() == 1 && got[0].ts == msgs[rec + n].ts
+                   && got[0].order_id == msgs[rec + n].order_id);
+        }
+    }
+
+    // A book configured differently cannot use the checkpoints: seek still
+    // works, by catching up from the start of the feed.
+    OrderBook    other(9'000, 11'000, 100'000);
+    FeedPosition pos;
+    ok = seek_feed(feed.c_str(), &index, msgs[5'000].ts, other, pos);
+    assert(ok && pos.record <= 5'000);
+    std::remove(idx.c_str());
+}
+
+void test_feed_index_seek() {
+    const auto msgs = make_live_book_feed(12'000);
+    const std::string raw = (std::filesystem::temp_directory_path() / "unit_index.bin").string();
+    const std::string cmp = (std::filesystem::temp_directory_path() / "unit_index.mdc").string();
+    {
+        std::ofstream out(raw, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(msgs.data()),
+                  (std::streamsize)(msgs.size() * sizeof(MarketUpdate)));
+        std::ofstream out2(cmp, std::ios::binary);
+        CompactFeedWriter w(out2, 700);   // entries land mid-block
+        for (const MarketUpdate& u : msgs) w.write(u);
+        w.finish();
+    }
+    check_index_seek(raw, msgs);
+    check_index_seek(cmp, msgs);
+
+    // No index: catch up from byte 0.
+    OrderBook    book(9'900, 10'100, 100'000);
+    FeedPosition pos;
+    bool ok = seek_feed(raw.c_str(), nullptr, msgs[3'000].ts, book, pos);
+    assert(ok);
+    assert(msgs[pos.record].ts >= msgs[3'000].ts && msgs[pos.record - 1].ts < msgs[3'000].ts);
+
+    std::remove(raw.c_str());
+    std::remove(cmp.c_str());
+    std::cout << "test_feed_index_seek passed\n";
+}
+
+// ---------------------------------------------------------------------------
+// Segmented backtest: parallel segments reconcile to the serial result
+// ---------------------------------------------------------------------------
+static void check_same_result(const BacktestResult& a, const BacktestResult& b) {
+    assert(a.state == b.state);
+    assert(a.total_pnl == b.total_pnl);
+    assert(a.updates == b.updates);
+    assert(a.signals.size() == b.signals.size());
+    for (size_t i = 0; i < a.signals.size(); ++i) {
+        assert(a.signals[i].price == b.signals[i].price && a.signals[i].qty == b.signals[i].qty);
+    }
+}
+
+void test_segmented_backtest_matches_serial() {
+    const auto msgs = make_live_book_feed(20'000);
+    const std::string feed = (std::filesystem::temp_directory_path() / "unit_segments.mdc").string();
+    const std::string idx  = feed + ".idx";
+    {
+        std::ofstream out(feed, std::ios::binary);
+        CompactFeedWriter w(out, 700);
+        for (const MarketUpdate& u : msgs) w.write(u);
+        w.finish();
+    }
+    FeedIndexOptions iopts;
+    iopts.interval_ns      = 200'000;
+    iopts.checkpoint_every = 5;
+    iopts.book             = {9'900, 10'100, 100'000, OrderIdIndex::Dense};
+    bool ok = build_feed_index(feed.c_str(), idx.c_str(), iopts);
+    assert(ok);
+    FeedIndex index(idx.c_str());
+    assert(index.ok());
+
+    RiskManager     risk(20'000, 10);
+    BacktestOptions opts;
+    opts.ema_alpha = 0.3;    // trade often, so segments inherit open positions
+    opts.threshold = 0.05;
+    const BacktestResult serial = run_serial_backtest(feed.c_str(), iopts.book, risk, opts);
+    assert(serial.updates == msgs.size());
+    assert(serial.state.signals_emitted > 20 && serial.state.position != 0);
+    assert(serial.signals.size() == serial.state.signals_emitted);
+
+    // No warmup: segments start from a fresh strategy, every one is
+    // replayed again over its top-of-book stream, up to a sync point where
+    // the parallel run caught up.
+    opts.segments       = 5;
+    opts.warmup_records = 0;
+    opts.sync_records   = 256;
+    BacktestResult r = run_segmented_backtest(feed.c_str(), index, risk, opts);
+    assert(r.segments == 5 && r.reruns == 4);
+    assert(r.rerun_records < msgs.size() * 4 / 5);
+    check_same_result(r, serial);
+
+    // Without sync points the replays run to the end of each segment.
+    opts.sync_records = 0;
+    r = run_segmented_backtest(feed.c_str(), index, risk, opts);
+    assert(r.reruns == 4 && r.rerun_records == msgs.size() - msgs.size() / 5);
+    check_same_result(r, serial);
+    opts.sync_records = 256;
+
+    // With a warmup the EMA converges before the boundary and the parallel
+    // results are used as they are.
+    opts.warmup_records = 2'000;
+    r = run_segmented_backtest(feed.c_str(), index, risk, opts);
+    assert(r.segments == 5 && r.reruns < 4);
+    check_same_result(r, serial);
+
+    opts.segments = 1;
+    r = run_segmented_backtest(feed.c_str(), index, risk, opts);
+    assert(r.segments == 1);
+    check_same_result(r, serial);
+
+    std::remove(feed.c_str());
+    std::remove(idx.c_str());
+    std::cout << "test_segmented_backtest_matches_serial passed\n";
+}
+
+// ---------------------------------------------------------------------------
+// Parameter sweep: every row equals a serial backtest of that configuration
+// ---------------------------------------------------------------------------
+void test_work_stealing_pool_runs_each_task_once() {
+    WorkStealingPool pool(3);
+    std::vector<std::atomic<int>> runs(100);
+    pool.run(runs.size(), [&](size_t task, size_t worker) {
+        assert(worker < pool.size());
+        runs[task].fetch_add(1);
+    });
+    for (const auto& r : runs) assert(r.load() == 1);
+
+    // Fewer tasks than workers, and none at all.
+    std::atomic<int> total{0};
+    pool.run(2, [&](size_t, size_t) { total.fetch_add(1); });
+    assert(total.load() == 2);
+    pool.run(0, [&](size_t, size_t) { assert(false); });
+    std::cout << "test_work_stealing_pool_runs_each_task_once passed\n";
+}
+
+void test_param_sweep_matches_serial() {
+    const auto msgs = make_live_book_feed(20'000);
+    const std::string feed = (std::filesystem::temp_directory_path() / "unit_sweep.mdc").string();
+    {
+        std::ofstream out(feed, std::ios::binary);
+        CompactFeedWriter w(out, 700);
+        for (const MarketUpdate& u : msgs) w.write(u);
+        w.finish();
+    }
+    const IndexBookConfig book{9'900, 10'100, 100'000, OrderIdIndex::Dense};
+    TopOfBookStream stream;
+    bool ok = build_top_of_book_stream(feed.c_str(), book, 5, stream);
+    assert(ok);
+    assert(stream.updates == msgs.size());
+    assert(!stream.runs.empty() && stream.runs.size() < msgs.size());
+
+    const auto grid = make_sweep_grid({0.05, 0.1, 0.3}, {0.05, 0.2, 0.5, 0.9});
+    assert(grid.size() == 12 && grid[4].ema_alpha == 0.1 && grid[4].threshold == 0.05);
+
+    SweepOptions sopts;
+    sopts.threads = 3;
+    sopts.block   = 5;      // last block short
+    SweepStats stats;
+    const SweepResults res = run_param_sweep(stream, grid, sopts, &stats);
+    assert(res.rows() == grid.size());
+    assert(stats.threads == 3 && stats.tasks == 3);
+
+    RiskManager risk(20'000, 10);
+    bool any_trades = false;
+    for (size_t i = 0; i < grid.size(); ++i) {
+        BacktestOptions opts;
+        opts.ema_alpha = grid[i].ema_alpha;
+        opts.threshold = grid[i].threshold;
+        const BacktestResult serial = run_serial_backtest(feed.c_str(), book, risk, opts);
+        assert(res.ema_alpha[i] == grid[i].ema_alpha && res.threshold[i] == grid[i].threshold);
+        assert(res.ticks[i] == serial.state.ticks);
+        assert(res.signals[i] == serial.state.signals_emitted);
+        assert(res.round_trips[i] == serial.state.round_trips);
+        assert(res.realized_pnl[i] == serial.state.realized_pnl);
+        assert(res.ema[i] == serial.state.ema);
+        assert(res.total_pnl[i] == serial.total_pnl);
+        any_trades |= res.signals[i] > 0;
+    }
+    assert(any_trades);
+
+    // Thread count, block size and strategy form do not change the result.
+    sopts.threads = 1;
+    sopts.block   = 1;
+    const SweepResults one = run_param_sweep(stream, grid, sopts);
+    assert(one.total_pnl == res.total_pnl && one.signals == res.signals);
+    sopts.block   = 12;
+    sopts.batched = false;
+    const SweepResults per_config = run_param_sweep(stream, grid, sopts);
+    assert(per_config.ticks == res.ticks && per_config.signals == res.signals);
+    assert(per_config.round_trips == res.round_trips);
+    assert(per_config.realized_pnl == res.realized_pnl);
+    assert(per_config.total_pnl == res.total_pnl && per_config.ema == res.ema);
+
+    ok = build_top_of_book_stream("/nonexistent/feed.bin", book, 5, stream);
+    assert(!ok);
+    std::remove(feed.c_str());
+    std::cout << "test_param_sweep_matches_serial passed\n";
+}
+
+void test_batch_strategy_matches_scalar() {
+    // 37 configurations: full AVX-512 groups, a tail group and padding.
+    // Negative thresholds signal on both sides at once (buy wins).
+    std::vector<double> alphas, thresholds;
+    for (int i = 0; i < 37; ++i) {
+        alphas.push_back(0.01 + 0.6 * (i % 7) / 6.0);
+        thresholds.push_back(-0.1 + 0.05 * (i % 11));
+    }
+    using Isa = BatchImbalanceStrategy::Isa;
+    for (Isa isa : {Isa::Scalar, Isa::Avx2, Isa::Avx512}) {
+        if (isa > BatchImbalanceStrategy::cpuBest()) continue;
+        BatchImbalanceStrategy batch(alphas.data(), thresholds.data(), alphas.size(), isa);
+        assert(batch.isa() == isa && batch.size() == alphas.size());
+        std::vector<ImbalanceStrategy> ref;
+        for (size_t i = 0; i < alphas.size(); ++i) ref.emplace_back(alphas[i], thresholds[i]);
+
+        std::mt19937_64 rng(5);
+        for (int step = 0; step < 3'000; ++step) {
+            const int64_t bid = 9'990 + (int64_t)(rng() % 20), ask = bid + 1 + (int64_t)(rng() % 5);
+            const int64_t bq = (int64_t)(rng() % 100), aq = (int64_t)(rng() % 100);
+            const bool two_sided = rng() % 16 != 0;          // sometimes no valid top
+            const uint32_t ticks = (uint32_t)(rng() % 40);   // including none
+            batch.on_top(two_sided, bid, ask, bq, aq);
+            batch.on_ticks(ticks);
+            for (ImbalanceStrategy& r : ref) {
+                r.on_top(two_sided, bid, ask, bq, aq);
+                for (uint32_t k = 0; k < ticks; ++k) r.on_tick();
+            }
+        }
+        uint64_t signals = 0;
+        for (size_t i = 0; i < alphas.size(); ++i) {
+            assert(batch.state(i) == ref[i].state());
+            signals += ref[i].state().signals_emitted;
+        }
+        assert(signals > 1'000);
+    }
+    std::cout << "test_batch_strategy_matches_scalar passed\n";
+}
+
+// ---------------------------------------------------------------------------
+int main() {
+    test_mmap_replay_reads_all_records();
+    test_uring_replay_matches_mmap();
+    test_replay_missing_file();
+
+    test_parse_batch_in_place();
+    test_on_batch_routes_like_on_update();
+
+    test_compact_round_trip();
+    test_compact_replay_matches_raw();
+    test_compact_decode_in_place();
+
+    test_merge_replay_orders_by_ts();
+
+    test_feed_index_seek();
+    test_segmented_backtest_matches_serial();
+
+    test_work_stealing_pool_runs_each_task_once();
+    test_param_sweep_matches_serial();
+    test_batch_strategy_matches_scalar();
+
+    std::cout << "\nAll replay tests passed\n";
+    return 0;
+}
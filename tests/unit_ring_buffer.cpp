@@ -1,8 +1,25 @@
+#include "../src/core/broadcast_ring.hpp"
+#include "../src/core/mpsc_ring.hpp"
 #include "../src/core/ring_buffer.hpp"
+#include "../src/core/shm_ring.hpp"
+#include "../src/core/wait_strategy.hpp"
+#include "../src/engine/broadcast_dispatcher.hpp"
+#include "../src/engine/imbalance_strategy.hpp"
+#include "../src/feed/feed_handler.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <iostream>
+#include <span>
 #include <thread>
 #include <vector>
 #include <cassert>
+#include <string>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 
 int main() {
@@ -21,6 +38,532 @@ int main() {
   }
   assert(ring.empty());
 
+  // bulk push: wraps the end of the buffer, stops at capacity
+  {
+    std::vector<uint64_t> items(CAP + 10);
+    for (size_t i = 0; i < items.size(); ++i) items[i] = 5000 + i;
+    size_t n = ring.push_bulk(items.data(), 100);   // head is at 1000: wraps at 1024
+    assert(n == 100);
+    n = ring.push_bulk(items.data() + 100, items.size() - 100);
+    assert(n == CAP - 100);
+    n = ring.push_bulk(items.data(), 1);
+    assert(n == 0);
+    for (size_t i = 0; i < CAP; ++i) {
+      uint64_t v = 0;
+      bool ok = ring.pop(v);
+      assert(ok && v == 5000 + i);
+    }
+    assert(ring.empty());
+  }
+
+  // bulk pop: wraps the end of the buffer, stops at what is available
+  {
+    std::vector<uint64_t> items(CAP);
+    for (size_t i = 0; i < items.size(); ++i) items[i] = 9000 + i;
+    size_t n = ring.push_bulk(std::span<const uint64_t>(items.data(), 300));   // tail at 1000
+    assert(n == 300);
+    std::vector<uint64_t> out(CAP);
+    n = ring.pop_bulk(std::span<uint64_t>(out.data(), 50));
+    assert(n == 50);
+    n = ring.pop_bulk(out);   // wraps at 1024
+    assert(n == 250);
+    for (size_t i = 0; i < 250; ++i) assert(out[i] == 9050 + i);
+    n = ring.pop_bulk(out);
+    assert(n == 0);
+    assert(ring.empty());
+  }
+
+  // claim/commit and peek/release: spans stop at the end of the buffer
+  {
+    SpscRing<uint64_t> r(16);
+    for (uint64_t i = 0; i < 12; ++i) {
+      uint64_t v;
+      bool ok = r.push(i) && r.pop(v);
+      assert(ok);
+    }
+    assert(r.claim_limit() == 4);
+    auto w = r.claim(10);              // write position 12: 4 slots to the end
+    assert(w.size() == 4);
+    for (size_t i = 0; i < w.size(); ++i) w[i] = 100 + i;
+    r.commit(3);                       // publish only 3
+    assert(r.size() == 3);
+    w = r.claim(10);                   // slot 15 again, still holding 103
+    assert(w.size() == 1 && w[0] == 103);
+    r.commit(1);
+    w = r.claim(20);                   // wrapped: 16 - 4 in flight = 12 free
+    assert(w.size() == 12 && r.claim_limit() == 16);
+    for (size_t i = 0; i < w.size(); ++i) w[i] = 200 + i;
+    r.commit(12);
+    w = r.claim(1);
+    assert(w.empty());                 // full
+
+    auto rd = r.peek(100);             // 12..15, stops at the end
+    assert(rd.size() == 4 && rd[0] == 100 && rd[3] == 103);
+    r.release(1);
+    rd = r.peek(100);
+    assert(rd.size() == 3 && rd[0] == 101);
+    r.release(3);
+    rd = r.peek(4);
+    assert(rd.size() == 4 && rd[0] == 200);
+    r.release(4);
+    rd = r.peek(100);
+    assert(rd.size() == 8 && rd[7] == 211);
+    r.release(8);
+    rd = r.peek(1);
+    assert(rd.empty() && r.empty());
+  }
+
+  // claim/peek producer/consumer threads
+  {
+    SpscRing<uint64_t> small(64);
+    constexpr uint64_t M = 500000;
+    std::thread prod([&] {
+      uint64_t next = 1;
+      while (next <= M) {
+        auto w = small.claim(std::min<uint64_t>(29, M - next + 1));
+        if (w.empty()) { std::this_thread::yield(); continue; }
+        for (uint64_t& slot : w) slot = next++;
+        small.commit(w.size());
+      }
+    });
+    std::thread cons([&] {
+      uint64_t expected = 1;
+      while (expected <= M) {
+        auto rd = small.peek(17);
+        if (rd.empty()) { std::this_thread::yield(); continue; }
+        for (uint64_t v : rd) {
+          assert(v == expected);
+          ++expected;
+        }
+        small.release(rd.size());
+      }
+    });
+    prod.join();
+    cons.join();
+    assert(small.empty());
+  }
+
+  // bulk producer/consumer threads: the cached remote indices must still
+  // see every refresh, across many wraps.
+  {
+    SpscRing<uint64_t> small(64);
+    constexpr uint64_t M = 500000;
+    std::thread prod([&] {
+      uint64_t buf[37];
+      uint64_t next = 1;
+      while (next <= M) {
+        const size_t want = std::min<uint64_t>(37, M - next + 1);
+        for (size_t i = 0; i < want; ++i) buf[i] = next + i;
+        size_t done = 0;
+        while (done < want) {
+          const size_t k = small.push_bulk(buf + done, want - done);
+          if (k == 0) std::this_thread::yield();   // full: let the consumer run
+          done += k;
+        }
+        next += want;
+      }
+    });
+    std::thread cons([&] {
+      uint64_t buf[23];
+      uint64_t expected = 1;
+      while (expected <= M) {
+        const size_t n = small.pop_bulk(buf);
+        if (n == 0) std::this_thread::yield();
+        for (size_t i = 0; i < n; ++i, ++expected) assert(buf[i] == expected);
+      }
+    });
+    prod.join();
+    cons.join();
+    assert(small.empty());
+  }
+
+  // MPSC: bulk push wraps, peek stops at the end of the buffer
+  {
+    MpscRing<uint64_t> r(16);
+    for (uint64_t i = 0; i < 12; ++i) {
+      uint64_t v = 0;
+      bool ok = r.push(i) && r.pop(v);
+      assert(ok && v == i);
+    }
+    std::vector<uint64_t> items(20);
+    for (size_t i = 0; i < items.size(); ++i) items[i] = 300 + i;
+    size_t n = r.push_bulk(items.data(), 3);
+    assert(n == 3);
+    n = r.push_bulk(std::span<const uint64_t>(items.data() + 3, 17));
+    assert(n == 13);                   // full at 16
+    bool ok = r.push(1);
+    assert(!ok && r.size() == 16);
+    auto rd = r.peek(100);             // 12..15
+    assert(rd.size() == 4 && rd[0] == 300 && rd[3] == 303);
+    r.release(4);
+    std::vector<uint64_t> out(32);
+    n = r.pop_bulk(out);
+    assert(n == 12);
+    for (size_t i = 0; i < 12; ++i) assert(out[i] == 304 + i);
+    n = r.pop_bulk(out);
+    rd = r.peek(1);
+    assert(n == 0 && rd.empty() && r.empty());
+  }
+
+  // MPSC fan-in: several FeedHandlers on their own threads into one ring;
+  // each producer's updates arrive complete and in order.
+  {
+    constexpr size_t   P = 4;
+    constexpr uint64_t M = 100000;   // per producer
+    MdFanInQueue fan_in(1024);
+    std::vector<std::thread> producers;
+    for (size_t p = 0; p < P; ++p) {
+      producers.emplace_back([&fan_in, p] {
+        FeedHandler fh(fan_in);
+        MarketUpdate batch[13];
+        uint64_t next = 1;
+        while (next <= M) {
+          const size_t n = std::min<uint64_t>(13, M - next + 1);
+          for (size_t i = 0; i < n; ++i) {
+            batch[i] = MarketUpdate{};
+            batch[i].symbol_id = static_cast<uint16_t>(p);
+            batch[i].order_id  = next++;
+          }
+          if (p == 0 && n == 13) {
+            for (size_t i = 0; i < n; ++i) while (!fh.onUpdate(batch[i])) std::this_thread::yield();
+          } else {
+            fh.onBatch(std::span<const MarketUpdate>(batch, n));
+          }
+          const auto claimed = fh.claim(1);
+          assert(claimed.empty());
+        }
+      });
+    }
+    uint64_t last[P] = {};
+    uint64_t total = 0;
+    MarketUpdate buf[50];
+    while (total < P * M) {
+      const size_t n = fan_in.pop_bulk(buf);
+      if (n == 0) std::this_thread::yield();
+      for (size_t i = 0; i < n; ++i) {
+        assert(buf[i].symbol_id < P && buf[i].order_id == last[buf[i].symbol_id] + 1);
+        last[buf[i].symbol_id] = buf[i].order_id;
+      }
+      total += n;
+    }
+    for (auto& t : producers) t.join();
+    assert(fan_in.empty());
+  }
+
+  // Broadcast: every reader sees every item; the writer waits for the slowest
+  {
+    BroadcastRing<uint64_t> r(16, 3);
+    std::vector<uint64_t> items(20);
+    for (size_t i = 0; i < items.size(); ++i) items[i] = 700 + i;
+    size_t n = r.push_bulk(items.data(), 12);
+    assert(n == 12);
+    for (size_t k = 0; k < 3; ++k) {
+      auto rd = r.peek(k, 100);
+      assert(rd.size() == 12 && rd[0] == 700 && rd[11] == 711);
+    }
+    r.release(0, 12);
+    r.release(1, 12);
+    r.release(2, 5);                    // slowest reader holds slots 5..11
+    assert(r.claim_limit() == 4);
+    auto w = r.claim(10);               // 4 to the end of the buffer
+    assert(w.size() == 4);
+    for (size_t i = 0; i < w.size(); ++i) w[i] = 712 + i;
+    r.commit(4);
+    n = r.push_bulk(items.data() + 16, 4);   // wraps into slots 0..3
+    assert(n == 4);
+    bool ok = r.push(720);
+    assert(ok);
+    ok = r.push(0);
+    assert(!ok);                        // 5 slots were free past the slowest reader
+    assert(r.size(0) == 9 && r.size(2) == 16);
+    auto rd = r.peek(2, 100);           // 5..15, stops at the end
+    assert(rd.size() == 11 && rd[0] == 705 && rd[10] == 715);
+    r.release(2, 11);
+    rd = r.peek(2, 100);
+    assert(rd.size() == 5 && rd[0] == 716 && rd[3] == 719 && rd[4] == 720);
+    r.release(2, 5);
+    assert(r.empty(2) && !r.empty(0));
+  }
+
+  // Broadcast threads: a FeedHandler writing, three readers at their own pace
+  {
+    constexpr size_t   R = 3;
+    constexpr uint64_t M = 300000;
+    MdBroadcast ring(64, R);
+    std::vector<std::thread> readers;
+    for (size_t k = 0; k < R; ++k) {
+      readers.emplace_back([&ring, k] {
+        uint64_t expected = 1;
+        while (expected <= M) {
+          auto rd = ring.peek(k, 7 + 10 * k);
+          if (rd.empty()) { std::this_thread::yield(); continue; }
+          for (const MarketUpdate& u : rd) {
+            assert(u.order_id == expected);
+            ++expected;
+          }
+          ring.release(k, rd.size());
+        }
+      });
+    }
+    FeedHandler fh(ring);
+    MarketUpdate batch[16];
+    uint64_t next = 1;
+    while (next <= M) {
+      if (next % 3 == 0) {
+        auto w = fh.claim(5);           // empty near the end of the buffer
+        if (!w.empty()) {
+          for (MarketUpdate& u : w) { u = MarketUpdate{}; u.order_id = next++; }
+          fh.commit(w.size());
+          continue;
+        }
+      }
+      const size_t n = std::min<uint64_t>(16, M - next + 1);
+      for (size_t i = 0; i < n; ++i) { batch[i] = MarketUpdate{}; batch[i].order_id = next++; }
+      size_t done = 0;
+      while (done < n) {
+        const size_t k = ring.push_bulk(batch + done, n - done);
+        if (k == 0) std::this_thread::yield();
+        done += k;
+      }
+    }
+    for (auto& t : readers) t.join();
+    for (size_t k = 0; k < R; ++k) assert(ring.empty(k));
+  }
+
+  // BroadcastDispatcher: each reader's book and strategy end up as if it
+  // had replayed the feed alone.
+  {
+    constexpr size_t R = 3;
+    std::vector<MarketUpdate> feed;
+    uint64_t seed = 12345;
+    auto rnd = [&] { seed = seed * 6364136223846793005ull + 1442695040888963407ull; return seed >> 33; };
+    for (uint64_t i = 1; i <= 20000; ++i) {
+      MarketUpdate u{};
+      u.type     = static_cast<UpdateType>(rnd() % 3);
+      u.side     = static_cast<OrderSide>(rnd() % 2);
+      u.order_id = (u.type == UpdateType::Add) ? i : 1 + rnd() % i;
+      u.price    = 10000 + static_cast<int64_t>(rnd() % 21) - 10;
+      u.qty      = 1 + static_cast<int64_t>(rnd() % 50);
+      feed.push_back(u);
+    }
+    auto make_book = [] {
+      auto b = std::make_unique<OrderBook>(9900, 10100, 30000);
+      b->enableFeatures(5);
+      return b;
+    };
+
+    uint64_t expected_signals[R];
+    std::unique_ptr<OrderBook> serial_books[R];
+    for (size_t k = 0; k < R; ++k) {
+      serial_books[k] = make_book();
+      ImbalanceStrategy s(*serial_books[k], 0.3, 0.05 + 0.1 * k);
+      StrategySignal sig;
+      expected_signals[k] = 0;
+      for (const MarketUpdate& u : feed) {
+        serial_books[k]->applyUpdate(u);
+        s.on_market_update(u);
+        while (s.poll_signal(sig)) ++expected_signals[k];
+      }
+    }
+
+    BroadcastDispatcher dispatcher(R, 256);
+    std::unique_ptr<OrderBook>         books[R];
+    std::unique_ptr<ImbalanceStrategy> strategies[R];
+    for (size_t k = 0; k < R; ++k) {
+      books[k]      = make_book();
+      strategies[k] = std::make_unique<ImbalanceStrategy>(*books[k], 0.3, 0.05 + 0.1 * k);
+      dispatcher.addReader(*books[k], *strategies[k]);
+    }
+    dispatcher.start();
+    for (size_t i = 0; i < feed.size(); i += 100) {
+      dispatcher.feedHandler().onBatch(
+          std::span<const MarketUpdate>(feed.data() + i, std::min<size_t>(100, feed.size() - i)));
+    }
+    dispatcher.finish();
+    for (size_t k = 0; k < R; ++k) {
+      assert(dispatcher.consumed(k) == feed.size());
+      assert(dispatcher.signals(k) == expected_signals[k]);
+      PriceLevel a, b;
+      assert(books[k]->getBestBid(a) == serial_books[k]->getBestBid(b));
+      assert(a.price == b.price && a.total_qty == b.total_qty);
+      assert(books[k]->getBestAsk(a) == serial_books[k]->getBestAsk(b));
+      assert(a.price == b.price && a.total_qty == b.total_qty);
+    }
+    assert(expected_signals[0] > expected_signals[R - 1]);
+  }
+
+  // Parking consumer: sleeps on the doorbell (long timeout, so progress
+  // depends on the producer's wakeups) and sees every item
+  {
+    SpscRing<uint64_t> r(64);
+    Doorbell bell;
+    r.set_doorbell(&bell);
+    bool ok = r.push(0);
+    assert(ok && bell.wakeups() == 0);    // nobody parked: no wake
+    uint64_t v;
+    ok = r.pop(v);
+    assert(ok);
+
+    constexpr uint64_t M = 2000;
+    std::atomic<bool> done{false};
+    std::thread cons([&] {
+      WaitStrategy::Options o;
+      o.kind         = WaitStrategy::Kind::Park;
+      o.spin_limit   = 0;
+      o.park_timeout = std::chrono::seconds(10);
+      WaitStrategy wait(o, &bell);
+      uint64_t expected = 1;
+      while (true) {
+        uint64_t x;
+        if (r.pop(x)) {
+          assert(x == expected);
+          ++expected;
+          wait.reset();
+          continue;
+        }
+        if (done.load(std::memory_order_acquire) && r.empty()) break;
+        wait.idle([&] { return !r.empty() || done.load(std::memory_order_acquire); });
+      }
+      assert(expected == M + 1);
+    });
+    for (uint64_t i = 1; i <= M; ++i) {
+      while (!r.push(i)) std::this_thread::yield();
+      if (i % 100 == 0) std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    done.store(true, std::memory_order_release);
+    bell.ring();
+    cons.join();
+    assert(bell.wakeups() > 0);
+  }
+
+  // End of stream: items published before close() are still delivered;
+  // reset() reopens the ring
+  {
+    SpscRing<uint64_t> r(8);
+    assert(!r.closed());
+    bool ok = r.push(1) && r.push(2);
+    assert(ok);
+    r.close();
+    assert(r.closed());
+    uint64_t v;
+    ok = r.pop(v);
+    assert(ok && v == 1);
+    ok = r.pop(v);
+    assert(ok && v == 2);
+    ok = r.pop(v);
+    assert(!ok && r.closed());
+    r.reset();
+    assert(!r.closed());
+  }
+
+#ifndef _WIN32
+  // Shared-memory ring: one consumer at a time, detach and resume
+  {
+    const std::string name = "/unit_shm_ring_" + std::to_string(::getpid());
+    bool attached = ShmRing::attach(name.c_str()).ok();
+    assert(!attached);                                    // not created yet
+    ShmRing prod = ShmRing::create(name.c_str(), 16);
+    assert(prod.ok() && prod.isProducer() && prod.capacity() == 16);
+    assert(prod.header().record_size == sizeof(MarketUpdate));
+    assert(prod.header().version == ShmRingHeader::VERSION);
+
+    MarketUpdate items[20] = {};
+    for (uint64_t i = 0; i < 20; ++i) items[i].order_id = 1 + i;
+    size_t n = prod.push_bulk(items, 10);
+    assert(n == 10);
+
+    ShmRing cons = ShmRing::attach(name.c_str());
+    assert(cons.ok() && !cons.isProducer() && prod.consumerAttached());
+    attached = ShmRing::attach(name.c_str()).ok();
+    assert(!attached);                                    // second consumer refused
+    auto rd = cons.peek(4);
+    assert(rd.size() == 4 && rd[0].order_id == 1);
+    cons.release(4);
+    cons.detach();
+    assert(!cons.ok() && !prod.consumerAttached());
+
+    cons = ShmRing::attach(name.c_str());                 // resumes at the tail
+    MarketUpdate out[16];
+    n = cons.pop_bulk(out);
+    assert(n == 6 && out[0].order_id == 5 && out[5].order_id == 10);
+    n = prod.push_bulk(items + 10, 10);                   // wraps
+    assert(n == 10);
+    cons.detach();
+    cons = ShmRing::attach(name.c_str(), ShmRing::Resume::Latest);
+    assert(cons.empty());
+    auto w = prod.claim(16);                              // stops at the end of the buffer
+    assert(w.size() == 12);
+    w[0].order_id = 99;
+    prod.commit(1);
+    MarketUpdate u;
+    bool ok = cons.pop(u);
+    assert(ok && u.order_id == 99);
+    ok = cons.pop(u);
+    assert(!ok);
+    assert(!cons.closed());
+    prod.close();
+    assert(cons.closed());
+  }
+
+  // Shared-memory ring across processes, including a consumer that exits
+  // without detaching
+  {
+    const std::string name = "/unit_shm_xproc_" + std::to_string(::getpid());
+    ShmRing prod = ShmRing::create(name.c_str(), 64);
+    assert(prod.ok());
+
+    pid_t crashed = ::fork();
+    if (crashed == 0) {
+      ShmRing c = ShmRing::attach(name.c_str());
+      ::_exit(c.ok() ? 0 : 1);                            // no detach
+    }
+    int status = 0;
+    ::waitpid(crashed, &status, 0);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0 && prod.consumerAttached());
+
+    constexpr uint64_t M = 200000;
+    pid_t child = ::fork();
+    if (child == 0) {
+      ShmRing c = ShmRing::attach(name.c_str());          // takes over from the dead pid
+      if (!c.ok()) ::_exit(1);
+      uint64_t expected = 1;
+      while (true) {
+        auto batch = c.peek(25);
+        if (batch.empty()) {
+          if (c.closed() && c.empty()) break;
+          ::sched_yield();
+          continue;
+        }
+        for (const MarketUpdate& m : batch) {
+          if (m.order_id != expected++) ::_exit(2);
+        }
+        c.release(batch.size());
+      }
+      c.detach();
+      ::_exit(expected == M + 1 ? 0 : 3);
+    }
+    FeedHandler fh(prod);
+    MarketUpdate batch[40] = {};
+    uint64_t next = 1;
+    while (next <= M) {
+      const size_t n = std::min<uint64_t>(40, M - next + 1);
+      for (size_t i = 0; i < n; ++i) batch[i].order_id = next++;
+      size_t done = 0;
+      while (done < n) {
+        // Alternate single updates through the handler and bulk pushes.
+        const size_t k = (done % 2) ? (fh.onUpdate(batch[done]) ? 1 : 0)
+                                    : prod.push_bulk(batch + done, n - done);
+        if (k == 0) ::sched_yield();
+        done += k;
+      }
+    }
+    prod.close();
+    ::waitpid(child, &status, 0);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    assert(!prod.consumerAttached() && prod.empty());
+  }
+#endif
+
   // producer/consumer threads
   constexpr size_t N = 1000000;
   std::thread prod([&](){